@@ -0,0 +1,91 @@
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "../Interface_Graphique/Solver/src/geoserializer.h"
+
+/*
+ * GeoSerializer::string2coordinate against its former regex based implementation,
+ * on the coordinates of a map (aerodromes.csv by default). Both must return the
+ * same values.
+ *
+ * usage: bench_coordinates [map.csv]
+ */
+
+namespace {
+
+// string2coordinate is protected, only the serializers use it
+struct CoordinateParser : GeoSerializer {
+    using GeoSerializer::string2coordinate;
+};
+
+// the implementation string2coordinate replaced
+double regexString2coordinate(const std::string &str)
+{
+    if (!std::regex_match(str, std::regex("^[0-9]{1,3}:[0-9]{1,2}\\.[0-9]*[NSWE]$")))
+    {
+        throw std::invalid_argument("Invalid coordinate string (" + str + ")");
+    }
+
+    std::string degrees = str.substr(0, str.find(":"));
+    std::string minutes = str.substr(str.find(":") + 1);
+    std::string direction = minutes.substr(minutes.size() - 1);
+    minutes.pop_back();
+
+    double result = std::stod(degrees) + std::stod(minutes) / 60;
+
+    if (direction == "W" || direction == "O" || direction == "S")
+    {
+        result = -result;
+    }
+
+    return result;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    constexpr size_t RUNS = 5;
+
+    // the latitude and longitude fields of every row
+    std::ifstream source{ benchmark::mapFile(argc, argv), std::ios::binary };
+    if (!source)
+        throw std::runtime_error("Could not open the source map");
+    std::vector<std::string> coordinates;
+    std::string row;
+    std::getline(source, row); // header
+    while (std::getline(source, row)) {
+        std::stringstream fields{ row };
+        std::string field;
+        for (int column = 1; std::getline(fields, field, ';'); column++) {
+            if (column == LATITUDE_COLUMN || column == LONGITUDE_COLUMN)
+                coordinates.push_back(field);
+        }
+    }
+
+    for (const std::string &coordinate : coordinates) {
+        if (CoordinateParser::string2coordinate(coordinate) != regexString2coordinate(coordinate)) {
+            std::cerr << "Different values for " << coordinate << std::endl;
+            return 1;
+        }
+    }
+
+    volatile double sink = 0;
+    double regexMs = benchmark::medianMs(RUNS, [&] {
+        for (const std::string &coordinate : coordinates)
+            sink = sink + regexString2coordinate(coordinate);
+    });
+    double parserMs = benchmark::medianMs(RUNS, [&] {
+        for (const std::string &coordinate : coordinates)
+            sink = sink + CoordinateParser::string2coordinate(coordinate);
+    });
+
+    std::cout << coordinates.size() << " coordinates, median of " << RUNS << " runs" << std::endl;
+    std::cout << "regex              " << regexMs * 1e6 / coordinates.size() << "ns/coordinate" << std::endl;
+    std::cout << "string2coordinate  " << parserMs * 1e6 / coordinates.size() << "ns/coordinate" << std::endl;
+}
@@ -0,0 +1,52 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "../Interface_Graphique/Solver/src/geoserializer/csvserializer.h"
+
+/*
+ * Parse throughput of CSVSerializer::parseMap.
+ *
+ * The rows of the map (aerodromes.csv by default) are repeated into a temporary
+ * file of the requested size, 1M rows by default, which is then parsed.
+ *
+ * usage: bench_csv [map.csv] [rows]
+ */
+int main(int argc, char **argv)
+{
+    constexpr size_t RUNS = 5;
+    const size_t rowCount = argc > 2 ? std::stoull(argv[2]) : 1'000'000;
+
+    // read the header and the rows of the source map
+    std::ifstream source{ benchmark::mapFile(argc, argv), std::ios::binary };
+    if (!source)
+        throw std::runtime_error("Could not open the source map");
+    std::string header;
+    std::getline(source, header);
+    std::vector<std::string> rows;
+    for (std::string row; std::getline(source, row);) {
+        if (!row.empty())
+            rows.push_back(std::move(row));
+    }
+    if (rows.empty())
+        throw std::runtime_error("The source map has no rows");
+
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "flightpath_bench_csv.csv";
+    {
+        std::ofstream out{ file, std::ios::binary };
+        out << header << '\n';
+        for (size_t i = 0; i < rowCount; i++)
+            out << rows[i % rows.size()] << '\n';
+    }
+    const double megabytes = std::filesystem::file_size(file) / 1e6;
+
+    size_t stationCount = 0;
+    double parseMs = benchmark::medianMs(RUNS, [&] { stationCount = CSVSerializer{}.parseMap(file).getStations().size(); });
+    std::filesystem::remove(file);
+
+    std::cout << stationCount << " stations, " << megabytes << "MB, median of " << RUNS << " runs" << std::endl;
+    std::cout << "parse       " << parseMs << "ms" << std::endl;
+    std::cout << "throughput  " << megabytes / parseMs * 1000 << "MB/s, " << stationCount / parseMs * 1000 << " stations/s" << std::endl;
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "benchmark.h"
+#include "../Interface_Graphique/Solver/src/geoserializer/csvserializer.h"
+#include "../Interface_Graphique/Solver/src/tsp/tsp_nearest_multistart_opt.h"
+
+/*
+ * Wall-clock time of the multistart tsp solver on a map, aerodromes.csv by default.
+ *
+ * The solver builds the distance matrix once per solve and shares it between its
+ * threads, it used to build one per start station. The cycle configurations are
+ * also timed with that former behaviour, rebuilding the matrix in the start loop,
+ * the rest of the work being the same.
+ *
+ * usage: bench_tsp [map.csv] [threads]
+ */
+
+// the nearest neighbour path from start, as built by the solver from each start station
+static ProblemPath nearestNeighbourPath(const StationDistanceMatrix &distances, size_t start)
+{
+    std::vector<size_t> remainingStations(distances.size());
+    std::iota(remainingStations.begin(), remainingStations.end(), 0);
+    remainingStations.erase(remainingStations.begin() + start);
+
+    ProblemPath path{ (problemidx_t)start };
+    while (!remainingStations.empty()) {
+        size_t nearestPosition = 0;
+        for (size_t position = 1; position < remainingStations.size(); position++)
+            if (distances(path.back(), remainingStations[position]) < distances(path.back(), remainingStations[nearestPosition]))
+                nearestPosition = position;
+        path.push_back((problemidx_t)remainingStations[nearestPosition]);
+        remainingStations.erase(remainingStations.begin() + nearestPosition);
+    }
+    return path;
+}
+
+// the length of the best cycle found when every start station builds its own distance matrix
+static nauticmiles_t solveWithMatrixPerStart(const ProblemMap &map, unsigned int threadCount, unsigned int optAlgo)
+{
+    const CandidateSet candidates = optAlgo != 0 ? getCandidateSet(map) : CandidateSet{};
+    std::atomic<size_t> nextStart = 0;
+    std::mutex mutex;
+    nauticmiles_t bestLength = std::numeric_limits<nauticmiles_t>::max();
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&] {
+            for (size_t start = nextStart++; start < map.size(); start = nextStart++) {
+                const StationDistanceMatrix distances = getDistancesMatrix(map);
+                ProblemPath path = nearestNeighbourPath(distances, start);
+                path.push_back(path.front());
+                if (optAlgo == 2)
+                    path = tsp_optimization::o2opt(path, map, distances, candidates);
+                nauticmiles_t length = getLength(map, path);
+                std::lock_guard lock{ mutex };
+                bestLength = std::min(bestLength, length);
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    return bestLength;
+}
+
+int main(int argc, char **argv)
+{
+    constexpr size_t RUNS = 3;
+    const unsigned int threadCount = argc > 2 ? std::stoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    GeoMap geoMap = CSVSerializer{}.parseMap(benchmark::mapFile(argc, argv));
+    ProblemMap map;
+    for (const Station &station : geoMap.getStations())
+        map.emplace_back(&station, true, true);
+    std::cout << map.size() << " stations, " << threadCount << " threads, median of " << RUNS << " runs" << std::endl;
+
+    double matrixMs = benchmark::medianMs(RUNS, [&] { (void)getDistancesMatrix(map); });
+    std::cout << "distance matrix            " << matrixMs << "ms" << std::endl;
+
+    struct Configuration {
+        const char *name;
+        unsigned int optAlgo;
+        bool loop;
+        size_t startStation, endStation;
+    };
+    const Configuration configurations[] = {
+        { "nearest neighbour only    ", 0, true,  TspNearestMultistartOptSolver::NO_STATION, TspNearestMultistartOptSolver::NO_STATION },
+        { "2-opt, cycle              ", 2, true,  TspNearestMultistartOptSolver::NO_STATION, TspNearestMultistartOptSolver::NO_STATION },
+        { "2-opt, start and end      ", 2, false, 0, 5 },
+    };
+
+    for (const Configuration &configuration : configurations) {
+        TspNearestMultistartOptSolver solver{ threadCount, configuration.optAlgo, configuration.loop, configuration.startStation, configuration.endStation };
+        ProblemPath path;
+        double solveMs = benchmark::medianMs(RUNS, [&] { SolverRuntime runtime{}; path = solver.solveForPath(map, &runtime); });
+        std::cout << configuration.name << solveMs << "ms, length " << getLength(map, path) << "nm" << std::endl;
+
+        if (configuration.loop && configuration.startStation == TspNearestMultistartOptSolver::NO_STATION) {
+            nauticmiles_t length = 0;
+            double perStartMs = benchmark::medianMs(RUNS, [&] { length = solveWithMatrixPerStart(map, threadCount, configuration.optAlgo); });
+            std::cout << "  matrix per start         " << perStartMs << "ms, length " << length << "nm" << std::endl;
+        }
+    }
+}
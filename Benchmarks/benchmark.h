@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+/*
+ * Helpers shared by the benchmarks, each benchmark is a standalone program that
+ * prints its measures. Build them with -DFLIGHTPATH_BENCHMARKS=ON.
+ */
+namespace benchmark {
+
+// the median duration of runs calls to function, in milliseconds
+template<class Function>
+double medianMs(size_t runs, Function &&function)
+{
+    std::vector<double> durations;
+    for (size_t i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        durations.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(durations.begin(), durations.end());
+    return durations[durations.size() / 2];
+}
+
+// the map given as first argument, aerodromes.csv by default
+inline std::filesystem::path mapFile(int argc, char **argv)
+{
+    if (argc > 1)
+        return argv[1];
+    return std::filesystem::path{ FLIGHTPATH_DATA_DIR } / "aerodromes.csv";
+}
+
+}
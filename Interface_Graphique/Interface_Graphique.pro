@@ -8,6 +8,13 @@ macos {
     CONFIG += c++20
 }
 
+# The distance kernels and the station bitsets have AVX2/FMA implementations,
+# build with "qmake CONFIG+=no_avx2" for CPUs that do not support them
+!no_avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2 -mfma
+}
+
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
@@ -16,9 +23,17 @@ SOURCES += \
     Solver/src/breitling/breitlingSolver.cpp \
     Solver/src/breitling/breitlingnatural.cpp \
     Solver/src/breitling/label_setting_breitling.cpp \
+    Solver/src/artifactcache.cpp \
+    Solver/src/candidateset.cpp \
+    Solver/src/geometry.cpp \
+    Solver/src/spatialindex.cpp \
     Solver/src/geoserializer.cpp \
+    Solver/src/geoserializer/binaryserializer.cpp \
     Solver/src/geoserializer/csvserializer.cpp \
+    Solver/src/geoserializer/mappedfile.cpp \
+    Solver/src/geoserializer/navigationsheet.cpp \
     Solver/src/geoserializer/xlsserializer.cpp \
+    Solver/src/geoserializer/zipfile.cpp \
     Solver/src/path.cpp \
     Solver/src/tsp/genetictsp.cpp \
     Solver/src/tsp/tsp_nearest_multistart_opt.cpp \
@@ -56,16 +71,29 @@ HEADERS += \
     Solver/src/breitling/breitlingSolver.h \
     Solver/src/breitling/breitlingnatural.h \
     Solver/src/breitling/label_setting_breitling.h \
+    Solver/src/breitling/mandatoryregions.h \
     Solver/src/breitling/structures.h \
+    Solver/src/artifactcache.h \
+    Solver/src/candidateset.h \
+    Solver/src/distancematrix.h \
+    Solver/src/distancepolicy.h \
+    Solver/src/dynamicbitset.h \
     Solver/src/geography.h \
     Solver/src/geomap.h \
     Solver/src/geometry.h \
     Solver/src/geoserializer.h \
+    Solver/src/geoserializer/binaryserializer.h \
     Solver/src/geoserializer/csvserializer.h \
+    Solver/src/geoserializer/mappedfile.h \
+    Solver/src/geoserializer/navigationsheet.h \
     Solver/src/geoserializer/xlsserializer.h \
+    Solver/src/geoserializer/zipfile.h \
     Solver/src/path.h \
     Solver/src/pathsolver.h \
+    Solver/src/spatialindex.h \
     Solver/src/station.h \
+    Solver/src/stationattributes.h \
+    Solver/src/stationindex.h \
     Solver/src/tsp/genetictsp.h \
     Solver/src/tsp/tsp_nearest_multistart_opt.h \
     Solver/src/tsp/tsp_optimization.h \
@@ -154,9 +182,6 @@ INCLUDEPATH += \
 
 TARGET = FlightPath
 
-RESOURCES += \
-    resourcesfiles.qrc
-
 # Add the icon depending on the OS
 macos {
     ICON += resources/icon/icon.icns
@@ -0,0 +1,141 @@
+#include "artifactcache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <system_error>
+
+namespace {
+
+constexpr uint32_t ARTIFACT_MAGIC = 0x54524146; // "FART", FlightPath ARTifact
+
+// padded to ArtifactWriter::ALIGNMENT so that the payload's arrays are aligned once mapped
+struct ArtifactHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint64_t payloadSize;
+  char padding[ArtifactWriter::ALIGNMENT - 24];
+};
+static_assert(sizeof(ArtifactHeader) == ArtifactWriter::ALIGNMENT);
+
+}
+
+ArtifactCache::ArtifactCache(std::filesystem::path directory, uintmax_t maxSize)
+  : m_directory(std::move(directory)), m_maxSize(maxSize)
+{
+  std::error_code error;
+  std::filesystem::create_directories(m_directory, error); // if it fails every store will fail too
+}
+
+std::filesystem::path ArtifactCache::artifactPath(std::string_view kind, uint64_t key) const
+{
+  char keyString[17];
+  std::snprintf(keyString, sizeof(keyString), "%016llx", (unsigned long long)key);
+  return m_directory / (std::string(kind) + "-" + keyString + ".artifact");
+}
+
+std::optional<ArtifactReader> ArtifactCache::load(std::string_view kind, uint64_t key) const
+{
+  std::filesystem::path path = artifactPath(kind, key);
+  std::error_code error;
+  if (!std::filesystem::exists(path, error))
+    return std::nullopt;
+
+  std::shared_ptr<const MappedFile> file;
+  try {
+    file = std::make_shared<const MappedFile>(path);
+  } catch (const std::runtime_error &) {
+    return std::nullopt;
+  }
+
+  std::string_view content = file->contents();
+  ArtifactHeader header;
+  if (content.size() < sizeof(header))
+    return std::nullopt;
+  std::memcpy(&header, content.data(), sizeof(header));
+  if (header.magic != ARTIFACT_MAGIC || header.version != VERSION || header.key != key || header.payloadSize != content.size() - sizeof(header))
+    return std::nullopt;
+
+  // used now, evicted last
+  std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+  return ArtifactReader{ file, content.substr(sizeof(header)) };
+}
+
+bool ArtifactCache::store(std::string_view kind, uint64_t key, const std::function<void(ArtifactWriter &)> &writePayload) const
+{
+  ArtifactHeader header{};
+  header.magic = ARTIFACT_MAGIC;
+  header.version = VERSION;
+  header.key = key;
+
+  // written under a name no other run uses, then renamed over the artifact
+  std::filesystem::path path = artifactPath(kind, key);
+  std::filesystem::path temporaryPath = path;
+  temporaryPath += ".tmp" + std::to_string(std::random_device{}());
+
+  {
+    // the payload size is only known once written, the header is written again after it
+    std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ArtifactWriter writer{ file };
+    writePayload(writer);
+    header.payloadSize = writer.size();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.close();
+    if (!file) {
+      std::error_code error;
+      std::filesystem::remove(temporaryPath, error);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporaryPath, path, error);
+  if (error) {
+    std::filesystem::remove(temporaryPath, error);
+    return false;
+  }
+
+  evict(path);
+  return true;
+}
+
+void ArtifactCache::evict(const std::filesystem::path &keep) const
+{
+  struct Entry {
+    std::filesystem::path path;
+    std::filesystem::file_time_type lastUse;
+    uintmax_t size;
+  };
+
+  std::vector<Entry> entries;
+  uintmax_t totalSize = 0;
+  std::error_code error;
+  for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(m_directory, error)) {
+    if (entry.path().extension() != ".artifact" || entry.path() == keep)
+      continue;
+    std::error_code entryError;
+    uintmax_t size = entry.file_size(entryError);
+    std::filesystem::file_time_type lastUse = entry.last_write_time(entryError);
+    if (entryError)
+      continue;
+    entries.push_back({ entry.path(), lastUse, size });
+    totalSize += size;
+  }
+  uintmax_t keptSize = std::filesystem::file_size(keep, error);
+  if (!error)
+    totalSize += keptSize;
+
+  std::sort(entries.begin(), entries.end(), [](const Entry &e1, const Entry &e2) { return e1.lastUse < e2.lastUse; });
+  for (const Entry &entry : entries) {
+    if (totalSize <= m_maxSize)
+      break;
+    // may fail if another run still has the artifact mapped, it is then evicted later
+    if (std::filesystem::remove(entry.path, error))
+      totalSize -= entry.size;
+  }
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <stdint.h>
+
+#include "geoserializer/mappedfile.h"
+
+/*
+ * Incremental 64 bits hash (FNV-1a) of the content artifacts are computed from,
+ * used as the key of the artifacts in an ArtifactCache.
+ */
+class ContentHash {
+private:
+  uint64_t m_hash = 14695981039346656037ull;
+
+public:
+  ContentHash &add(const void *data, size_t size)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+      m_hash = (m_hash ^ bytes[i]) * 1099511628211ull;
+    return *this;
+  }
+
+  // values must not contain padding bytes, their content would be hashed too
+  template<class T>
+  ContentHash &add(const T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return add(&value, sizeof(value));
+  }
+
+  ContentHash &add(std::string_view string)
+  {
+    add(string.size());
+    return add(string.data(), string.size());
+  }
+
+  uint64_t value() const { return m_hash; }
+};
+
+/*
+ * Writes the payload of an artifact as a sequence of arrays, each starting on
+ * a cache line so that they can be used in place once the artifact is mapped.
+ * Arrays are streamed to the artifact's file as they are written, the payload
+ * is never held in memory next to the artifact.
+ */
+class ArtifactWriter {
+public:
+  static constexpr size_t ALIGNMENT = 64;
+
+private:
+  std::ostream &m_out;
+  uint64_t m_size = 0;
+
+public:
+  explicit ArtifactWriter(std::ostream &out)
+    : m_out(out)
+  {
+  }
+
+  template<class T>
+  void write(std::span<const T> values)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t count = values.size();
+    writeBytes(&count, sizeof(count));
+    writeBytes(values.data(), values.size_bytes());
+  }
+
+  template<class T>
+  void write(const std::vector<T> &values) { write(std::span<const T>(values)); }
+
+  template<class T>
+  void writeValue(const T &value) { write(std::span<const T>(&value, 1)); }
+
+  // the number of bytes written so far, padding included
+  uint64_t size() const { return m_size; }
+
+private:
+  void writeBytes(const void *data, size_t size)
+  {
+    static constexpr char PADDING[ALIGNMENT]{};
+    size_t paddingSize = (ALIGNMENT - size % ALIGNMENT) % ALIGNMENT;
+    m_out.write(static_cast<const char *>(data), size);
+    m_out.write(PADDING, paddingSize);
+    m_size += size + paddingSize;
+  }
+};
+
+/*
+ * Reads back the arrays written by an ArtifactWriter, in the same order. The
+ * spans point into the mapped artifact, use getOwner() to keep it alive as
+ * long as they are used.
+ *
+ * Reading past the end of the payload or an array of an unexpected size throws
+ * std::runtime_error, the artifact is then ignored.
+ */
+class ArtifactReader {
+private:
+  std::shared_ptr<const MappedFile> m_owner;
+  std::string_view m_payload;
+
+public:
+  ArtifactReader(std::shared_ptr<const MappedFile> owner, std::string_view payload)
+    : m_owner(std::move(owner)), m_payload(payload)
+  {
+  }
+
+  template<class T>
+  std::span<const T> read()
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t count;
+    readBytes(&count, sizeof(count));
+    if (count > m_payload.size() / sizeof(T))
+      throw std::runtime_error("Truncated artifact");
+    const T *values = reinterpret_cast<const T *>(m_payload.data());
+    skip(count * sizeof(T));
+    return { values, (size_t)count };
+  }
+
+  template<class T>
+  std::span<const T> read(size_t expectedCount)
+  {
+    std::span<const T> values = read<T>();
+    if (values.size() != expectedCount)
+      throw std::runtime_error("Unexpected artifact array size");
+    return values;
+  }
+
+  template<class T>
+  std::vector<T> readVector() { std::span<const T> values = read<T>(); return { values.begin(), values.end() }; }
+
+  template<class T>
+  T readValue() { return read<T>(1)[0]; }
+
+  const std::shared_ptr<const MappedFile> &getOwner() const { return m_owner; }
+
+private:
+  void readBytes(void *data, size_t size)
+  {
+    if (size > m_payload.size())
+      throw std::runtime_error("Truncated artifact");
+    std::copy(m_payload.data(), m_payload.data() + size, static_cast<char *>(data));
+    skip(size);
+  }
+
+  void skip(size_t size)
+  {
+    size = std::min(m_payload.size(), (size + ArtifactWriter::ALIGNMENT - 1) / ArtifactWriter::ALIGNMENT * ArtifactWriter::ALIGNMENT);
+    m_payload.remove_prefix(size);
+  }
+};
+
+/*
+ * Directory of precomputed artifacts (distance matrices, candidate sets, solver
+ * tables...) kept between runs, so that solving again on the same stations
+ * skips the preprocessing.
+ *
+ * An artifact is identified by its kind and by a key, the ContentHash of
+ * everything it was computed from: when the stations or the parameters change
+ * the key changes and the artifact is computed again. Artifacts are written to a
+ * temporary file and then renamed, a run never sees a partially written artifact.
+ *
+ * The directory is kept under a size limit: loading an artifact marks it as
+ * used (its modification time) and storing one removes the least recently used
+ * artifacts until the directory fits, the stored artifact is kept even if it
+ * alone exceeds the limit.
+ *
+ * The cache never fails a solve: unreadable artifacts are recomputed and write
+ * errors are ignored.
+ */
+class ArtifactCache {
+public:
+  // incremented when the layout of any artifact changes, older artifacts are then ignored
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uintmax_t DEFAULT_MAX_SIZE = 1ull << 30; // 1GB, a full distance matrix of ~11k stations
+
+private:
+  std::filesystem::path m_directory;
+  uintmax_t m_maxSize;
+
+public:
+  // artifacts are stored in directory, created if it does not exist
+  explicit ArtifactCache(std::filesystem::path directory, uintmax_t maxSize = DEFAULT_MAX_SIZE);
+
+  /*
+   * Returns the artifact of the given kind computed from key, or compute() if it
+   * is not in the cache, in which case it is stored for the next runs.
+   * Artifact must provide
+   *   void writeArtifact(ArtifactWriter &) const
+   *   static Artifact readArtifact(ArtifactReader &)
+   * cache may be null, compute() is then always called.
+   */
+  template<class Artifact, class Compute>
+  static Artifact getOrCompute(const ArtifactCache *cache, std::string_view kind, uint64_t key, Compute &&compute)
+  {
+    if (cache == nullptr)
+      return compute();
+    if (std::optional<ArtifactReader> reader = cache->load(kind, key)) {
+      try {
+        return Artifact::readArtifact(*reader);
+      } catch (const std::runtime_error &) {
+        // malformed artifact, computed again and replaced below
+      }
+    }
+    Artifact artifact = compute();
+    cache->store(kind, key, [&artifact](ArtifactWriter &writer) { artifact.writeArtifact(writer); });
+    return artifact;
+  }
+
+  // the payload of an artifact, if it is in the cache and its header is valid
+  std::optional<ArtifactReader> load(std::string_view kind, uint64_t key) const;
+
+  // writes the payload with writePayload(ArtifactWriter &), returns false if the artifact could not be written
+  bool store(std::string_view kind, uint64_t key, const std::function<void(ArtifactWriter &)> &writePayload) const;
+
+private:
+  std::filesystem::path artifactPath(std::string_view kind, uint64_t key) const;
+  // removes the least recently used artifacts other than keep until the directory fits in m_maxSize
+  void evict(const std::filesystem::path &keep) const;
+};
@@ -9,14 +9,7 @@ namespace breitling_constraints {
 
 bool isStationInMandatoryRegion(const Station &station, size_t region)
 {
-  static_assert(MANDATORY_REGION_COUNT == 4);
-  switch (region) {
-  case 0: return station.getLocation().lon < -1.66;
-  case 1: return station.getLocation().lon < 2 && station.getLocation().lat < 44.5;
-  case 2: return station.getLocation().lon > 5 && station.getLocation().lat < 44.5;
-  case 3: return station.getLocation().lon > 6 && station.getLocation().lat > 46.5;
-  default: assert(false); return false;
-  }
+  return isLocationInMandatoryRegion(station.getLocation(), region);
 }
 
 size_t getStationRegion(const Station &station)
@@ -28,39 +21,29 @@ size_t getStationRegion(const Station &station)
   return -1;
 }
 
-bool satisfiesRegionsConstraints(const ProblemPath &path)
+bool satisfiesRegionsConstraints(const ProblemMap &map, const ProblemPath &path)
 {
-    static_assert(MANDATORY_REGION_COUNT == 4);
-    static_assert(sizeof(uint32_t) == 4);
-    union {
-        bool notCrossedRegions[MANDATORY_REGION_COUNT];
-        uint32_t anyRegionsNotCrossed;
-    };
-    anyRegionsNotCrossed = 0;
-    notCrossedRegions[0] = notCrossedRegions[1] = notCrossedRegions[2] = notCrossedRegions[3] = true;
-    for(size_t i = 0; i < path.size() && anyRegionsNotCrossed; i++) {
-        const ProblemStation &s = path[i];
-        for(size_t r = 0; r < MANDATORY_REGION_COUNT; r++)
-            notCrossedRegions[r] = notCrossedRegions[r] && !isStationInMandatoryRegion(*s.getOriginalStation(), r);
-    }
-    return anyRegionsNotCrossed == 0;
+    uint8_t crossedRegions = 0;
+    for (problemidx_t station : path)
+        crossedRegions |= map.getMandatoryRegions(station);
+    return crossedRegions == (1 << MANDATORY_REGION_COUNT) - 1;
 }
 
 bool satisfiesStationCountConstraints(const ProblemPath &path)
 {
-    std::set<ProblemStation> distinctStations(path.begin(), path.end());
+    std::set<problemidx_t> distinctStations(path.begin(), path.end());
     return distinctStations.size() >= MINIMUM_STATION_COUNT;
 }
 
 bool satisfiesPathConstraints(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path)
 {
     return path.size() > 0
-      && path[0] == map[dataset.departureStation] 
+      && path[0] == dataset.departureStation 
       && (dataset.targetStation == BreitlingData::NO_SPECIFIED_STATION
-          || path[path.size() - 1] == map[dataset.targetStation]);
+          || path[path.size() - 1] == dataset.targetStation);
 }
 
-bool satisfiesFuelConstraints(const BreitlingData &dataset, const ProblemPath &path)
+bool satisfiesFuelConstraints(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path)
 {
     assert(dataset.planeFuelUsage > 0);
     assert(dataset.planeSpeed > 0);
@@ -68,11 +51,10 @@ bool satisfiesFuelConstraints(const BreitlingData &dataset, const ProblemPath &p
     nauticmiles_t currentDistance = 0;
     nauticmiles_t distanceSinceLastRefuel = 0;
     for (size_t i = 1; i < path.size(); i++) {
-        const ProblemStation &station = path[i];
-        nauticmiles_t flightDistance = geometry::distance(path[i - 1].getLocation(), station.getLocation());
+        nauticmiles_t flightDistance = getDistance(map, path[i - 1], path[i]);
         currentDistance += flightDistance;
         distanceSinceLastRefuel += flightDistance;
-        if (!station.canBeUsedToFuel()) {
+        if (!map.canBeUsedToFuel(path[i])) {
             float remainingFuel = dataset.planeFuelCapacity - distanceSinceLastRefuel / dataset.planeSpeed * dataset.planeFuelUsage;
             if (remainingFuel < 0)
                 return false;
@@ -83,9 +65,9 @@ bool satisfiesFuelConstraints(const BreitlingData &dataset, const ProblemPath &p
     return true;
 }
 
-bool satisfiesTimeConstraints(const BreitlingData &dataset, const ProblemPath &path)
+bool satisfiesTimeConstraints(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path)
 {
-    daytime_t totalTime = getLength(path) / dataset.planeSpeed;
+    daytime_t totalTime = getLength(map, path) / dataset.planeSpeed;
     return totalTime < MAXIMUM_FLYGHT_DURATION;
 }
 
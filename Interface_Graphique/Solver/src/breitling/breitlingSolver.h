@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../pathsolver.h"
+#include "mandatoryregions.h"
 
 // day time, normally in range 0..24 (ie. 6.5 is 6:30am)
 // Unless otherwise specified, methods should respond well to values in range 0..inf
@@ -27,8 +28,6 @@ namespace breitling_constraints {
 constexpr daytime_t MAXIMUM_FLYGHT_DURATION = 24;
 // the plane must go through 100 stations minimum
 constexpr size_t MINIMUM_STATION_COUNT = 100;
-// there are 4 predefined regions to go through
-constexpr size_t MANDATORY_REGION_COUNT = 4;
 
 // region must be in range 0..3 inclusive
 // The Breitling cup specifies 4 regions to pass through, meaning a path must cross
@@ -39,25 +38,25 @@ bool isStationInMandatoryRegion(const Station &station, size_t region);
 size_t getStationRegion(const Station &station);
 
 // the path must go through 4 stations, one for each cardinal direction
-bool satisfiesRegionsConstraints(const ProblemPath &path);
+bool satisfiesRegionsConstraints(const ProblemMap &map, const ProblemPath &path);
 // the path must go through a set number of stations
 bool satisfiesStationCountConstraints(const ProblemPath &path);
 // the path must start and end at set cities
 bool satisfiesPathConstraints(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path);
 // the path must allow the plane to not go out of fuel, it is assumed that the plane fuels up at *every* station when possible
-bool satisfiesFuelConstraints(const BreitlingData &dataset, const ProblemPath &path);
+bool satisfiesFuelConstraints(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path);
 // the whole path must not take too long
-bool satisfiesTimeConstraints(const BreitlingData &dataset, const ProblemPath &path);
+bool satisfiesTimeConstraints(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path);
 
 // check all satisfiesXXConstraints, users may want to check time constraints separately because
 // slow planes simply cannot go through the set number of stations in due time
 inline bool isPathValid(const ProblemMap &map, const BreitlingData &dataset, const ProblemPath &path)
 {
-    return satisfiesRegionsConstraints(path) &&
+    return satisfiesRegionsConstraints(map, path) &&
         satisfiesStationCountConstraints(path) &&
         satisfiesPathConstraints(map, dataset, path) &&
-        satisfiesFuelConstraints(dataset, path) &&
-        satisfiesTimeConstraints(dataset, path);
+        satisfiesFuelConstraints(map, dataset, path) &&
+        satisfiesTimeConstraints(map, dataset, path);
 }
 
 }
@@ -43,12 +43,11 @@ std::vector<NaturalBreitlingSolver::PathTarget> NaturalBreitlingSolver::generate
 
   // find regions centers
   for (size_t i = 0; i < map.size(); i++) {
-    const ProblemStation &station = map[i];
     for (region_t r = 0; r < regionCount; r++) {
-      if (breitling_constraints::isStationInMandatoryRegion(*station.getOriginalStation(), r)) {
+      if (map.isInMandatoryRegion(i, r)) {
         stationsRegions[i] = r;
-        regionsCenters[r].accLon += station.getLocation().lon;
-        regionsCenters[r].accLat += station.getLocation().lat;
+        regionsCenters[r].accLon += map.getLocation(i).lon;
+        regionsCenters[r].accLat += map.getLocation(i).lat;
         regionsCenters[r].stationCount++;
         break;
       }
@@ -73,7 +72,7 @@ std::vector<NaturalBreitlingSolver::PathTarget> NaturalBreitlingSolver::generate
      regionsCenters.end());
   }
 
-  Location currentLocation = map[m_dataset.departureStation].getLocation();
+  Location currentLocation = map.getLocation(m_dataset.departureStation);
   disttime_t totalDistance = 0;
 
   // create targets
@@ -89,11 +88,12 @@ std::vector<NaturalBreitlingSolver::PathTarget> NaturalBreitlingSolver::generate
 
     // find the maximum distance to the region's center that can be crossed *without* being able to exit the region
     // that way if a point has a distance that is less than the found one to nextTarget, it must be in the region
-    for (size_t j = 0; j < map.size(); j++) {
-      const ProblemStation &station = map[j];
-      if (stationsRegions[j] != regionsCenters[i].regionId)
-        minDistToOutsideOfRegion = std::min(minDistToOutsideOfRegion, getTimeDistance(station.getLocation(), nextTarget));
-    }
+    nauticmiles_t distanceToOutsideStation;
+    const region_t regionId = regionsCenters[i].regionId;
+    if (m_spatialIndex.nearestSatisfying(geometry::toUnitVector(nextTarget),
+          [&stationsRegions, regionId](size_t j, nauticmiles_t) { return stationsRegions[j] != regionId; },
+          std::numeric_limits<nauticmiles_t>::max(), &distanceToOutsideStation) != SpatialIndex::NO_POINT)
+      minDistToOutsideOfRegion = distanceToOutsideStation / m_dataset.planeSpeed;
 
     totalDistance += getTimeDistance(currentLocation, nextTarget);
     targets.push_back({ nextTarget, minDistToOutsideOfRegion * REGION_CAPTURE_THRESHOLD, 0 });
@@ -101,14 +101,14 @@ std::vector<NaturalBreitlingSolver::PathTarget> NaturalBreitlingSolver::generate
   }
 
   // set the target station as a target for the path
-  const Location &targetStationLocation = map[m_dataset.targetStation].getLocation();
+  const Location &targetStationLocation = map.getLocation(m_dataset.targetStation);
   targets.push_back({ targetStationLocation, 0, 0 });
   totalDistance += getTimeDistance(currentLocation, targetStationLocation);
 
   // sets the expectedStepsToReach for each path target
   constexpr size_t totalSteps = breitling_constraints::MINIMUM_STATION_COUNT;
   nauticmiles_t accumulatedDistance = 0;
-  currentLocation = map[m_dataset.departureStation].getLocation();
+  currentLocation = map.getLocation(m_dataset.departureStation);
   for (PathTarget &target : targets) {
     accumulatedDistance += getTimeDistance(currentLocation, target.location);
     currentLocation = target.location;
@@ -118,29 +118,22 @@ std::vector<NaturalBreitlingSolver::PathTarget> NaturalBreitlingSolver::generate
   return targets;
 }
 
-const ProblemStation *NaturalBreitlingSolver::nearestAccessible(const ProblemMap &map, const ResolutionState &state, Location location)
+size_t NaturalBreitlingSolver::nearestAccessible(const ProblemMap &map, const ResolutionState &state, Location location)
 {
-  disttime_t minDist = std::numeric_limits<nauticmiles_t>::max();
-  const ProblemStation *nearestStation = nullptr;
-
-  const auto &pathStations = state.path;
-  const auto &closedStations = state.closedStations[pathStations.size()];
-
-  for (size_t i = 0; i < map.size(); i++) {
-    const ProblemStation &station = map[i];
-    nauticmiles_t dist = getTimeDistance(location, station.getLocation());
-    if (dist < minDist &&
-        dist < state.remainingFuel &&
-        (station.isAccessibleAtNight() || !isTimeInNightPeriod(state.currentTime + dist) || station == map[m_dataset.targetStation]) &&
-        std::find(pathStations.begin(), pathStations.end(), station) == pathStations.end() &&
-        std::find(closedStations.begin(), closedStations.end(), station) == closedStations.end()
-    ) {
-      minDist = dist;
-      nearestStation = &station;
-    }
-  }
-
-  return nearestStation;
+  const DynamicBitSet &pathStations = state.pathStations;
+  const DynamicBitSet &closedStations = state.closedStations[state.path.size()];
+
+  // only stations closer than the remaining fuel allows are considered
+  size_t nearestIndex = m_spatialIndex.nearestSatisfying(geometry::toUnitVector(location), [&](size_t i, nauticmiles_t realDistance) {
+    disttime_t dist = realDistance / m_dataset.planeSpeed;
+    return
+      dist < state.remainingFuel &&
+      (map.isAccessibleAtNight(i) || !isTimeInNightPeriod(state.currentTime + dist) || i == m_dataset.targetStation) &&
+      !pathStations.isSet(i) &&
+      !closedStations.isSet(i);
+  }, state.remainingFuel * m_dataset.planeSpeed);
+
+  return nearestIndex;
 }
 
 ProblemPath NaturalBreitlingSolver::solveForPath(const ProblemMap &map, SolverRuntime *runtime /* ignored */)
@@ -148,55 +141,67 @@ ProblemPath NaturalBreitlingSolver::solveForPath(const ProblemMap &map, SolverRu
   assert(m_dataset.targetStation != BreitlingData::NO_SPECIFIED_STATION);
   assert(m_dataset.departureStation != BreitlingData::NO_SPECIFIED_STATION);
 
-  const Location destinationLocation = map[m_dataset.targetStation].getLocation();
+  m_spatialIndex = SpatialIndex{ getUnitVectors(map) };
+
+  return withDistancePolicy(m_distancePolicy, map, [&](const auto &distances) { return solve(map, distances); }, m_artifactCache);
+}
+
+template<class Distances>
+ProblemPath NaturalBreitlingSolver::solve(const ProblemMap &map, const Distances &distances)
+{
+  const Location destinationLocation = map.getLocation(m_dataset.targetStation);
   const std::vector<PathTarget> targets = generateTargets(map);
 
   ResolutionState state;
-  std::vector<ProblemStation> &pathStations = state.path;
+  ProblemPath &pathStations = state.path;
   state.remainingFuel = m_planeCapacity;
   state.currentTime = m_dataset.departureTime;
-  state.closedStations.resize(2);
-  state.closedStations[0].push_back(map[m_dataset.targetStation]);
-  state.closedStations[1].push_back(map[m_dataset.targetStation]);
-  pathStations.push_back(map[m_dataset.departureStation]);
+  state.closedStations.resize(2, DynamicBitSet(map.size()));
+  state.closedStations[0].setSet(m_dataset.targetStation);
+  state.closedStations[1].setSet(m_dataset.targetStation);
+  state.pathStations = DynamicBitSet(map.size());
+  pathStations.push_back((problemidx_t)m_dataset.departureStation);
+  state.pathStations.setSet(m_dataset.departureStation);
 
-  Location currentLocation = map[m_dataset.departureStation].getLocation();
+  Location currentLocation = map.getLocation(m_dataset.departureStation);
 
   while(currentLocation != destinationLocation) {
     const PathTarget &nextTarget = targets[state.targetIdx];
     const Location expectedTarget = geometry::interpolateLocations(currentLocation, nextTarget.location, 1.f/std::max(1ull, (unsigned long long) nextTarget.expectedStepsToReach - state.path.size()));
-    const ProblemStation *nearest = nearestAccessible(map, state, expectedTarget);
+    const size_t nearestIndex = nearestAccessible(map, state, expectedTarget);
 
-    if (nearest == nullptr) {
+    if (nearestIndex == SpatialIndex::NO_POINT) {
       if (pathStations.size() <= 1)
         break; // exhausted all possible paths
 
       // backtrack by one station
-      state.closedStations[pathStations.size()-1].push_back(pathStations.back());
+      state.closedStations[pathStations.size()-1].setSet(pathStations.back());
+      state.pathStations.resetSet(pathStations.back());
       pathStations.pop_back();
-      currentLocation = pathStations.back().getLocation();
-      if (state.targetIdx > 0 && !doesPathCoverTarget(state.path, targets[state.targetIdx - 1]))
+      currentLocation = map.getLocation(pathStations.back());
+      if (state.targetIdx > 0 && !doesPathCoverTarget(map, state.path, targets[state.targetIdx - 1]))
         state.targetIdx--; // the path no longers goes through the target of the discarded station
 
     } else {
       // advance to the next station
-      disttime_t distanceToNext = getTimeDistance(currentLocation, nearest->getLocation());
+      disttime_t distanceToNext = nauticMilesBetween(distances, pathStations.back(), nearestIndex) / m_dataset.planeSpeed;
       state.remainingFuel -= distanceToNext;
       state.currentTime += distanceToNext;
-      currentLocation = nearest->getLocation();
-      pathStations.push_back(*nearest);
+      currentLocation = map.getLocation(nearestIndex);
+      pathStations.push_back((problemidx_t)nearestIndex);
+      state.pathStations.setSet(nearestIndex);
 
       if (getTimeDistance(currentLocation, nextTarget.location) < nextTarget.radius)
         state.targetIdx++; // switch to next target
-      if (nearest->canBeUsedToFuel())
+      if (map.canBeUsedToFuel(nearestIndex))
         state.remainingFuel = m_planeCapacity; // refuel, does not account for refueling time
 
       if (state.closedStations.size() <= pathStations.size())
-        state.closedStations.emplace_back();
+        state.closedStations.emplace_back(map.size());
       else
         state.closedStations[pathStations.size()].clear();
       if (pathStations.size() < breitling_constraints::MINIMUM_STATION_COUNT - 1)
-        state.closedStations[pathStations.size()].push_back(map[m_dataset.targetStation]);
+        state.closedStations[pathStations.size()].setSet(m_dataset.targetStation);
     }
   }
 
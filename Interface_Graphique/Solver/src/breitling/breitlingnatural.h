@@ -4,7 +4,10 @@
 #include <algorithm>
 
 #include "breitlingSolver.h"
+#include "structures.h"
 #include "../geometry.h"
+#include "../spatialindex.h"
+#include "../distancepolicy.h"
 
 
 class NaturalBreitlingSolver : public PathSolver {
@@ -27,28 +30,35 @@ private:
   };
 
   struct ResolutionState {
-    std::vector<std::vector<ProblemStation>> closedStations;
+    std::vector<DynamicBitSet> closedStations; // per path length, the stations that cannot come next
     disttime_t currentTime = 0;
     disttime_t remainingFuel = 0;
     size_t targetIdx = 0;
     ProblemPath path;
+    DynamicBitSet pathStations; // the stations of path
   };
 
 private:
   BreitlingData m_dataset;
   disttime_t m_planeCapacity;
+  SpatialIndex m_spatialIndex; // built over the map's stations in solveForPath
+  DistancePolicy m_distancePolicy; // for the legs between stations, see DistancePolicy
   
 public:
-  NaturalBreitlingSolver(const BreitlingData &dataset)
-    : m_dataset(dataset), m_planeCapacity(dataset.planeFuelCapacity / dataset.planeFuelUsage)
+  NaturalBreitlingSolver(const BreitlingData &dataset, DistancePolicy distancePolicy = DistancePolicy::SPHERICAL)
+    : m_dataset(dataset), m_planeCapacity(dataset.planeFuelCapacity / dataset.planeFuelUsage), m_distancePolicy(distancePolicy)
   {
   }
 
   virtual ProblemPath solveForPath(const ProblemMap &map, SolverRuntime *runtime) override;
 
 private:
+  template<class Distances>
+  ProblemPath solve(const ProblemMap &map, const Distances &distances);
+
   std::vector<PathTarget> generateTargets(const ProblemMap &map);
-  const ProblemStation *nearestAccessible(const ProblemMap &map, const ResolutionState &state, Location location);
+  // the index of the station to go to next, SpatialIndex::NO_POINT if there is none
+  size_t nearestAccessible(const ProblemMap &map, const ResolutionState &state, Location location);
 
   inline disttime_t getTimeDistance(const Location &l1, const Location &l2)
   {
@@ -62,10 +72,10 @@ private:
     return time < m_dataset.nauticalDaytime || time > m_dataset.nauticalNighttime;
   }
 
-  inline bool doesPathCoverTarget(const ProblemPath &path, const PathTarget &target)
+  inline bool doesPathCoverTarget(const ProblemMap &map, const ProblemPath &path, const PathTarget &target)
   {
-    for (const ProblemStation &station : path)
-      if (getTimeDistance(station.getLocation(), target.location) < target.radius)
+    for (problemidx_t station : path)
+      if (getTimeDistance(map.getLocation(station), target.location) < target.radius)
         return true;
     return false;
   }
@@ -22,6 +22,7 @@
 #include <bit>
 
 #include "../geometry.h"
+#include "../spatialindex.h"
 #include "breitlingnatural.h"
 #include "structures.h"
 
@@ -178,7 +179,7 @@ static uint8_t firstRegionSetIndex(region_t regionsBitField)
 
 static inline disttime_t timeDistanceBetweenStations(const ProblemStation &s1, const ProblemStation &s2, const BreitlingData &dataset)
 {
-  nauticmiles_t realDistance = geometry::distance(s1.getLocation(), s2.getLocation());
+  nauticmiles_t realDistance = getDistance(s1, s2);
   disttime_t timeDistance = realDistance / dataset.planeSpeed;
   return timeDistance;
 }
@@ -533,83 +534,149 @@ public:
 };
 #endif
 
-class PartialAdjencyMatrix {
-private:
-  struct LimitedAdjencyComparator {
-    bool operator()(const LimitedAdjency &l1, const LimitedAdjency &l2) { return l1.distance < l2.distance; }
-  };
+/*
+ * Everything the label setting precomputes before exploring, kept in an ArtifactCache
+ * between runs. The tables only depend on the map, the distance policy, the plane's
+ * speed and the target station (see LabelSetting::getTables).
+ *
+ * The adjency lists are stored one after the other, the neighbours of station i
+ * being in [adjencyStart[i], adjencyStart[i+1]).
+ */
+struct LabelSettingTables {
+  std::vector<uint32_t> adjencyStart;
+  std::vector<LimitedAdjency> adjency;
+  std::vector<disttime_t> distanceToTarget; // the distances to the target station must be kept somehow
+  std::vector<disttime_t> distanceToNearestRefuel;
+  std::vector<region_t> stationRegions;
+  std::vector<region_t> stationExtendedRegions;
+  std::vector<disttime_t> minDistancePerRemainingRegionCount;  // MANDATORY_REGION_COUNT+1 entries
+  std::vector<disttime_t> minDistancePerRemainingStationCount; // MINIMUM_STATION_COUNT+1 entries
+
+  void writeArtifact(ArtifactWriter &writer) const
+  {
+    writer.write(adjencyStart);
+    writer.write(adjency);
+    writer.write(distanceToTarget);
+    writer.write(distanceToNearestRefuel);
+    writer.write(stationRegions);
+    writer.write(stationExtendedRegions);
+    writer.write(minDistancePerRemainingRegionCount);
+    writer.write(minDistancePerRemainingStationCount);
+  }
 
+  static LabelSettingTables readArtifact(ArtifactReader &reader)
+  {
+    LabelSettingTables tables;
+    tables.adjencyStart = reader.readVector<uint32_t>();
+    tables.adjency = reader.readVector<LimitedAdjency>();
+    if (tables.adjencyStart.empty())
+      throw std::runtime_error("Inconsistent artifact");
+    size_t stationCount = tables.adjencyStart.size() - 1;
+    tables.distanceToTarget = reader.readVector<disttime_t>();
+    tables.distanceToNearestRefuel = reader.readVector<disttime_t>();
+    tables.stationRegions = reader.readVector<region_t>();
+    tables.stationExtendedRegions = reader.readVector<region_t>();
+    tables.minDistancePerRemainingRegionCount = reader.readVector<disttime_t>();
+    tables.minDistancePerRemainingStationCount = reader.readVector<disttime_t>();
+
+    bool consistent = tables.adjencyStart.front() == 0 && tables.adjencyStart.back() == tables.adjency.size()
+      && std::is_sorted(tables.adjencyStart.begin(), tables.adjencyStart.end())
+      && tables.distanceToTarget.size() == stationCount && tables.distanceToNearestRefuel.size() == stationCount
+      && tables.stationRegions.size() == stationCount && tables.stationExtendedRegions.size() == stationCount
+      && tables.minDistancePerRemainingRegionCount.size() == breitling_constraints::MANDATORY_REGION_COUNT + 1
+      && tables.minDistancePerRemainingStationCount.size() == breitling_constraints::MINIMUM_STATION_COUNT + 1;
+    for (const LimitedAdjency &adjency : tables.adjency)
+      consistent &= adjency.station < stationCount;
+    if (!consistent)
+      throw std::runtime_error("Inconsistent artifact");
+    return tables;
+  }
+};
+
+// Distances is one of the distance sources of distancepolicy.h, neighbours are chosen
+// on the exact distances but their distances are read from the distance source
+template<class Distances>
+class PartialAdjencyMatrix {
 private:
-  std::vector<std::vector<LimitedAdjency>> m_adjencyMatrix; // NxM matrix M<<N
-  std::vector<disttime_t> m_distanceToTarget; // 1xN matrix, the distances to the target station must be kept somehow
-  std::vector<disttime_t> m_distanceToNearestRefuel;
-  const ProblemMap *m_geomap;
+  const LabelSettingTables *m_tables; // NxM adjency matrix M<<N
   const BreitlingData *m_dataset;
+  const Distances *m_distances;
 
 public:
-  PartialAdjencyMatrix(const ProblemMap *geomap, const BreitlingData *dataset, stationidx_t targetStation)
-    : m_adjencyMatrix(geomap->size()),
-    m_distanceToTarget(geomap->size()),
-    m_distanceToNearestRefuel(geomap->size()),
-    m_geomap(geomap),
-    m_dataset(dataset)
+  PartialAdjencyMatrix(const LabelSettingTables *tables, const BreitlingData *dataset, const Distances *distances)
+    : m_tables(tables),
+    m_dataset(dataset),
+    m_distances(distances)
   {
-    SmallBoundedPriorityQueue<LimitedAdjency, LimitedAdjencyComparator> nearestStationsQueue(20); // keep only the 20 shortest links per station
+  }
+
+  // fills the adjency lists and the distances to the target and to fuel of tables
+  static void computeAdjency(LabelSettingTables &tables, const ProblemMap *geomap, const BreitlingData *dataset, const Distances *distances, stationidx_t targetStation)
+  {
+    tables.adjencyStart.assign(1, 0);
+    tables.adjency.clear();
+    tables.distanceToTarget.assign(geomap->size(), 0);
+    tables.distanceToNearestRefuel.assign(geomap->size(), 0);
+
+    const std::vector<geometry::UnitVector> &vectors = getUnitVectors(*geomap);
+    const SpatialIndex spatialIndex{ vectors };
+    const CandidateSet candidates = getCandidateSet(*geomap);
 
     for (stationidx_t i = 0; i < geomap->size(); i++) {
-      disttime_t minDistanceToFuel = std::numeric_limits<disttime_t>::max();
-      stationidx_t nearestStationWithFuel = -1;
-      for (stationidx_t j = 0; j < geomap->size(); j++) {
-        if (i == j)
+      // without a target station the distances to the target stay 0
+      if (dataset->targetStation != BreitlingData::NO_SPECIFIED_STATION && i != targetStation)
+        tables.distanceToTarget[i] = utils::realDistanceToTimeDistance(nauticMilesBetween(*distances, i, targetStation), *dataset);
+
+      size_t nearestStationWithFuel = spatialIndex.nearestSatisfying(vectors[i],
+        [i, geomap](size_t j, nauticmiles_t) { return j != i && geomap->canBeUsedToFuel(j); });
+      disttime_t minDistanceToFuel = nearestStationWithFuel == SpatialIndex::NO_POINT
+        ? std::numeric_limits<disttime_t>::max()
+        : utils::realDistanceToTimeDistance(nauticMilesBetween(*distances, i, nearestStationWithFuel), *dataset);
+      tables.distanceToNearestRefuel[i] = minDistanceToFuel;
+
+      // keep only the links to the candidates of each station
+      const size_t rowStart = tables.adjency.size();
+      for (uint32_t neighbour : candidates.candidates(i)) {
+        if (neighbour == targetStation) // do not use the target station as a neighbour of any station
           continue;
-        disttime_t distance = utils::timeDistanceBetweenStations((*geomap)[i], (*geomap)[j], *dataset);
-        if (j == targetStation)
-          m_distanceToTarget[i] = distance;
-        else // do not use the target station as a neighbour of any station
-          nearestStationsQueue.insert({ distance, j });
-        if ((*geomap)[j].canBeUsedToFuel() && distance < minDistanceToFuel) {
-          minDistanceToFuel = distance;
-          nearestStationWithFuel = j;
-        }
+        tables.adjency.push_back({ utils::realDistanceToTimeDistance(nauticMilesBetween(*distances, i, neighbour), *dataset), (stationidx_t)neighbour });
       }
-      m_distanceToNearestRefuel[i] = minDistanceToFuel;
-
-      nearestStationsQueue.transferTo(m_adjencyMatrix[i]);
-      // keep at leat one station with fuel
-      if (std::find_if(m_adjencyMatrix[i].begin(), m_adjencyMatrix[i].end(), [&geomap](LimitedAdjency t) { return (*geomap)[t.station].canBeUsedToFuel(); }) == m_adjencyMatrix[i].end()) {
-        m_adjencyMatrix[i].push_back({ minDistanceToFuel, nearestStationWithFuel });
+      // keep at leat one station with fuel, if any station of the map has some
+      if (nearestStationWithFuel != SpatialIndex::NO_POINT && std::find_if(tables.adjency.begin() + rowStart, tables.adjency.end(), [&geomap](LimitedAdjency t) { return geomap->canBeUsedToFuel(t.station); }) == tables.adjency.end()) {
+        tables.adjency.push_back({ minDistanceToFuel, (stationidx_t)nearestStationWithFuel });
       }
+      tables.adjencyStart.push_back((uint32_t)tables.adjency.size());
     }
   }
 
   inline disttime_t distanceUncached(stationidx_t s1, stationidx_t s2)
   {
-    return utils::timeDistanceBetweenStations((*m_geomap)[s1], (*m_geomap)[s2], *m_dataset);
+    return utils::realDistanceToTimeDistance(nauticMilesBetween(*m_distances, s1, s2), *m_dataset);
   }
 
   inline size_t adjencyCount(stationidx_t station)
   {
-    return m_adjencyMatrix[station].size();
+    return m_tables->adjencyStart[station + 1] - m_tables->adjencyStart[station];
   }
 
   inline stationidx_t getAdjencyNextStation(stationidx_t currentStation, size_t idx)
   {
-    return m_adjencyMatrix[currentStation][idx].station;
+    return m_tables->adjency[m_tables->adjencyStart[currentStation] + idx].station;
   }
 
   inline disttime_t getAdjencyNextDistance(stationidx_t currentStation, size_t idx)
   {
-    return m_adjencyMatrix[currentStation][idx].distance;
+    return m_tables->adjency[m_tables->adjencyStart[currentStation] + idx].distance;
   }
 
   inline disttime_t distanceToTargetStation(stationidx_t fromStation)
   {
-    return m_distanceToTarget[fromStation];
+    return m_tables->distanceToTarget[fromStation];
   }
 
   inline disttime_t distanceToNearestStationWithFuel(stationidx_t fromStation)
   {
-    return m_distanceToNearestRefuel[fromStation];
+    return m_tables->distanceToNearestRefuel[fromStation];
   }
 
 };
@@ -653,19 +720,18 @@ static void writeStations(const StationSet &stationSet, stationidx_t lastStation
 #endif
 
 
+template<class Distances>
 class LabelSetting {
 private:
   static constexpr region_t NO_REGION = 0;
 
   const ProblemMap     *m_geomap;
   const BreitlingData  *m_dataset;
+  DistancePolicy        m_distancePolicy;
+  const ArtifactCache  *m_artifactCache;
 
-  PartialAdjencyMatrix  m_adjencyMatrix;
-  std::vector<region_t> m_stationRegions;
-  std::vector<region_t> m_stationExtendedRegions;
-
-  disttime_t            m_minDistancePerRemainingRegionCount[breitling_constraints::MANDATORY_REGION_COUNT + 1];
-  disttime_t            m_minDistancePerRemainingStationCount[breitling_constraints::MINIMUM_STATION_COUNT + 1];
+  LabelSettingTables    m_tables; // regions, lower bounds and adjency lists
+  PartialAdjencyMatrix<Distances> m_adjencyMatrix;
 
   LabelsArena           m_labels = LabelsArena(20'000); // start with min. 20k labels, it will surely grow during execution
   PathFragmentsArena    m_fragments = PathFragmentsArena(20'000);
@@ -676,36 +742,61 @@ private:
   disttime_t            m_bestTime = m_noBestTime;
 
 public:
-  LabelSetting(const ProblemMap *geomap, const BreitlingData *dataset)
+  LabelSetting(const ProblemMap *geomap, const BreitlingData *dataset, const Distances *distances, DistancePolicy distancePolicy, const ArtifactCache *artifactCache)
     : m_geomap(geomap),
-    m_adjencyMatrix(geomap, dataset, dataset->targetStation),
-    m_stationRegions(geomap->size(), NO_REGION),
-    m_stationExtendedRegions(geomap->size(), NO_REGION),
     m_dataset(dataset),
-    m_labelsPerStationsIndex(geomap->size()),
-    m_bestLabelsQueue(&m_labels)
+    m_distancePolicy(distancePolicy),
+    m_artifactCache(artifactCache),
+    m_tables(getTables(geomap, dataset, distances, distancePolicy, artifactCache)),
+    m_adjencyMatrix(&m_tables, dataset, distances),
+    m_bestLabelsQueue(&m_labels),
+    m_labelsPerStationsIndex(geomap->size())
   {
-    size_t stationCount = geomap->size();
-    constexpr size_t regionCount = breitling_constraints::MANDATORY_REGION_COUNT;
+  }
 
+private:
+  static LabelSettingTables getTables(const ProblemMap *geomap, const BreitlingData *dataset, const Distances *distances, DistancePolicy distancePolicy, const ArtifactCache *artifactCache)
+  {
     // check that the dataset is prepared
-    assert(stationCount > 0);
-    if (stationCount > packed_data_structures::MAX_SUPPORTED_STATIONS)
+    assert(geomap->size() > 0);
+    if (geomap->size() > packed_data_structures::MAX_SUPPORTED_STATIONS)
       throw std::runtime_error("Cannot handle that many stations");
 
+    uint64_t key = ContentHash{}
+      .add(getMapHash(*geomap))
+      .add(distancePolicy)
+      .add(dataset->planeSpeed)
+      .add(dataset->targetStation)
+      .value();
+    return ArtifactCache::getOrCompute<LabelSettingTables>(artifactCache, "label-setting", key, [&] {
+      return computeTables(geomap, dataset, distances);
+    });
+  }
+
+  static LabelSettingTables computeTables(const ProblemMap *geomap, const BreitlingData *dataset, const Distances *distances)
+  {
+    size_t stationCount = geomap->size();
+    constexpr size_t regionCount = breitling_constraints::MANDATORY_REGION_COUNT;
+
+    LabelSettingTables tables;
+    PartialAdjencyMatrix<Distances>::computeAdjency(tables, geomap, dataset, distances, (stationidx_t)dataset->targetStation);
+    tables.stationRegions.assign(stationCount, NO_REGION);
+    tables.stationExtendedRegions.assign(stationCount, NO_REGION);
+    tables.minDistancePerRemainingRegionCount.resize(regionCount + 1);
+    tables.minDistancePerRemainingStationCount.resize(breitling_constraints::MINIMUM_STATION_COUNT + 1);
+
     { // initialize station regions and extended regions
       struct GravityCenter { double accLon = 0; double accLat = 0; size_t stationCount = 0; Location location; };
       std::array<GravityCenter, regionCount> regionsCenters;
 
       for (stationidx_t i = 0; i < stationCount; i++) {
-        const ProblemStation &station = (*geomap)[i];
         for (regionidx_t r = 0; r < regionCount; r++) {
-          if (breitling_constraints::isStationInMandatoryRegion(*station.getOriginalStation(), r)) {
+          if (geomap->isInMandatoryRegion(i, r)) {
             // set the station's region
-            m_stationRegions[i] = 1<<r;
+            tables.stationRegions[i] = 1<<r;
             // move the region's gravity center
-            regionsCenters[r].accLon += station.getLocation().lon;
-            regionsCenters[r].accLat += station.getLocation().lat;
+            regionsCenters[r].accLon += geomap->getLocation(i).lon;
+            regionsCenters[r].accLat += geomap->getLocation(i).lat;
             regionsCenters[r].stationCount++;
             break;
           }
@@ -724,15 +815,14 @@ public:
       for (stationidx_t i = 0; i < stationCount; i++) {
         disttime_t minDist = std::numeric_limits<disttime_t>::max();
         regionidx_t extendedRegion = -1;
-        const ProblemStation &station = (*geomap)[i];
         for (regionidx_t r = 0; r < regionCount; r++) {
-          disttime_t dist = geometry::distance(regionsCenters[r].location, station.getLocation());
+          disttime_t dist = geometry::distance(regionsCenters[r].location, geomap->getLocation(i));
           if (dist < minDist) {
             minDist = dist;
             extendedRegion = r;
           }
         }
-        m_stationExtendedRegions[i] = 1<<extendedRegion;
+        tables.stationExtendedRegions[i] = 1<<extendedRegion;
       }
     }
 
@@ -742,19 +832,19 @@ public:
       TriangularMatrix<disttime_t> regionAdjencyMatrix{ regionCount };
       regionAdjencyMatrix.fill(std::numeric_limits<disttime_t>::max());
       for (stationidx_t i = 0; i < stationCount; i++) {
-        region_t ri = m_stationRegions[i];
+        region_t ri = tables.stationRegions[i];
         if (ri == NO_REGION)
           continue;
         regionidx_t riidx = utils::firstRegionSetIndex(ri);
         for (stationidx_t j = i + 1; j < stationCount; j++) {
-          region_t rj = m_stationRegions[j];
+          region_t rj = tables.stationRegions[j];
           if (rj == NO_REGION || ri == rj)
             continue;
           regionidx_t rjidx = utils::firstRegionSetIndex(rj);
           disttime_t &distance = regionAdjencyMatrix.at(riidx, rjidx);
           // the adjency matrix cannot be used because it may be partial
           // and not contain the distance from i to j
-          distance = std::min(distance, utils::timeDistanceBetweenStations((*geomap)[i], (*geomap)[j], *dataset));
+          distance = std::min(distance, utils::realDistanceToTimeDistance(nauticMilesBetween(*distances, i, j), *dataset));
         }
       }
       // find the R smallest distances
@@ -769,9 +859,9 @@ public:
       // with 1, it is 0 + min(inter region distance)
       // with 2, it is 0 + min(inter region distance) + second min(inter region distance)
       // etc
-      m_minDistancePerRemainingRegionCount[0] = 0;
+      tables.minDistancePerRemainingRegionCount[0] = 0;
       for (region_t r = 0; r < breitling_constraints::MANDATORY_REGION_COUNT; r++) {
-        m_minDistancePerRemainingRegionCount[1 + r] = m_minDistancePerRemainingRegionCount[r] + sortedCentersDistances.top();
+        tables.minDistancePerRemainingRegionCount[1 + r] = tables.minDistancePerRemainingRegionCount[r] + sortedCentersDistances.top();
         sortedCentersDistances.pop();
       }
     }
@@ -779,24 +869,36 @@ public:
     { // find a good approximation for the minimal distances to cover while having visited only n<N stations
       // similar method to the previous code block
       SmallBoundedPriorityQueue<disttime_t> sortedDistances(breitling_constraints::MINIMUM_STATION_COUNT);
-      for (stationidx_t s1 = 1; s1 < stationCount; s1++)
+      const std::vector<geometry::UnitVector> &vectors = getUnitVectors(*geomap);
+      std::vector<nauticmiles_t> distancesFromS1(stationCount);
+      for (stationidx_t s1 = 1; s1 < stationCount; s1++) {
+        if constexpr (std::is_same_v<Distances, SphericalDistances>) {
+          // same distances, computed by batches
+          geometry::distances(vectors[s1], vectors.data(), s1, distancesFromS1.data());
+        } else {
+          for (stationidx_t s2 = 0; s2 < s1; s2++)
+            distancesFromS1[s2] = nauticMilesBetween(*distances, s1, s2);
+        }
         for (stationidx_t s2 = 0; s2 < s1; s2++)
-          sortedDistances.insert(m_adjencyMatrix.distanceUncached(s1, s2));
-      m_minDistancePerRemainingStationCount[0] = 0;
+          sortedDistances.insert(utils::realDistanceToTimeDistance(distancesFromS1[s2], *dataset));
+      }
+      tables.minDistancePerRemainingStationCount[0] = 0;
       for (region_t r = 0; r < breitling_constraints::MINIMUM_STATION_COUNT; r++) {
-        m_minDistancePerRemainingStationCount[1 + r] = m_minDistancePerRemainingStationCount[r] + sortedDistances.top();
+        tables.minDistancePerRemainingStationCount[1 + r] = tables.minDistancePerRemainingStationCount[r] + sortedDistances.top();
         sortedDistances.pop();
       }
     }
+
+    return tables;
   }
 
 private:
   inline disttime_t lowerBound(const Label &label)
   {
     unsigned char regionCountLeftToExplore = breitling_constraints::MANDATORY_REGION_COUNT - utils::countRegions(label.visitedRegions);
-    disttime_t minDistanceForRegions = m_minDistancePerRemainingRegionCount[regionCountLeftToExplore];
+    disttime_t minDistanceForRegions = m_tables.minDistancePerRemainingRegionCount[regionCountLeftToExplore];
     unsigned char stationsLeftToExplore = breitling_constraints::MINIMUM_STATION_COUNT - label.visitedStationCount;
-    disttime_t minDistanceForStations = m_minDistancePerRemainingStationCount[stationsLeftToExplore];
+    disttime_t minDistanceForStations = m_tables.minDistancePerRemainingStationCount[stationsLeftToExplore];
     disttime_t distanceToTarget = m_adjencyMatrix.distanceToTargetStation(label.currentStation);
     return std::max({ minDistanceForRegions, distanceToTarget, minDistanceForStations });
   }
@@ -812,11 +914,10 @@ private:
 
   inline void tryExplore(const Label &source, std::vector<Label> &explorationLabels, stationidx_t nextStationIdx, disttime_t distanceToNext)
   {
-    region_t currentExtendedRegion = m_stationExtendedRegions[source.currentStation];
+    region_t currentExtendedRegion = m_tables.stationExtendedRegions[source.currentStation];
     size_t currentVisitedRegionCount = utils::countRegions(source.visitedRegions);
-    const ProblemStation &nextStation = (*m_geomap)[nextStationIdx];
-    region_t newLabelVisitedRegions = source.visitedRegions | m_stationRegions[nextStationIdx];
-    region_t newLabelExtendedRegion = m_stationExtendedRegions[nextStationIdx];
+    region_t newLabelVisitedRegions = source.visitedRegions | m_tables.stationRegions[nextStationIdx];
+    region_t newLabelExtendedRegion = m_tables.stationExtendedRegions[nextStationIdx];
 
     if (source.visitedStations.isSet(nextStationIdx))
       return; // station already visited
@@ -826,9 +927,9 @@ private:
       return; // already dominated on time
     if (breitling_constraints::MINIMUM_STATION_COUNT - source.visitedStationCount < breitling_constraints::MANDATORY_REGION_COUNT - utils::countRegions(newLabelVisitedRegions))
       return; // 3 regions left to visit but only 2 more stations to go through
-    if (!nextStation.canBeUsedToFuel() && source.currentFuel - distanceToNext < m_adjencyMatrix.distanceToNearestStationWithFuel(nextStationIdx))
+    if (!m_geomap->canBeUsedToFuel(nextStationIdx) && source.currentFuel - distanceToNext < m_adjencyMatrix.distanceToNearestStationWithFuel(nextStationIdx))
       return; // 1 hop is possible, 2 are not because of low fuel
-    if (!nextStation.isAccessibleAtNight() && (nextStationIdx != m_dataset->targetStation) && utils::isTimeInNightPeriod(source.currentTime + distanceToNext, *m_dataset))
+    if (!m_geomap->isAccessibleAtNight(nextStationIdx) && (nextStationIdx != m_dataset->targetStation) && utils::isTimeInNightPeriod(source.currentTime + distanceToNext, *m_dataset))
       return; // the station is not accessible during the night
     if ((currentExtendedRegion & ~source.visitedRegions) && newLabelExtendedRegion != currentExtendedRegion)
       return; // Ir strategy: the current region is not explored and the new label is going away
@@ -839,9 +940,9 @@ private:
       return; // Ir strategy: the current region is explored and the label is going in an already visited extended region, does not apply if all regions are already visited
 
     bool shouldExploreNoRefuel = true;
-    bool shouldExploreWithRefuel = nextStation.canBeUsedToFuel();
+    bool shouldExploreWithRefuel = m_geomap->canBeUsedToFuel(nextStationIdx);
 
-    if (m_dataset->timeToRefuel == 0 && nextStation.canBeUsedToFuel()) // if the time to refuel is 0 refuel every time if possible
+    if (m_dataset->timeToRefuel == 0 && shouldExploreWithRefuel) // if the time to refuel is 0 refuel every time if possible
       shouldExploreNoRefuel = false;
 
     if (!shouldExploreNoRefuel && !shouldExploreWithRefuel)
@@ -919,7 +1020,7 @@ private:
     ProblemPath path;
     while (true) {
       const PathFragment &fragment = m_fragments[endFragment];
-      path.push_back((*m_geomap)[fragment.getStationIdx()]);
+      path.push_back(fragment.getStationIdx());
       fragmentidx_t parent = fragment.getPreviousFragment();
       if (parent == endFragment)
         break; // end of the path reached
@@ -942,8 +1043,10 @@ public:
     ProblemPath heuristicPath;
     // quickly find an upper bound (the natural solver cannot run if a target station is not specified)
     if(m_dataset->targetStation != BreitlingData::NO_SPECIFIED_STATION) {
-      heuristicPath = NaturalBreitlingSolver(*m_dataset).solveForPath(*m_geomap, runtime);
-      m_noBestTime = m_bestTime = m_dataset->departureTime + utils::realDistanceToTimeDistance(getLength(heuristicPath), *m_dataset);
+      NaturalBreitlingSolver naturalSolver{ *m_dataset, m_distancePolicy };
+      naturalSolver.setArtifactCache(m_artifactCache);
+      heuristicPath = naturalSolver.solveForPath(*m_geomap, runtime);
+      m_noBestTime = m_bestTime = m_dataset->departureTime + utils::realDistanceToTimeDistance(getLength(*m_geomap, heuristicPath), *m_dataset);
       runtime->discoveredSolutionCount = 0;
     }
 #endif
@@ -954,7 +1057,7 @@ public:
       initialLabel.currentTime = m_dataset->departureTime;
       initialLabel.currentStation = m_dataset->departureStation == BreitlingData::NO_SPECIFIED_STATION ? (rand() % m_geomap->size()) : m_dataset->departureStation;
       initialLabel.visitedStations.setSet(initialLabel.currentStation);
-      initialLabel.visitedRegions = m_stationRegions[initialLabel.currentStation];
+      initialLabel.visitedRegions = m_tables.stationRegions[initialLabel.currentStation];
       initialLabel.visitedStationCount = 1;
       initialLabel.score = 0.f; // score does not matter, the initial label will be explored first
       initialLabel.pathFragment = m_fragments.pushInitial(initialLabel.currentStation);
@@ -1073,6 +1176,8 @@ public:
 
 ProblemPath LabelSettingBreitlingSolver::solveForPath(const ProblemMap &map, SolverRuntime *runtime)
 {
-  LabelSetting labelSetting{ &map, &m_dataset };
-  return labelSetting.labelSetting(runtime);
+  return withDistancePolicy(m_distancePolicy, map, [&](const auto &distances) {
+    LabelSetting labelSetting{ &map, &m_dataset, &distances, m_distancePolicy, m_artifactCache };
+    return labelSetting.labelSetting(runtime);
+  }, m_artifactCache);
 }
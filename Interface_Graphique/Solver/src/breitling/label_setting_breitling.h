@@ -1,13 +1,15 @@
 #pragma once
 
 #include "breitlingSolver.h"
+#include "../distancepolicy.h"
 
 class LabelSettingBreitlingSolver : public PathSolver {
 private:
   BreitlingData m_dataset;
+  DistancePolicy m_distancePolicy;
 public:
-  LabelSettingBreitlingSolver(const BreitlingData &dataset)
-    : m_dataset(dataset)
+  LabelSettingBreitlingSolver(const BreitlingData &dataset, DistancePolicy distancePolicy = DistancePolicy::SPHERICAL)
+    : m_dataset(dataset), m_distancePolicy(distancePolicy)
   {
   }
 
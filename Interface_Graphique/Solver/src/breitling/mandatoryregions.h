@@ -0,0 +1,38 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../geography.h"
+
+namespace breitling_constraints {
+
+// there are 4 predefined regions to go through
+constexpr size_t MANDATORY_REGION_COUNT = 4;
+
+// region must be in range 0..3 inclusive, see isStationInMandatoryRegion
+inline bool isLocationInMandatoryRegion(const Location &location, size_t region)
+{
+  static_assert(MANDATORY_REGION_COUNT == 4);
+  switch (region) {
+  case 0: return location.lon < -1.66;
+  case 1: return location.lon < 2 && location.lat < 44.5;
+  case 2: return location.lon > 5 && location.lat < 44.5;
+  case 3: return location.lon > 6 && location.lat > 46.5;
+  default: assert(false); return false;
+  }
+}
+
+// bit r is set if the location is in region r, regions overlap near the south west corner
+inline uint8_t getMandatoryRegions(const Location &location)
+{
+  uint8_t regions = 0;
+  for (size_t r = 0; r < MANDATORY_REGION_COUNT; r++) {
+    if (isLocationInMandatoryRegion(location, r))
+      regions |= 1 << r;
+  }
+  return regions;
+}
+
+}
@@ -4,6 +4,10 @@
 #include <array>
 #include <algorithm>
 #include <chrono>
+#include <climits>
+#include <assert.h>
+
+#include "../dynamicbitset.h"
 
 // ----------------------- Macros, debug/profiling utilities ----------------------
  
@@ -389,7 +393,7 @@ constexpr std::array<unsigned char, S> createFirstBitLookupTable()
   return lookupTable;
 }
 
-long long currentTimeMs()
+inline long long currentTimeMs()
 {
   namespace chr = std::chrono;
   long long ms = chr::duration_cast<chr::milliseconds>(chr::system_clock::now().time_since_epoch()).count();
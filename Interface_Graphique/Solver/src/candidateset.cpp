@@ -0,0 +1,91 @@
+#include "candidateset.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "spatialindex.h"
+
+namespace {
+
+// east and north directions of the plane tangent to the sphere at a point
+struct TangentBasis {
+  geometry::UnitVector east, north;
+};
+
+TangentBasis tangentBasis(const geometry::UnitVector &p)
+{
+  double norm = sqrt(p.x * p.x + p.y * p.y);
+  geometry::UnitVector east = norm < 1e-12 ? geometry::UnitVector{ 0, 1, 0 } : geometry::UnitVector{ -p.y / norm, p.x / norm, 0 };
+  geometry::UnitVector north = { p.y * east.z - p.z * east.y, p.z * east.x - p.x * east.z, p.x * east.y - p.y * east.x };
+  return { east, north };
+}
+
+// 0..3, the quadrant around origin in which point lies
+unsigned int quadrant(const geometry::UnitVector &origin, const TangentBasis &basis, const geometry::UnitVector &point)
+{
+  double dx = point.x - origin.x, dy = point.y - origin.y, dz = point.z - origin.z;
+  bool east = dx * basis.east.x + dy * basis.east.y + dz * basis.east.z >= 0;
+  bool north = dx * basis.north.x + dy * basis.north.y + dz * basis.north.z >= 0;
+  return (unsigned int)east | (unsigned int)north << 1;
+}
+
+}
+
+CandidateSet::CandidateSet(const std::vector<geometry::UnitVector> &points, size_t nearestCount, size_t quadrantCount)
+{
+  if (points.size() > std::numeric_limits<uint32_t>::max())
+    throw std::invalid_argument("Too many points for a candidate set");
+
+  const SpatialIndex spatialIndex{ points };
+  std::vector<SpatialIndex::Neighbour> row;
+
+  m_rowStart.reserve(points.size() + 1);
+  m_rowStart.push_back(0);
+  m_candidates.reserve(points.size() * (nearestCount + 4 * quadrantCount));
+  m_distances.reserve(points.size() * (nearestCount + 4 * quadrantCount));
+
+  for (size_t i = 0; i < points.size(); i++) {
+    row.clear();
+    auto isInRow = [&row](size_t j) {
+      return std::find_if(row.begin(), row.end(), [j](const SpatialIndex::Neighbour &n) { return n.index == j; }) != row.end();
+    };
+
+    // the point itself is its nearest neighbour, it is not kept
+    for (const SpatialIndex::Neighbour &neighbour : spatialIndex.nearest(points[i], nearestCount + 1)) {
+      if (neighbour.index != i && row.size() < nearestCount)
+        row.push_back(neighbour);
+    }
+
+    if (quadrantCount > 0) {
+      const TangentBasis basis = tangentBasis(points[i]);
+      std::vector<size_t> quadrantPoints;
+      for (unsigned int q = 0; q < 4; q++) {
+        // the quadrantCount nearest points of the quadrant, those that already are
+        // candidates because they are among the nearest points count in the quota
+        quadrantPoints.clear();
+        for (size_t c = 0; c < quadrantCount; c++) {
+          nauticmiles_t distance;
+          size_t found = spatialIndex.nearestSatisfying(points[i], [&](size_t j, nauticmiles_t) {
+            return j != i && quadrant(points[i], basis, points[j]) == q
+              && std::find(quadrantPoints.begin(), quadrantPoints.end(), j) == quadrantPoints.end();
+          }, std::numeric_limits<nauticmiles_t>::max(), &distance);
+          if (found == SpatialIndex::NO_POINT)
+            break;
+          quadrantPoints.push_back(found);
+          if (!isInRow(found))
+            row.push_back({ found, distance });
+        }
+      }
+    }
+
+    std::sort(row.begin(), row.end(), [](const SpatialIndex::Neighbour &n1, const SpatialIndex::Neighbour &n2) {
+      return n1.distance < n2.distance || (n1.distance == n2.distance && n1.index < n2.index);
+    });
+    for (const SpatialIndex::Neighbour &neighbour : row) {
+      m_candidates.push_back((uint32_t)neighbour.index);
+      m_distances.push_back(neighbour.distance);
+    }
+    m_rowStart.push_back((uint32_t)m_candidates.size());
+  }
+}
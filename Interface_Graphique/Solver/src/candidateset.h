@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <span>
+#include <stdint.h>
+
+#include "geometry.h"
+#include "artifactcache.h"
+
+/*
+ * Candidate neighbours of every point of a fixed set of points, usually the
+ * stations of a ProblemMap (see getCandidateSet). Local searches only try to
+ * link a station to its candidates instead of to every other station.
+ *
+ * The candidates of a point are its nearestCount nearest points, plus the
+ * quadrantCount nearest points in each quadrant around it (north-east,
+ * north-west...) so that isolated points still get candidates in every
+ * direction. A point is never one of its own candidates.
+ *
+ * Candidates are stored in a single array, the ones of point i being in
+ * [rowStart[i], rowStart[i+1]), sorted by increasing distance then index.
+ */
+class CandidateSet {
+public:
+  static constexpr size_t DEFAULT_NEAREST_COUNT = 16;
+  static constexpr size_t DEFAULT_QUADRANT_COUNT = 2;
+
+private:
+  std::vector<uint32_t> m_rowStart;
+  std::vector<uint32_t> m_candidates;
+  std::vector<nauticmiles_t> m_distances;
+
+public:
+  CandidateSet()
+    : m_rowStart{ 0 }
+  {
+  }
+
+  explicit CandidateSet(const std::vector<geometry::UnitVector> &points,
+    size_t nearestCount = DEFAULT_NEAREST_COUNT, size_t quadrantCount = DEFAULT_QUADRANT_COUNT);
+
+  // number of points, not of candidates
+  size_t size() const { return m_rowStart.size() - 1; }
+
+  // the candidates of point, by increasing distance
+  std::span<const uint32_t> candidates(size_t point) const
+  {
+    return { m_candidates.data() + m_rowStart[point], m_candidates.data() + m_rowStart[point + 1] };
+  }
+
+  // the distances to the candidates of point, in the same order as candidates(point)
+  std::span<const nauticmiles_t> distances(size_t point) const
+  {
+    return { m_distances.data() + m_rowStart[point], m_distances.data() + m_rowStart[point + 1] };
+  }
+
+  void writeArtifact(ArtifactWriter &writer) const
+  {
+    writer.write(m_rowStart);
+    writer.write(m_candidates);
+    writer.write(m_distances);
+  }
+
+  static CandidateSet readArtifact(ArtifactReader &reader)
+  {
+    CandidateSet set;
+    set.m_rowStart = reader.readVector<uint32_t>();
+    set.m_candidates = reader.readVector<uint32_t>();
+    set.m_distances = reader.readVector<nauticmiles_t>();
+    // rows are read without bound checks, they must all lie in the candidates array
+    bool consistent = !set.m_rowStart.empty() && set.m_rowStart.front() == 0
+      && set.m_rowStart.back() == set.m_candidates.size() && set.m_distances.size() == set.m_candidates.size()
+      && std::is_sorted(set.m_rowStart.begin(), set.m_rowStart.end());
+    for (uint32_t candidate : set.m_candidates)
+      consistent &= candidate < set.size();
+    if (!consistent)
+      throw std::runtime_error("Inconsistent artifact");
+    return set;
+  }
+};
@@ -0,0 +1,519 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <assert.h>
+
+#include "geometry.h"
+#include "artifactcache.h"
+
+// Store distances on 4 bytes instead of 8, halves the memory used by the matrix at the
+// cost of precision (~1e-4 nautic miles on a 1000 nautic miles leg)
+//#define SINGLE_PRECISION_DISTANCES
+// Only store one half of the matrix, halves the memory used but adds a branch on every access
+//#define TRIANGULAR_DISTANCES_MATRIX
+
+/*
+ * Symmetric matrix of the distances between every pair of size points.
+ *
+ * The whole matrix lives in a single allocation aligned on a cache line. When
+ * Triangular is false rows are stored one after the other, padded to a multiple
+ * of the cache line size, when it is true only the lower half (i >= j) is stored,
+ * row i holding the i+1 distances to the points 0..i.
+ *
+ * A matrix read from an ArtifactCache does not own its array, it points into the
+ * mapped artifact and is read-only.
+ */
+template<class T, bool Triangular>
+class DistanceMatrix {
+public:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+  static constexpr bool QUANTIZED = false;
+
+private:
+  T *m_array;
+  size_t m_size;
+  size_t m_stride; // distance between two rows of the full matrix, in elements
+  std::shared_ptr<const void> m_storageOwner; // the mapped artifact m_array points into, null if m_array is owned
+
+public:
+  DistanceMatrix()
+    : m_array(nullptr), m_size(0), m_stride(0)
+  {
+  }
+
+  explicit DistanceMatrix(size_t size)
+    : m_array(nullptr), m_size(size), m_stride(computeStride(size))
+  {
+    m_array = allocate(elementCount());
+    std::fill(m_array, m_array + elementCount(), T(0));
+  }
+
+  DistanceMatrix(const DistanceMatrix &other)
+    : m_array(allocate(other.elementCount())), m_size(other.m_size), m_stride(other.m_stride)
+  {
+    std::copy(other.m_array, other.m_array + elementCount(), m_array);
+  }
+
+  DistanceMatrix(DistanceMatrix &&other) noexcept
+    : m_array(other.m_array), m_size(other.m_size), m_stride(other.m_stride), m_storageOwner(std::move(other.m_storageOwner))
+  {
+    other.m_array = nullptr;
+    other.m_size = other.m_stride = 0;
+  }
+
+  DistanceMatrix &operator=(DistanceMatrix other) noexcept
+  {
+    std::swap(m_array, other.m_array);
+    std::swap(m_size, other.m_size);
+    std::swap(m_stride, other.m_stride);
+    std::swap(m_storageOwner, other.m_storageOwner);
+    return *this;
+  }
+
+  ~DistanceMatrix()
+  {
+    if (!m_storageOwner)
+      deallocate(m_array);
+  }
+
+  size_t size() const { return m_size; }
+
+  T operator()(size_t i, size_t j) const
+  {
+    return m_array[index(i, j)];
+  }
+
+  // same as operator(), see QuantizedDistanceMatrix
+  T exact(size_t i, size_t j) const
+  {
+    return m_array[index(i, j)];
+  }
+
+  // sets both (i,j) and (j,i)
+  void set(size_t i, size_t j, T value)
+  {
+    assert(!m_storageOwner);
+    m_array[index(i, j)] = value;
+    if constexpr (!Triangular)
+      m_array[index(j, i)] = value;
+  }
+
+  /*
+   * Computes the distances between all pairs of points, only one half of the
+   * matrix is computed, rows are spread over threadCount threads (0 meaning one
+   * per hardware thread).
+   */
+  static DistanceMatrix compute(const std::vector<geometry::UnitVector> &points, unsigned int threadCount = 0)
+  {
+    return computeConverted(points, NoConversion{}, threadCount);
+  }
+
+  /*
+   * Same as compute, each distance d is stored as convert(d). Used to build
+   * matrices of non-floating point types.
+   */
+  template<class Converter>
+  static DistanceMatrix computeConverted(const std::vector<geometry::UnitVector> &points, const Converter &convert, unsigned int threadCount = 0)
+  {
+    DistanceMatrix matrix(points.size());
+    size_t size = points.size();
+    if (threadCount == 0)
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = (unsigned int)std::min<size_t>(threadCount, std::max<size_t>(1, size / 64));
+
+    // row i holds the distances to points 0..i, rows are interleaved between
+    // threads so that each of them gets its share of short and long rows
+    auto computeRows = [&](unsigned int firstRow) {
+      std::vector<nauticmiles_t> buffer(size);
+      for (size_t i = firstRow; i < size; i += threadCount) {
+        T *row = matrix.m_array + matrix.index(i, 0);
+        if constexpr (std::is_same_v<T, nauticmiles_t> && std::is_same_v<Converter, NoConversion>) {
+          geometry::distances(points[i], points.data(), i + 1, row);
+        } else if constexpr (std::is_same_v<Converter, NoConversion>) {
+          geometry::distances(points[i], points.data(), i + 1, buffer.data());
+          std::copy(buffer.begin(), buffer.begin() + i + 1, row);
+        } else {
+          geometry::distances(points[i], points.data(), i + 1, buffer.data());
+          std::transform(buffer.begin(), buffer.begin() + i + 1, row, convert);
+        }
+      }
+    };
+    // mirrors the lower half onto the upper half, by blocks to stay in the cache
+    auto mirrorRows = [&](unsigned int firstBlock) {
+      constexpr size_t BLOCK = CACHE_LINE_SIZE / sizeof(T) * 4;
+      for (size_t bi = firstBlock * BLOCK; bi < size; bi += threadCount * BLOCK) {
+        for (size_t bj = bi; bj < size; bj += BLOCK) {
+          for (size_t i = bi; i < std::min(bi + BLOCK, size); i++) {
+            for (size_t j = std::max(bj, i + 1); j < std::min(bj + BLOCK, size); j++)
+              matrix.m_array[matrix.index(i, j)] = matrix.m_array[matrix.index(j, i)];
+          }
+        }
+      }
+    };
+
+    runOnThreads(threadCount, computeRows);
+    if constexpr (!Triangular)
+      runOnThreads(threadCount, mirrorRows);
+
+    return matrix;
+  }
+
+  void writeArtifact(ArtifactWriter &writer) const
+  {
+    writer.writeValue<uint64_t>(m_size);
+    writer.write(std::span<const T>(m_array, elementCount()));
+  }
+
+  // the matrix is used in place, the artifact stays mapped as long as the matrix lives
+  static DistanceMatrix readArtifact(ArtifactReader &reader)
+  {
+    DistanceMatrix matrix;
+    size_t size = (size_t)reader.readValue<uint64_t>();
+    matrix.m_size = size;
+    matrix.m_stride = computeStride(size);
+    std::span<const T> elements = reader.read<T>(matrix.elementCount());
+    if (reinterpret_cast<uintptr_t>(elements.data()) % CACHE_LINE_SIZE != 0)
+      throw std::runtime_error("Misaligned artifact array");
+    matrix.m_array = const_cast<T *>(elements.data());
+    matrix.m_storageOwner = reader.getOwner();
+    return matrix;
+  }
+
+private:
+  struct NoConversion {};
+
+  static size_t computeStride(size_t size)
+  {
+    constexpr size_t elementsPerLine = CACHE_LINE_SIZE / sizeof(T);
+    return (size + elementsPerLine - 1) / elementsPerLine * elementsPerLine;
+  }
+
+  size_t elementCount() const
+  {
+    if constexpr (Triangular)
+      return m_size * (m_size + 1) / 2;
+    else
+      return m_size * m_stride;
+  }
+
+  size_t index(size_t i, size_t j) const
+  {
+    assert(i < m_size && j < m_size);
+    if constexpr (Triangular) {
+      if (i < j) std::swap(i, j);
+      return i * (i + 1) / 2 + j;
+    } else {
+      return i * m_stride + j;
+    }
+  }
+
+  static T *allocate(size_t count)
+  {
+    if (count == 0)
+      return nullptr;
+    size_t bytes = (count * sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    return static_cast<T *>(::operator new(bytes, std::align_val_t{ CACHE_LINE_SIZE }));
+  }
+
+  static void deallocate(T *array)
+  {
+    if (array != nullptr)
+      ::operator delete(array, std::align_val_t{ CACHE_LINE_SIZE });
+  }
+
+  template<class F>
+  static void runOnThreads(unsigned int threadCount, F &task)
+  {
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < threadCount; t++)
+      threads.emplace_back(task, t);
+    task(0);
+    for (std::thread &thread : threads)
+      thread.join();
+  }
+};
+
+/*
+ * Distance matrix storing each distance on 16 bits, 4 times less memory than a
+ * double precision matrix so that maps of tens of thousands of stations fit in
+ * memory (20k stations take 800MB, half of it if Triangular).
+ *
+ * Distances are stored as multiples of a step chosen per map so that the longest
+ * distance between two points of the map fits in 16 bits (a few hundredths of a
+ * nautic mile for France). Quantized distances may be equal where the real ones
+ * are not, exact(i,j) recomputes the distance from the points and should be used
+ * to break these ties.
+ */
+template<bool Triangular>
+class QuantizedDistanceMatrix {
+public:
+  typedef uint16_t quantized_t;
+  static constexpr bool QUANTIZED = true;
+
+private:
+  DistanceMatrix<quantized_t, Triangular> m_matrix;
+  std::vector<geometry::UnitVector> m_points;
+  nauticmiles_t m_step;
+
+public:
+  QuantizedDistanceMatrix()
+    : m_step(0)
+  {
+  }
+
+  size_t size() const { return m_matrix.size(); }
+
+  // the quantized distance, multiply by getStep() to get nautic miles
+  quantized_t operator()(size_t i, size_t j) const
+  {
+    return m_matrix(i, j);
+  }
+
+  nauticmiles_t exact(size_t i, size_t j) const
+  {
+    return geometry::distance(m_points[i], m_points[j]);
+  }
+
+  nauticmiles_t getStep() const { return m_step; }
+
+  void writeArtifact(ArtifactWriter &writer) const
+  {
+    writer.writeValue(m_step);
+    writer.write(m_points);
+    m_matrix.writeArtifact(writer);
+  }
+
+  static QuantizedDistanceMatrix readArtifact(ArtifactReader &reader)
+  {
+    QuantizedDistanceMatrix matrix;
+    matrix.m_step = reader.readValue<nauticmiles_t>();
+    matrix.m_points = reader.readVector<geometry::UnitVector>();
+    matrix.m_matrix = DistanceMatrix<quantized_t, Triangular>::readArtifact(reader);
+    if (matrix.m_points.size() != matrix.m_matrix.size())
+      throw std::runtime_error("Inconsistent artifact");
+    return matrix;
+  }
+
+  static QuantizedDistanceMatrix compute(const std::vector<geometry::UnitVector> &points, unsigned int threadCount = 0)
+  {
+    QuantizedDistanceMatrix matrix;
+    matrix.m_points = points;
+
+    // by the triangle inequality no distance exceeds twice the greatest distance to any given point
+    nauticmiles_t maxDistance = 0;
+    if (!points.empty()) {
+      std::vector<nauticmiles_t> distancesToFirst(points.size());
+      geometry::distances(points[0], points.data(), points.size(), distancesToFirst.data());
+      maxDistance = 2 * *std::max_element(distancesToFirst.begin(), distancesToFirst.end());
+    }
+    maxDistance = std::min<nauticmiles_t>(maxDistance, geometry::PI * geography::EARTH_RADIUS_NM);
+    matrix.m_step = std::max<nauticmiles_t>(maxDistance, 1) / std::numeric_limits<quantized_t>::max();
+
+    const nauticmiles_t inverseStep = 1 / matrix.m_step;
+    matrix.m_matrix = DistanceMatrix<quantized_t, Triangular>::computeConverted(points, [inverseStep](nauticmiles_t distance) {
+      return (quantized_t)std::min<nauticmiles_t>(std::round(distance * inverseStep), std::numeric_limits<quantized_t>::max());
+    }, threadCount);
+
+    return matrix;
+  }
+};
+
+/*
+ * Distances computed on demand with the spherical law of cosines, from the
+ * points' unit vectors (see geometry::distance). Same interface as a
+ * DistanceMatrix, exact and without its N^2 storage but each distance costs
+ * an acos.
+ */
+class SphericalDistances {
+public:
+  static constexpr bool QUANTIZED = false;
+
+private:
+  std::vector<geometry::UnitVector> m_points;
+
+public:
+  size_t size() const { return m_points.size(); }
+
+  nauticmiles_t operator()(size_t i, size_t j) const
+  {
+    assert(i < m_points.size() && j < m_points.size());
+    return geometry::distance(m_points[i], m_points[j]);
+  }
+
+  nauticmiles_t exact(size_t i, size_t j) const
+  {
+    return operator()(i, j);
+  }
+
+  static SphericalDistances compute(const std::vector<geometry::UnitVector> &points)
+  {
+    SphericalDistances distances;
+    distances.m_points = points;
+    return distances;
+  }
+};
+
+/*
+ * Distances computed on demand with the haversine formula. Same results as
+ * SphericalDistances but better conditioned for very close points (the acos
+ * of the law of cosines is only precise to ~1e-4 nautic miles), at the cost
+ * of an asin, a sqrt and two sin.
+ */
+class HaversineDistances {
+public:
+  static constexpr bool QUANTIZED = false;
+
+private:
+  struct Point {
+    double lat, lon, cosLat; // radians
+  };
+  std::vector<Point> m_points;
+
+public:
+  size_t size() const { return m_points.size(); }
+
+  nauticmiles_t operator()(size_t i, size_t j) const
+  {
+    assert(i < m_points.size() && j < m_points.size());
+    const Point &p1 = m_points[i], &p2 = m_points[j];
+    double sinHalfDLat = sin((p2.lat - p1.lat) / 2);
+    double sinHalfDLon = sin((p2.lon - p1.lon) / 2);
+    double h = sinHalfDLat * sinHalfDLat + p1.cosLat * p2.cosLat * sinHalfDLon * sinHalfDLon;
+    return 2 * asin(std::min(1., std::sqrt(h))) * geography::EARTH_RADIUS_NM;
+  }
+
+  nauticmiles_t exact(size_t i, size_t j) const
+  {
+    return operator()(i, j);
+  }
+
+  static HaversineDistances compute(const std::vector<Location> &locations)
+  {
+    HaversineDistances distances;
+    distances.m_points.reserve(locations.size());
+    for (const Location &location : locations) {
+      double lat = geometry::deg2rad(location.lat);
+      distances.m_points.push_back({ lat, geometry::deg2rad(location.lon), cos(lat) });
+    }
+    return distances;
+  }
+};
+
+/*
+ * Distances computed on demand from the points' positions on a local projection
+ * (see geometry::PlanarProjection), with the same interface as a DistanceMatrix
+ * but without its N^2 storage. A distance costs a sqrt, comparisons can skip it
+ * by reading squared(i,j) instead.
+ *
+ * Only suited to regional maps, distances are overestimated by at most
+ * getMaxRelativeError() (0.2% for mainland France). Use exact distances for the reported
+ * lengths of paths.
+ */
+class PlanarDistances {
+public:
+  static constexpr bool QUANTIZED = false;
+
+private:
+  std::vector<geometry::PlanarPoint> m_points;
+  double m_maxRelativeError;
+
+public:
+  PlanarDistances()
+    : m_maxRelativeError(0)
+  {
+  }
+
+  size_t size() const { return m_points.size(); }
+
+  float operator()(size_t i, size_t j) const
+  {
+    return std::sqrt(squared(i, j));
+  }
+
+  // same as operator(), see QuantizedDistanceMatrix
+  float exact(size_t i, size_t j) const
+  {
+    return std::sqrt(squared(i, j));
+  }
+
+  float squared(size_t i, size_t j) const
+  {
+    assert(i < m_points.size() && j < m_points.size());
+    return geometry::squaredDistance(m_points[i], m_points[j]);
+  }
+
+  double getMaxRelativeError() const { return m_maxRelativeError; }
+
+  // projects the points around their centroid
+  static PlanarDistances compute(const std::vector<geometry::UnitVector> &points)
+  {
+    PlanarDistances distances;
+    const geometry::PlanarProjection projection = geometry::PlanarProjection::aroundCentroid(points.data(), points.size());
+    distances.m_points.reserve(points.size());
+    for (const geometry::UnitVector &point : points)
+      distances.m_points.push_back(projection.project(point));
+    distances.m_maxRelativeError = geometry::PlanarProjection::maxRelativeError(projection.radius(points.data(), points.size()));
+    return distances;
+  }
+};
+
+/*
+ * Read-only view of a distance matrix where the distance between points a and b
+ * is 0. Used to force an edge into a tour without copying the whole matrix.
+ */
+template<class Matrix>
+class ZeroEdgeOverlay {
+public:
+  static constexpr bool QUANTIZED = Matrix::QUANTIZED;
+
+private:
+  const Matrix &m_matrix;
+  size_t m_a;
+  size_t m_b;
+
+public:
+  ZeroEdgeOverlay(const Matrix &matrix, size_t a, size_t b)
+    : m_matrix(matrix), m_a(a), m_b(b)
+  {
+  }
+
+  size_t size() const { return m_matrix.size(); }
+
+  auto operator()(size_t i, size_t j) const
+  {
+    // written without short-circuits so that it compiles to a conditional move
+    // rather than a branch, this is called in the innermost loops of the tsp solvers
+    bool isEdge = ((i == m_a) & (j == m_b)) | ((i == m_b) & (j == m_a));
+    auto distance = m_matrix(i, j);
+    return isEdge ? decltype(distance)(0) : distance;
+  }
+
+  auto exact(size_t i, size_t j) const
+  {
+    bool isEdge = ((i == m_a) & (j == m_b)) | ((i == m_b) & (j == m_a));
+    auto distance = m_matrix.exact(i, j);
+    return isEdge ? decltype(distance)(0) : distance;
+  }
+};
+
+#ifdef SINGLE_PRECISION_DISTANCES
+typedef float matrixdistance_t;
+#else
+typedef nauticmiles_t matrixdistance_t;
+#endif
+
+#ifdef TRIANGULAR_DISTANCES_MATRIX
+typedef DistanceMatrix<matrixdistance_t, true> StationDistanceMatrix;
+typedef QuantizedDistanceMatrix<true> QuantizedStationDistanceMatrix;
+#else
+typedef DistanceMatrix<matrixdistance_t, false> StationDistanceMatrix;
+typedef QuantizedDistanceMatrix<false> QuantizedStationDistanceMatrix;
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "pathsolver.h"
+
+/*
+ * The ways a solver can measure the distance between two stations of a map.
+ *
+ * Solvers are written as templates over a distance source (SphericalDistances,
+ * HaversineDistances, PlanarDistances, StationDistanceMatrix...) so that their
+ * hot loops inline it, a source is built once per solve and reads the distance
+ * between two stations from their indices in the map:
+ *   operator()(i, j)  the distance between stations i and j
+ *   exact(i, j)       the distance used to break ties, see QuantizedDistanceMatrix
+ *   QUANTIZED         whether operator() may report equal distances where exact() does not,
+ *                     quantized distances are not in nautic miles, see nauticMilesBetween
+ *
+ * The source is chosen per run, trading accuracy for speed or memory, with
+ * withDistancePolicy. The main window lists the policies in this order.
+ */
+enum class DistancePolicy {
+  SPHERICAL,        // exact, spherical law of cosines
+  HAVERSINE,        // exact, better conditioned than SPHERICAL for very close stations
+  PLANAR,           // local projection, ~0.2% error on France, regional maps only
+  MATRIX,           // exact, precomputed, N^2 memory
+  QUANTIZED_MATRIX, // precomputed on 16 bits, a quarter of MATRIX's memory
+};
+
+/*
+ * Builds the distance source of the given policy for map and returns
+ * solve(source). solve is usually a generic lambda, instantiated once per
+ * policy. Matrices are read from cache when it is not null.
+ */
+template<class Solve>
+auto withDistancePolicy(DistancePolicy policy, const ProblemMap &map, Solve &&solve, const ArtifactCache *cache = nullptr)
+{
+  switch (policy) {
+  case DistancePolicy::HAVERSINE:        return solve(getHaversineDistances(map));
+  case DistancePolicy::PLANAR:           return solve(getPlanarDistances(map));
+  case DistancePolicy::MATRIX:           return solve(getDistancesMatrix(map, cache));
+  case DistancePolicy::QUANTIZED_MATRIX: return solve(getQuantizedDistancesMatrix(map, cache));
+  case DistancePolicy::SPHERICAL:
+  default:                               return solve(getSphericalDistances(map));
+  }
+}
+
+/*
+ * The distance between stations i and j in nautic miles, for solvers that need
+ * actual distances rather than comparable ones.
+ */
+template<class Distances>
+inline nauticmiles_t nauticMilesBetween(const Distances &distances, size_t i, size_t j)
+{
+  if constexpr (Distances::QUANTIZED)
+    return distances(i, j) * distances.getStep();
+  else
+    return distances(i, j);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <vector>
+#include <assert.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * A bitset sized at runtime, for sets of stations of maps whose size is not
+ * known at compile time (see SpecificBitSet for the compile time version).
+ * Operations between two sets (which must have the same size) work on whole
+ * words, 4 words at a time when AVX2 is available.
+ */
+class DynamicBitSet {
+private:
+  using word_t = unsigned long long;
+  static constexpr size_t WORD_SIZE = sizeof(word_t) * CHAR_BIT;
+  static constexpr size_t VECTOR_WORD_COUNT = 4; // words per AVX2 register
+  std::vector<word_t> m_array;
+  size_t m_size;
+
+public:
+  DynamicBitSet()
+    : m_size(0)
+  {
+  }
+
+  explicit DynamicBitSet(size_t size)
+    : m_array((size + WORD_SIZE - 1) / WORD_SIZE), m_size(size)
+  {
+  }
+
+  size_t size() const { return m_size; }
+
+  inline bool isSet(size_t idx) const
+  {
+    return m_array[idx / WORD_SIZE] & (1ull << (idx & (WORD_SIZE - 1)));
+  }
+
+  inline void setSet(size_t idx)
+  {
+    m_array[idx / WORD_SIZE] |= 1ull << (idx & (WORD_SIZE - 1));
+  }
+
+  inline void resetSet(size_t idx)
+  {
+    m_array[idx / WORD_SIZE] &= ~(1ull << (idx & (WORD_SIZE - 1)));
+  }
+
+  // adds an element at index size(), set if value is true
+  void pushBack(bool value)
+  {
+    if (m_size % WORD_SIZE == 0)
+      m_array.push_back(0);
+    m_array.back() |= (word_t)value << (m_size % WORD_SIZE);
+    m_size++;
+  }
+
+  void reserve(size_t size)
+  {
+    m_array.reserve((size + WORD_SIZE - 1) / WORD_SIZE);
+  }
+
+  void clear()
+  {
+    std::fill(m_array.begin(), m_array.end(), 0);
+  }
+
+  // this = this | other
+  DynamicBitSet &operator|=(const DynamicBitSet &other)
+  {
+    assert(m_size == other.m_size);
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + VECTOR_WORD_COUNT <= m_array.size(); i += VECTOR_WORD_COUNT)
+      storeVector(i, _mm256_or_si256(loadVector(i), other.loadVector(i)));
+#endif
+    for (; i < m_array.size(); i++)
+      m_array[i] |= other.m_array[i];
+    return *this;
+  }
+
+  // this = this & other
+  DynamicBitSet &operator&=(const DynamicBitSet &other)
+  {
+    assert(m_size == other.m_size);
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + VECTOR_WORD_COUNT <= m_array.size(); i += VECTOR_WORD_COUNT)
+      storeVector(i, _mm256_and_si256(loadVector(i), other.loadVector(i)));
+#endif
+    for (; i < m_array.size(); i++)
+      m_array[i] &= other.m_array[i];
+    return *this;
+  }
+
+  // this = this & ~other, removes the elements of other
+  DynamicBitSet &andNot(const DynamicBitSet &other)
+  {
+    assert(m_size == other.m_size);
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + VECTOR_WORD_COUNT <= m_array.size(); i += VECTOR_WORD_COUNT)
+      storeVector(i, _mm256_andnot_si256(other.loadVector(i), loadVector(i)));
+#endif
+    for (; i < m_array.size(); i++)
+      m_array[i] &= ~other.m_array[i];
+    return *this;
+  }
+
+  // true if every element of other is in this set
+  bool contains(const DynamicBitSet &other) const
+  {
+    assert(m_size == other.m_size);
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + VECTOR_WORD_COUNT <= m_array.size(); i += VECTOR_WORD_COUNT)
+      if (!_mm256_testc_si256(loadVector(i), other.loadVector(i)))
+        return false;
+#endif
+    for (; i < m_array.size(); i++)
+      if (other.m_array[i] & ~m_array[i])
+        return false;
+    return true;
+  }
+
+  bool none() const
+  {
+    for (word_t word : m_array)
+      if (word)
+        return false;
+    return true;
+  }
+
+  size_t count() const
+  {
+    size_t count = 0;
+    for (word_t word : m_array)
+      count += std::popcount(word);
+    return count;
+  }
+
+  // calls function(size_t idx) for each element, in increasing order
+  template<class Function>
+  void forEach(Function &&function) const
+  {
+    for (size_t i = 0; i < m_array.size(); i++) {
+      for (word_t word = m_array[i]; word; word &= word - 1)
+        function(i * WORD_SIZE + std::countr_zero(word));
+    }
+  }
+
+private:
+#if defined(__AVX2__)
+  inline __m256i loadVector(size_t wordIdx) const
+  {
+    return _mm256_loadu_si256((const __m256i *)&m_array[wordIdx]);
+  }
+
+  inline void storeVector(size_t wordIdx, __m256i vector)
+  {
+    _mm256_storeu_si256((__m256i *)&m_array[wordIdx], vector);
+  }
+#endif
+};
@@ -4,6 +4,7 @@
 
 #include "station.h"
 #include "geometry.h"
+#include "distancematrix.h"
 
 class GeoMap {
 private:
@@ -15,16 +16,20 @@ public:
     const std::vector<Station> &getStations() const { return m_stations; }
     std::vector<Station> &getStations() { return m_stations; }
     void setStations(const std::vector<Station> &stations) { m_stations = stations; }
+    void setStations(std::vector<Station> &&stations) { m_stations = std::move(stations); }
 
-    std::vector<std::vector<nauticmiles_t>> getDistances() const {
-        std::vector<std::vector<nauticmiles_t>> distances(m_stations.size(), std::vector<nauticmiles_t>(m_stations.size(), 0));
-
-        for (size_t i = 0; i < m_stations.size(); ++i) {
-            for (size_t j = 0; j < m_stations.size(); ++j) {
-                distances[i][j] = geometry::distance(m_stations[i].getLocation(), m_stations[j].getLocation());
-            }
-        }
+    // Gives every station a new id, the serializers call it once the stations are parsed
+    void assignStationIds() {
+        stationid_t id = Station::reserveIds(m_stations.size());
+        for (Station &station : m_stations)
+            station.setId(id++);
+    }
 
-        return distances;
+    StationDistanceMatrix getDistances() const {
+        std::vector<geometry::UnitVector> vectors;
+        vectors.reserve(m_stations.size());
+        for (const Station &station : m_stations)
+            vectors.push_back(geometry::toUnitVector(station.getLocation()));
+        return StationDistanceMatrix::compute(vectors);
     }
 };
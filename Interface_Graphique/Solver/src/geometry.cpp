@@ -0,0 +1,346 @@
+#include "geometry.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Batched distance kernel
+ *
+ * geometry::distance is dominated by libm calls (2 sin, 2 cos, 1 acos
+ * per pair), when computing the distances from one origin to many
+ * locations the origin's trigonometry only needs to be computed once
+ * and the remaining sin/cos/acos can be evaluated several lanes at a
+ * time with polynomial approximations.
+ *
+ * The instruction set is chosen at compile time (/arch:AVX2 or
+ * /arch:AVX512 with msvc, -mavx2 -mfma or -mavx512f with gcc/clang),
+ * when none is available the scalar implementation is used. The project
+ * files enable AVX2 and FMA unless disabled (CONFIG+=no_avx2 with qmake,
+ * -DFLIGHTPATH_AVX2=OFF with cmake).
+ *
+ * Polynomials are the cephes double precision ones, sin/cos are
+ * evaluated on [-pi/4,pi/4] after a Cody-Waite reduction and acos is
+ * derived from asin on [0,.5], results match geometry::distance to
+ * ~1e-7 nautic miles.
+ */
+
+static_assert(sizeof(Location) == 2 * sizeof(double), "locations are read as contiguous (lon,lat) pairs");
+static_assert(sizeof(geometry::UnitVector) == 3 * sizeof(double), "unit vectors are read as contiguous (x,y,z) triplets");
+
+namespace {
+
+#if defined(__AVX512F__)
+
+constexpr size_t LANES = 8;
+typedef __m512d vdouble;
+typedef __mmask8 vmask;
+
+inline vdouble vset1(double x) { return _mm512_set1_pd(x); }
+inline void vstore(double *p, vdouble x) { _mm512_storeu_pd(p, x); }
+inline vdouble vadd(vdouble a, vdouble b) { return _mm512_add_pd(a, b); }
+inline vdouble vsub(vdouble a, vdouble b) { return _mm512_sub_pd(a, b); }
+inline vdouble vmul(vdouble a, vdouble b) { return _mm512_mul_pd(a, b); }
+inline vdouble vdiv(vdouble a, vdouble b) { return _mm512_div_pd(a, b); }
+inline vdouble vfmadd(vdouble a, vdouble b, vdouble c) { return _mm512_fmadd_pd(a, b, c); }
+inline vdouble vsqrt(vdouble a) { return _mm512_sqrt_pd(a); }
+inline vdouble vmin(vdouble a, vdouble b) { return _mm512_min_pd(a, b); }
+inline vdouble vmax(vdouble a, vdouble b) { return _mm512_max_pd(a, b); }
+inline vdouble vabs(vdouble a) { return _mm512_abs_pd(a); }
+inline vdouble vround(vdouble a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline vdouble vfloor(vdouble a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline vmask vgt(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+inline vmask vlt(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+inline vmask vand(vmask a, vmask b) { return a & b; }
+inline vdouble vselect(vmask m, vdouble a, vdouble b) { return _mm512_mask_blend_pd(m, b, a); }
+
+// loads the longitudes (offset=0) or latitudes (offset=1) of LANES consecutive locations
+inline vdouble vloadLocations(const Location *locations, int offset)
+{
+  const __m512i indices = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+  return _mm512_i64gather_pd(indices, (const double *)locations + offset, sizeof(double));
+}
+
+// loads the x (offset=0), y (offset=1) or z (offset=2) components of LANES consecutive unit vectors
+inline vdouble vloadUnitVectors(const geometry::UnitVector *vectors, int offset)
+{
+  const __m512i indices = _mm512_set_epi64(21, 18, 15, 12, 9, 6, 3, 0);
+  return _mm512_i64gather_pd(indices, (const double *)vectors + offset, sizeof(double));
+}
+
+#elif defined(__AVX2__)
+
+constexpr size_t LANES = 4;
+typedef __m256d vdouble;
+typedef __m256d vmask;
+
+inline vdouble vset1(double x) { return _mm256_set1_pd(x); }
+inline void vstore(double *p, vdouble x) { _mm256_storeu_pd(p, x); }
+inline vdouble vadd(vdouble a, vdouble b) { return _mm256_add_pd(a, b); }
+inline vdouble vsub(vdouble a, vdouble b) { return _mm256_sub_pd(a, b); }
+inline vdouble vmul(vdouble a, vdouble b) { return _mm256_mul_pd(a, b); }
+inline vdouble vdiv(vdouble a, vdouble b) { return _mm256_div_pd(a, b); }
+#if defined(__FMA__) || defined(_MSC_VER)
+inline vdouble vfmadd(vdouble a, vdouble b, vdouble c) { return _mm256_fmadd_pd(a, b, c); }
+#else
+inline vdouble vfmadd(vdouble a, vdouble b, vdouble c) { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+#endif
+inline vdouble vsqrt(vdouble a) { return _mm256_sqrt_pd(a); }
+inline vdouble vmin(vdouble a, vdouble b) { return _mm256_min_pd(a, b); }
+inline vdouble vmax(vdouble a, vdouble b) { return _mm256_max_pd(a, b); }
+inline vdouble vabs(vdouble a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a); }
+inline vdouble vround(vdouble a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline vdouble vfloor(vdouble a) { return _mm256_floor_pd(a); }
+inline vmask vgt(vdouble a, vdouble b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+inline vmask vlt(vdouble a, vdouble b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+inline vmask vand(vmask a, vmask b) { return _mm256_and_pd(a, b); }
+inline vdouble vselect(vmask m, vdouble a, vdouble b) { return _mm256_blendv_pd(b, a, m); }
+
+// loads the longitudes (offset=0) or latitudes (offset=1) of LANES consecutive locations
+inline vdouble vloadLocations(const Location *locations, int offset)
+{
+  const __m256i indices = _mm256_set_epi64x(6, 4, 2, 0);
+  return _mm256_i64gather_pd((const double *)locations + offset, indices, sizeof(double));
+}
+
+// loads the x (offset=0), y (offset=1) or z (offset=2) components of LANES consecutive unit vectors
+inline vdouble vloadUnitVectors(const geometry::UnitVector *vectors, int offset)
+{
+  const __m256i indices = _mm256_set_epi64x(9, 6, 3, 0);
+  return _mm256_i64gather_pd((const double *)vectors + offset, indices, sizeof(double));
+}
+
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+
+#define SIMD_DISTANCES
+
+// evaluates c[0]*x^(N-1) + c[1]*x^(N-2) + ... + c[N-1]
+template<size_t N>
+inline vdouble vpolynomial(vdouble x, const double (&c)[N])
+{
+  vdouble y = vset1(c[0]);
+  for (size_t i = 1; i < N; i++)
+    y = vfmadd(y, x, vset1(c[i]));
+  return y;
+}
+
+constexpr double SIN_COEFFICIENTS[] = {
+  1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+  -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1,
+};
+constexpr double COS_COEFFICIENTS[] = {
+  -1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+  2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2,
+};
+constexpr double ASIN_P_COEFFICIENTS[] = {
+  4.253011369004428248960E-3, -6.019598008014123785661E-1, 5.444622390564711410273E0,
+  -1.626247967210700244449E1, 1.956261983317594739197E1, -8.198089802484824371615E0,
+};
+constexpr double ASIN_Q_COEFFICIENTS[] = {
+  1.0, -1.474091372988853791896E1, 7.049610280856842141659E1,
+  -1.471791292232726029859E2, 1.395105614657485689735E2, -4.918853881490881290097E1,
+};
+
+// sine and cosine of x, for |x| < 2^20 (ie. any reasonable angle in radians)
+inline void vsincos(vdouble x, vdouble &s, vdouble &c)
+{
+  constexpr double TWO_OVER_PI = 0.636619772367581343076;
+  constexpr double PIO2_HIGH = 1.57079632673412561417e+00; // pi/2 split in two parts to
+  constexpr double PIO2_LOW = 6.07710050650619224932e-11;  // keep the reduction exact
+
+  // x = q*pi/2 + r with |r| <= pi/4
+  vdouble q = vround(vmul(x, vset1(TWO_OVER_PI)));
+  vdouble r = vfmadd(q, vset1(-PIO2_HIGH), x);
+  r = vfmadd(q, vset1(-PIO2_LOW), r);
+  vdouble z = vmul(r, r);
+
+  vdouble sinr = vfmadd(vmul(r, z), vpolynomial(z, SIN_COEFFICIENTS), r);
+  vdouble cosr = vfmadd(vmul(z, z), vpolynomial(z, COS_COEFFICIENTS), vfmadd(z, vset1(-.5), vset1(1.)));
+
+  // quadrant in 0..3, sin/cos swap on odd quadrants and change sign on some of them
+  vdouble quadrant = vsub(q, vmul(vset1(4.), vfloor(vmul(q, vset1(.25)))));
+  vdouble parity = vsub(quadrant, vmul(vset1(2.), vfloor(vmul(quadrant, vset1(.5)))));
+  vmask odd = vgt(parity, vset1(.5));
+  vmask sinNegative = vgt(quadrant, vset1(1.5));
+  vmask cosNegative = vand(vgt(quadrant, vset1(.5)), vlt(quadrant, vset1(2.5)));
+
+  vdouble s0 = vselect(odd, cosr, sinr);
+  vdouble c0 = vselect(odd, sinr, cosr);
+  s = vselect(sinNegative, vsub(vset1(0.), s0), s0);
+  c = vselect(cosNegative, vsub(vset1(0.), c0), c0);
+}
+
+// arc cosine of x, x must be in range -1..1
+inline vdouble vacos(vdouble x)
+{
+  constexpr double PI = 3.14159265358979323846;
+
+  // acos(x) = pi/2 - asin(x)          if |x| <= .5
+  // acos(x) = 2*asin(sqrt((1-x)/2))   if x > .5
+  // acos(x) = pi - acos(-x)           if x < -.5
+  vdouble a = vabs(x);
+  vmask big = vgt(a, vset1(.5));
+  vdouble y = vselect(big, vsqrt(vmul(vsub(vset1(1.), a), vset1(.5))), x);
+  vdouble z = vmul(y, y);
+  vdouble asiny = vfmadd(vmul(y, z), vdiv(vpolynomial(z, ASIN_P_COEFFICIENTS), vpolynomial(z, ASIN_Q_COEFFICIENTS)), y);
+
+  vdouble bigResult = vadd(asiny, asiny);
+  bigResult = vselect(vlt(x, vset1(0.)), vsub(vset1(PI), bigResult), bigResult);
+  vdouble smallResult = vsub(vset1(PI / 2), asiny);
+  return vselect(big, bigResult, smallResult);
+}
+
+#endif
+
+} // !namespace
+
+namespace geometry {
+
+void distances(const Location &origin, const Location *locations, size_t count, nauticmiles_t *out)
+{
+  const double originLon = deg2rad(origin.lon);
+  const double originLat = deg2rad(origin.lat);
+  const double originSinLat = sin(originLat);
+  const double originCosLat = cos(originLat);
+
+  size_t i = 0;
+
+#ifdef SIMD_DISTANCES
+  const vdouble degToRad = vset1((double)(PI / 180));
+  const vdouble vOriginLon = vset1(originLon);
+  const vdouble vOriginSinLat = vset1(originSinLat);
+  const vdouble vOriginCosLat = vset1(originCosLat);
+
+  for (; i + LANES <= count; i += LANES) {
+    vdouble lon = vmul(vloadLocations(locations + i, 0), degToRad);
+    vdouble lat = vmul(vloadLocations(locations + i, 1), degToRad);
+    vdouble sinLat, cosLat, sinDeltaLon, cosDeltaLon;
+    vsincos(lat, sinLat, cosLat);
+    vsincos(vsub(lon, vOriginLon), sinDeltaLon, cosDeltaLon);
+    // same formula as geometry::distance, clamped because rounding errors may get it slightly out of -1..1
+    vdouble cosAngle = vfmadd(vmul(vOriginCosLat, cosLat), cosDeltaLon, vmul(vOriginSinLat, sinLat));
+    cosAngle = vmax(vset1(-1.), vmin(vset1(1.), cosAngle));
+    vstore(out + i, vmul(vacos(cosAngle), vset1(geography::EARTH_RADIUS_NM)));
+  }
+#endif
+
+  // scalar fallback, also used for the remaining locations when count is not a multiple of the vector size
+  for (; i < count; i++) {
+    double lon = deg2rad(locations[i].lon);
+    double lat = deg2rad(locations[i].lat);
+    double cosAngle = originSinLat * sin(lat) + originCosLat * cos(lat) * cos(lon - originLon);
+    out[i] = acos(std::max(-1., std::min(1., cosAngle))) * geography::EARTH_RADIUS_NM;
+  }
+}
+
+void distances(const UnitVector &origin, const UnitVector *vectors, size_t count, nauticmiles_t *out)
+{
+  size_t i = 0;
+
+#ifdef SIMD_DISTANCES
+  const vdouble originX = vset1(origin.x);
+  const vdouble originY = vset1(origin.y);
+  const vdouble originZ = vset1(origin.z);
+
+  for (; i + LANES <= count; i += LANES) {
+    vdouble cosAngle = vmul(originX, vloadUnitVectors(vectors + i, 0));
+    cosAngle = vfmadd(originY, vloadUnitVectors(vectors + i, 1), cosAngle);
+    cosAngle = vfmadd(originZ, vloadUnitVectors(vectors + i, 2), cosAngle);
+    cosAngle = vmax(vset1(-1.), vmin(vset1(1.), cosAngle));
+    vstore(out + i, vmul(vacos(cosAngle), vset1(geography::EARTH_RADIUS_NM)));
+  }
+#endif
+
+  for (; i < count; i++)
+    out[i] = distance(origin, vectors[i]);
+}
+
+void legs(const Location *locations, size_t count, double *caps, nauticmiles_t *distances)
+{
+  double previousSinLat = 0, previousCosLat = 0, previousSinLon = 0, previousCosLon = 0;
+  for (size_t i = 0; i < count; i++) {
+    double lat = deg2rad(locations[i].lat), lon = deg2rad(locations[i].lon);
+    double sinLat = sin(lat), cosLat = cos(lat), sinLon = sin(lon), cosLon = cos(lon);
+    if (i > 0) {
+      // sin and cos of the longitude difference, from the ones of both longitudes
+      double sinDLon = sinLon * previousCosLon - cosLon * previousSinLon;
+      double cosDLon = cosLon * previousCosLon + sinLon * previousSinLon;
+      double y = sinDLon * cosLat;
+      double x = previousCosLat * sinLat - previousSinLat * cosLat * cosDLon;
+      double azimut = rad2deg(atan2(y, x));
+      caps[i - 1] = azimut < 0 ? azimut + 360 : azimut;
+      distances[i - 1] = similarityToDistance(previousSinLat * sinLat + previousCosLat * cosLat * cosDLon);
+    }
+    previousSinLat = sinLat;
+    previousCosLat = cosLat;
+    previousSinLon = sinLon;
+    previousCosLon = cosLon;
+  }
+}
+
+PlanarProjection::PlanarProjection(const UnitVector &center)
+  : m_center(center)
+{
+  // east is tangent to the parallel, any horizontal direction will do at the poles
+  double norm = std::sqrt(center.x * center.x + center.y * center.y);
+  m_east = norm < 1e-12 ? UnitVector{ 0, 1, 0 } : UnitVector{ -center.y / norm, center.x / norm, 0 };
+  m_north = {
+    center.y * m_east.z - center.z * m_east.y,
+    center.z * m_east.x - center.x * m_east.z,
+    center.x * m_east.y - center.y * m_east.x
+  };
+}
+
+PlanarProjection PlanarProjection::aroundCentroid(const UnitVector *points, size_t count)
+{
+  double x = 0, y = 0, z = 0;
+  for (size_t i = 0; i < count; i++) {
+    x += points[i].x;
+    y += points[i].y;
+    z += points[i].z;
+  }
+  double norm = std::sqrt(x * x + y * y + z * z);
+  if (norm < 1e-12) // no points, or points spread evenly around the globe
+    return PlanarProjection{ UnitVector{ 1, 0, 0 } };
+  return PlanarProjection{ UnitVector{ x / norm, y / norm, z / norm } };
+}
+
+PlanarPoint PlanarProjection::project(const UnitVector &point) const
+{
+  // the point is placed in its direction from the center, at its real distance from the center
+  double east = similarity(point, m_east);
+  double north = similarity(point, m_north);
+  double norm = std::sqrt(east * east + north * north);
+  if (norm < 1e-12)
+    return { 0, 0 };
+  double distanceFromCenter = distance(m_center, point);
+  return { (float)(east / norm * distanceFromCenter), (float)(north / norm * distanceFromCenter) };
+}
+
+nauticmiles_t PlanarProjection::radius(const UnitVector *points, size_t count) const
+{
+  nauticmiles_t radius = 0;
+  for (size_t i = 0; i < count; i++)
+    radius = std::max(radius, distance(m_center, points[i]));
+  return radius;
+}
+
+double PlanarProjection::maxRelativeError(nauticmiles_t radius)
+{
+  // the scale is exactly 1 along the lines through the center and a/sin(a) along the
+  // circles around it, at an angle a from the center, so projected distances are between
+  // the real ones and the real ones times the largest scale
+  double angle = radius / geography::EARTH_RADIUS_NM;
+  if (angle < 1e-6)
+    return 0;
+  if (angle >= PI)
+    return std::numeric_limits<double>::infinity();
+  return angle / sin(angle) - 1;
+}
+
+}
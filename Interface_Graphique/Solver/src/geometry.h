@@ -3,6 +3,7 @@
 #include "geography.h"
 #include "path.h"
 
+#include <algorithm>
 #include <cmath>
 #include <math.h>
 
@@ -29,6 +30,127 @@ inline nauticmiles_t distance(const Location &p1, const Location &p2)
     return acos(sin(la1) * sin(la2) + cos(la1) * cos(la2) * cos(lo2 - lo1)) * geography::EARTH_RADIUS_NM;
 }
 
+/*
+ * Position of a location on the unit sphere, with x towards (0N,0E), y towards
+ * (0N,90E) and z towards the north pole.
+ *
+ * The distance between two unit vectors only needs a dot product and an acos,
+ * stations never move during a solve so their unit vectors are computed once
+ * (see ProblemStation) instead of converting coordinates on every distance call.
+ */
+struct UnitVector {
+  double x, y, z;
+};
+
+inline UnitVector toUnitVector(const Location &location)
+{
+  double lat = deg2rad(location.lat);
+  double lon = deg2rad(location.lon);
+  return { cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat) };
+}
+
+/*
+ * Cosine of the angle between two unit vectors, the greater the similarity the
+ * closer the points. Comparing similarities orders points the same way distances
+ * do without paying for the acos.
+ */
+inline double similarity(const UnitVector &v1, const UnitVector &v2)
+{
+  return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+inline nauticmiles_t similarityToDistance(double similarity)
+{
+  // clamped because rounding errors may get the dot product slightly out of -1..1
+  return acos(std::max(-1., std::min(1., similarity))) * geography::EARTH_RADIUS_NM;
+}
+
+inline nauticmiles_t distance(const UnitVector &v1, const UnitVector &v2)
+{
+  return similarityToDistance(similarity(v1, v2));
+}
+
+/*
+ * Computes the distances between origin and each of the count locations, out[i]
+ * is set to distance(origin, locations[i]). out must be able to hold count values.
+ *
+ * Prefer this over repeated calls to distance() when scanning many stations, the
+ * computation is vectorized when the project is compiled with AVX2 or AVX-512
+ * enabled (see geometry.cpp).
+ */
+void distances(const Location &origin, const Location *locations, size_t count, nauticmiles_t *out);
+
+/*
+ * Same as above with precomputed unit vectors, out[i] is set to
+ * distance(origin, vectors[i]). Cheaper as there is no trigonometry left
+ * but the acos.
+ */
+void distances(const UnitVector &origin, const UnitVector *vectors, size_t count, nauticmiles_t *out);
+
+/*
+ * Caps and distances of the count-1 legs of a path through count locations,
+ * caps[i] is set to cap(locations[i], locations[i+1]) and distances[i] to
+ * distance(locations[i], locations[i+1]). The sines and cosines of each location
+ * are computed once instead of twice per leg and by both functions.
+ */
+void legs(const Location *locations, size_t count, double *caps, nauticmiles_t *distances);
+
+/*
+ * Position of a location on a plane tangent to the earth (see PlanarProjection),
+ * in nautic miles.
+ */
+struct PlanarPoint {
+  float x, y;
+};
+
+/*
+ * Squared euclidean distance, orders points the same way distance() does
+ * without paying for the sqrt.
+ */
+inline float squaredDistance(const PlanarPoint &p1, const PlanarPoint &p2)
+{
+  float dx = p1.x - p2.x, dy = p1.y - p2.y;
+  return dx * dx + dy * dy;
+}
+
+inline nauticmiles_t distance(const PlanarPoint &p1, const PlanarPoint &p2)
+{
+  return std::sqrt(squaredDistance(p1, p2));
+}
+
+/*
+ * Azimuthal equidistant projection around a center point, for maps that only
+ * cover a region of the earth. Distances between projected points are a few
+ * multiplications instead of an acos.
+ *
+ * Distances and directions from the center are kept, the other distances are
+ * never shortened (but for float rounding) and are stretched by at most
+ * maxRelativeError(radius) for points closer than radius to the center. The
+ * error grows with the square of the radius: 0.2% for the ~400nm between
+ * mainland France's centroid and its farthest stations, 6% for a radius of
+ * 2000nm. Points on the other side of the earth
+ * cannot be projected meaningfully.
+ */
+class PlanarProjection {
+private:
+  UnitVector m_center;
+  UnitVector m_east;
+  UnitVector m_north;
+
+public:
+  explicit PlanarProjection(const UnitVector &center);
+
+  // projection around the centroid of the count points
+  static PlanarProjection aroundCentroid(const UnitVector *points, size_t count);
+
+  PlanarPoint project(const UnitVector &point) const;
+
+  // the largest distance between the center and one of the count points
+  nauticmiles_t radius(const UnitVector *points, size_t count) const;
+
+  static double maxRelativeError(nauticmiles_t radius);
+};
+
 inline Location interpolateLocations(const Location &l1, const Location &l2, float x)
 {
   // linear interpolation, not exact because lon/lat coordinates cannot be interpolated
@@ -1,27 +1,76 @@
 #include "geoserializer.h"
 
-double GeoSerializer::string2coordinate(const std::string &str)
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Number of consecutive digits at the start of str, from index begin
+size_t countDigits(std::string_view str, size_t begin)
 {
-    // check if string is valid
-    if (!std::regex_match(str, std::regex("^[0-9]{1,3}:[0-9]{1,2}\\.[0-9]*[NSWE]$")))
+    size_t end = begin;
+    while (end < str.size() && isDigit(str[end])) {
+        end++;
+    }
+    return end - begin;
+}
+
+}
+
+double GeoSerializer::string2coordinate(std::string_view str)
+{
+    // check if string is valid, the expected format is DDD:MM.mmm followed by the direction (example: 52:30.12N)
+    size_t degreesLength = countDigits(str, 0);
+    size_t colon = degreesLength;
+    size_t minutesLength = countDigits(str, colon + 1);
+    size_t dot = colon + 1 + minutesLength;
+    size_t direction = dot + 1 + countDigits(str, dot + 1);
+
+    if (degreesLength < 1 || degreesLength > 3
+        || colon >= str.size() || str[colon] != ':'
+        || minutesLength < 1 || minutesLength > 2
+        || dot >= str.size() || str[dot] != '.'
+        || direction != str.size() - 1
+        || std::string_view("NSEWO").find(str[direction]) == std::string_view::npos)
     {
-        throw std::invalid_argument("Invalid coordinate string (" + str + ")");
+        throw std::invalid_argument("Invalid coordinate string (" + std::string(str) + ")");
     }
 
-    // split string into degrees, minutes and direction  (example: 52:30.12N)
-    std::string degrees = str.substr(0, str.find(":"));   // degrees = 52
-    std::string minutes = str.substr(str.find(":") + 1);     // minutes = 30.12N
-    std::string direction = minutes.substr(minutes.size() - 1); // direction = N
-    minutes.pop_back();                                              // minutes = 30.12
+    // convert to decimal degrees, the format was checked so the conversions cannot fail
+    int degrees = 0;
+    double minutes = 0;
+    std::from_chars(str.data(), str.data() + colon, degrees);
+    std::from_chars(str.data() + colon + 1, str.data() + direction, minutes);
 
-    // convert to decimal degrees
-    double result = std::stod(degrees) + std::stod(minutes) / 60;
+    double result = degrees + minutes / 60;
 
     // change sign to keep a consistent coordinate system
-    if (direction == "W" || direction == "O" || direction == "S")
+    if (str[direction] == 'W' || str[direction] == 'O' || str[direction] == 'S')
     {
         result = -result;
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+std::string GeoSerializer::coordinate2string(double coordinate, bool isLatitude)
+{
+    // work on thousandths of minutes so that rounding cannot produce 60 minutes
+    long long thousandths = std::llround(std::abs(coordinate) * 60 * 1000);
+    long long degrees = thousandths / 60000;
+    long long minutes = thousandths % 60000;
+
+    char direction = isLatitude ? (coordinate < 0 ? 'S' : 'N') : (coordinate < 0 ? 'W' : 'E');
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), isLatitude ? "%02lld:%02lld.%03lld%c" : "%03lld:%02lld.%03lld%c",
+                  degrees, minutes / 1000, minutes % 1000, direction);
+    return buffer;
+}
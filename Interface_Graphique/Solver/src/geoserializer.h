@@ -1,7 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
-#include <regex>
+#include <string_view>
 
 #include "geomap.h"
 #include "path.h"
@@ -15,6 +16,16 @@
 #define NIGHT_VFR_COLUMN 7
 #define FUEL_COLUMN 8
 
+/**
+ * @brief Progress of a parseMap() call, shared with the thread that waits for it. \n\n
+ * The parser updates currentProgress while it reads the file and stops early once
+ * userInterupted is set, the map it returns is then incomplete and must be discarded.
+ */
+struct ParseRuntime {
+    std::atomic<bool> userInterupted = false;
+    std::atomic<float> currentProgress = 0; // in range 0..1
+};
+
 /**
  * @brief Abstract class for serializing/deserializing GeoMap and Path objects. \n\n
  * Classes inheriting from GeoSerializer must implement the parseMap() and writePath() methods. \n\n
@@ -26,9 +37,10 @@ public:
     /**
     * @brief Parses a file containing GeoMap data and returns a corresponding GeoMap object.
     * @param file The path to the file containing the GeoMap data.
+    * @param runtime Progress reporting and cancellation, may be null.
     * @return The parsed GeoMap object.
     */
-    virtual GeoMap parseMap(const std::filesystem::path &file) const = 0;
+    virtual GeoMap parseMap(const std::filesystem::path &file, ParseRuntime *runtime = nullptr) const = 0;
 
     /**
      * @brief Writes a Path object to a file (Navigation sheet).
@@ -37,15 +49,30 @@ public:
      */
     virtual void writePath(const std::filesystem::path &file, const Path &path) const = 0;
 
-    virtual void writeMap(const GeoMap &map, const std::filesystem::path &file) const {} // TODO implement writeMap in both serializers
+    /**
+     * @brief Writes a GeoMap object to a file, in a format that parseMap() can read back.
+     * @param map The GeoMap object to write.
+     * @param file The path to the file to write to.
+     */
+    virtual void writeMap(const GeoMap &map, const std::filesystem::path &file) const = 0;
 
 protected:
 
     /**
-     * @brief Converts a string to a coordinate value.
+     * @brief Converts a string to a coordinate value. \n\n
+     * The expected format is DDD:MM.mmm followed by N, S, E, W or O (ouest),
+     * for example 52:30.12N. South and west coordinates are negative.
      * @param str The string to convert.
      * @return The coordinate value.
      * @throws std::invalid_argument if the string is not a valid coordinate.
      */
-    static double string2coordinate(const std::string &str);
+    static double string2coordinate(std::string_view str);
+
+    /**
+     * @brief Converts a coordinate value to a string that string2coordinate() can read back.
+     * @param coordinate The coordinate value, in degrees.
+     * @param isLatitude Whether the coordinate is a latitude (N/S) or a longitude (E/W).
+     * @return The coordinate string, with minutes rounded to 3 decimals (example: 52:30.120N).
+     */
+    static std::string coordinate2string(double coordinate, bool isLatitude);
 };
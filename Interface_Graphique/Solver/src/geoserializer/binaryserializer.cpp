@@ -0,0 +1,219 @@
+#include "binaryserializer.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t SECTION_ALIGNMENT = 8;
+
+// progress is reported and cancellation checked every this many stations
+constexpr size_t PROGRESS_STATIONS = 1 << 16;
+
+size_t alignSection(size_t size)
+{
+    return (size + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// FNV-1a over 8 bytes words, sections are padded so the content is always a whole number of words
+uint64_t hashContent(std::string_view content)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i + sizeof(uint64_t) <= content.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, content.data() + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string_view stationField(const Station &station, BinaryMapFile::Field field)
+{
+    switch (field) {
+    case BinaryMapFile::NAME:      return station.getName();
+    case BinaryMapFile::OACI:      return station.getOACI();
+    case BinaryMapFile::STATUS:    return station.getStatus();
+    case BinaryMapFile::NIGHT_VFR: return station.getNightVFR();
+    case BinaryMapFile::FUEL:      return station.getFuel();
+    default: throw std::logic_error("Unknown station field");
+    }
+}
+
+// Appends the raw bytes of values to content, padded to the next section
+template<class T>
+void appendSection(std::string &content, const T *values, size_t count)
+{
+    content.append(reinterpret_cast<const char *>(values), count * sizeof(T));
+    content.resize(alignSection(content.size()), '\0');
+}
+
+}
+
+BinaryMapFile::BinaryMapFile(const std::filesystem::path &file)
+    : m_file(file)
+{
+    std::string_view data = m_file.contents();
+    auto invalidFile = [&file](const std::string &reason) {
+        return std::runtime_error("The file \"" + file.string() + "\" is not a valid airfield database: " + reason);
+    };
+
+    Header header;
+    if (data.size() < sizeof(header))
+        throw invalidFile("the file is too short");
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != MAGIC)
+        throw invalidFile("unknown file type");
+    if (header.version != VERSION)
+        throw invalidFile("unsupported version " + std::to_string(header.version));
+
+    // all sizes are checked against the file size before any section is read
+    if (header.stringBytes > data.size())
+        throw invalidFile("unexpected file size");
+    const uint64_t stations = header.stationCount;
+    const uint64_t expectedSize = alignSection(sizeof(Header))
+        + 2 * stations * sizeof(double)
+        + alignSection(stations)
+        + FIELD_COUNT * alignSection(stations * sizeof(uint32_t))
+        + alignSection(((uint64_t)header.stringCount + 1) * sizeof(uint32_t))
+        + alignSection(header.stringBytes);
+    if (expectedSize != data.size())
+        throw invalidFile("unexpected file size");
+
+    std::string_view content = data.substr(alignSection(sizeof(Header)));
+    if (hashContent(content) != header.contentHash)
+        throw invalidFile("the content does not match its hash");
+
+    const char *section = content.data();
+    auto nextSection = [&section](size_t size) {
+        const char *current = section;
+        section += alignSection(size);
+        return current;
+    };
+    m_stationCount = header.stationCount;
+    m_stringCount = header.stringCount;
+    m_latitudes = reinterpret_cast<const double *>(nextSection(stations * sizeof(double)));
+    m_longitudes = reinterpret_cast<const double *>(nextSection(stations * sizeof(double)));
+    m_excluded = reinterpret_cast<const uint8_t *>(nextSection(stations));
+    for (size_t field = 0; field < FIELD_COUNT; field++)
+        m_fields[field] = reinterpret_cast<const uint32_t *>(nextSection(stations * sizeof(uint32_t)));
+    m_stringOffsets = reinterpret_cast<const uint32_t *>(nextSection((m_stringCount + 1) * sizeof(uint32_t)));
+    m_stringBytes = nextSection(header.stringBytes);
+
+    // the content could still be inconsistent if it was written with a matching hash
+    for (uint32_t string = 0; string < m_stringCount; string++) {
+        if (m_stringOffsets[string] > m_stringOffsets[string + 1])
+            throw invalidFile("invalid string table");
+    }
+    if (m_stringOffsets[0] != 0 || m_stringOffsets[m_stringCount] != header.stringBytes)
+        throw invalidFile("invalid string table");
+    for (size_t field = 0; field < FIELD_COUNT; field++) {
+        for (uint32_t station = 0; station < m_stationCount; station++) {
+            if (m_fields[field][station] >= m_stringCount)
+                throw invalidFile("invalid string index");
+        }
+    }
+}
+
+void BinaryMapFile::write(const std::filesystem::path &file, const std::vector<Station> &stations)
+{
+    if (stations.size() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Too many stations to write an airfield database");
+
+    const size_t stationCount = stations.size();
+    std::vector<double> latitudes(stationCount), longitudes(stationCount);
+    std::vector<uint8_t> excluded(stationCount);
+    for (size_t i = 0; i < stationCount; i++) {
+        latitudes[i] = stations[i].getLocation().lat;
+        longitudes[i] = stations[i].getLocation().lon;
+        excluded[i] = stations[i].isExcluded() ? 1 : 0;
+    }
+
+    // the views point into the stations, that outlive the table
+    std::unordered_map<std::string_view, uint32_t> stringIndices;
+    std::vector<uint32_t> stringOffsets{ 0 };
+    std::string stringBytes;
+    std::array<std::vector<uint32_t>, FIELD_COUNT> fields;
+    for (size_t field = 0; field < FIELD_COUNT; field++) {
+        fields[field].reserve(stationCount);
+        for (const Station &station : stations) {
+            std::string_view value = stationField(station, (Field)field);
+            auto [string, inserted] = stringIndices.try_emplace(value, (uint32_t)stringIndices.size());
+            if (inserted) {
+                stringBytes += value;
+                if (stringBytes.size() > std::numeric_limits<uint32_t>::max())
+                    throw std::runtime_error("Too much text to write an airfield database");
+                stringOffsets.push_back((uint32_t)stringBytes.size());
+            }
+            fields[field].push_back(string->second);
+        }
+    }
+
+    std::string content;
+    appendSection(content, latitudes.data(), stationCount);
+    appendSection(content, longitudes.data(), stationCount);
+    appendSection(content, excluded.data(), stationCount);
+    for (const std::vector<uint32_t> &field : fields)
+        appendSection(content, field.data(), stationCount);
+    appendSection(content, stringOffsets.data(), stringOffsets.size());
+    appendSection(content, stringBytes.data(), stringBytes.size());
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.contentHash = hashContent(content);
+    header.stationCount = (uint32_t)stationCount;
+    header.stringCount = (uint32_t)(stringOffsets.size() - 1);
+    header.stringBytes = stringBytes.size();
+
+    std::string headerBytes(alignSection(sizeof(header)), '\0');
+    std::memcpy(headerBytes.data(), &header, sizeof(header));
+
+    std::ofstream out{ file, std::ios::binary | std::ios::trunc };
+    out.write(headerBytes.data(), headerBytes.size());
+    out.write(content.data(), content.size());
+    if (!out)
+        throw std::runtime_error("Error while writing the file \"" + file.string() + "\"");
+}
+
+GeoMap BinarySerializer::parseMap(const std::filesystem::path &file, ParseRuntime *runtime) const
+{
+    BinaryMapFile database{ file };
+
+    GeoMap map{};
+    map.getStations().reserve(database.size());
+    for (size_t i = 0; i < database.size(); i++) {
+        if (runtime != nullptr && i % PROGRESS_STATIONS == 0) {
+            if (runtime->userInterupted)
+                return map;
+            runtime->currentProgress = (float)i / database.size();
+        }
+        map.getStations().emplace_back(
+            database.isExcluded(i),
+            database.getLocation(i),
+            std::string(database.getField(i, BinaryMapFile::NAME)),
+            std::string(database.getField(i, BinaryMapFile::OACI)),
+            std::string(database.getField(i, BinaryMapFile::STATUS)),
+            std::string(database.getField(i, BinaryMapFile::NIGHT_VFR)),
+            std::string(database.getField(i, BinaryMapFile::FUEL)));
+    }
+    map.assignStationIds();
+    if (runtime != nullptr)
+        runtime->currentProgress = 1;
+    return map;
+}
+
+void BinarySerializer::writePath(const std::filesystem::path &file, const Path &path) const
+{
+    std::vector<Station> stations;
+    stations.reserve(path.size());
+    for (const Station *station : path.getStations())
+        stations.push_back(*station);
+    BinaryMapFile::write(file, stations);
+}
+
+void BinarySerializer::writeMap(const GeoMap &map, const std::filesystem::path &file) const
+{
+    BinaryMapFile::write(file, map.getStations());
+}
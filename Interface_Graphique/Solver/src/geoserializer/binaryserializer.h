@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "../geoserializer.h"
+#include "mappedfile.h"
+
+/**
+ * @brief Binary airfield database, much faster to load than CSV or XLSX files. \n\n
+ * The file is a header followed by sections, all sections start on an 8 bytes boundary:
+ * - the latitudes then the longitudes of the stations (double[stationCount] each),
+ * - the exclusion flags (uint8_t[stationCount]),
+ * - for each text field (name, OACI, status, night VFR, fuel) the index of the
+ *   value of each station in the string table (uint32_t[stationCount] each),
+ * - the string table, stringCount+1 offsets (uint32_t) into the string bytes
+ *   followed by the string bytes, every distinct value is stored once.
+ *
+ * The header holds the format version and a hash of everything that follows it,
+ * files written by another version or that were modified are rejected.
+ * Numbers are stored in the byte order of the machine that wrote the file.
+ */
+class BinaryMapFile {
+public:
+    static constexpr uint32_t MAGIC = 0x42445046; // "FPDB"
+    static constexpr uint32_t VERSION = 1;
+
+    enum Field {
+        NAME, OACI, STATUS, NIGHT_VFR, FUEL,
+        FIELD_COUNT
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t contentHash;
+        uint32_t stationCount;
+        uint32_t stringCount;
+        uint64_t stringBytes;
+    };
+
+private:
+    MappedFile m_file;
+    uint32_t m_stationCount;
+    const double *m_latitudes;
+    const double *m_longitudes;
+    const uint8_t *m_excluded;
+    std::array<const uint32_t *, FIELD_COUNT> m_fields;
+    uint32_t m_stringCount;
+    const uint32_t *m_stringOffsets;
+    const char *m_stringBytes;
+
+public:
+    /**
+     * @brief Maps a binary database and checks its header, its size and its content hash.
+     * @param file The path to the file to map.
+     * @throws std::runtime_error if the file cannot be read or is not a valid database.
+     */
+    explicit BinaryMapFile(const std::filesystem::path &file);
+
+    size_t size() const { return m_stationCount; }
+
+    bool isExcluded(size_t station) const { return m_excluded[station] != 0; }
+    Location getLocation(size_t station) const { return { m_longitudes[station], m_latitudes[station] }; }
+    // the view is valid as long as this object lives
+    std::string_view getField(size_t station, Field field) const
+    {
+        uint32_t string = m_fields[field][station];
+        return { m_stringBytes + m_stringOffsets[string], m_stringOffsets[string + 1] - m_stringOffsets[string] };
+    }
+
+    /**
+     * @brief Writes stations in the binary database format.
+     * @param file The path to the file to write to.
+     * @param stations The stations to write.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    static void write(const std::filesystem::path &file, const std::vector<Station> &stations);
+};
+
+/**
+ * @brief Serializer for the binary airfield database format (.fpdb), see BinaryMapFile.
+ */
+class BinarySerializer : public GeoSerializer {
+public:
+    GeoMap parseMap(const std::filesystem::path &file, ParseRuntime *runtime = nullptr) const override;
+
+    /**
+     * @brief Writes the stations of the path, in order, as a binary database.
+     */
+    void writePath(const std::filesystem::path &file, const Path &path) const override;
+
+    void writeMap(const GeoMap &map, const std::filesystem::path &file) const override;
+};
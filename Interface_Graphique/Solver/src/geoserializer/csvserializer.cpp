@@ -1,88 +1,162 @@
-#include <sstream>
+#include <array>
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+#include <thread>
+
 #include "csvserializer.h"
+#include "mappedfile.h"
 
-GeoMap CSVSerializer::parseMap(const std::filesystem::path &file) const
+GeoMap CSVSerializer::parseMap(const std::filesystem::path &file, ParseRuntime *runtime) const
 {
     GeoMap resultat{};
 
-    std::vector<std::vector<std::string>> content;
-    std::vector<std::string> row;
-    std::string infoLine, word;
+    // Map the file, fields are read in place and only copied into the stations
+    MappedFile mappedFile{ file };
+    std::string_view content = mappedFile.contents();
 
-    // Open the file
-    std::ifstream csvFile;
-    csvFile.open(file, std::ios_base::in);
-    if (!csvFile.is_open())
-    {
-        throw std::runtime_error("Error while opening the file \"" + file.string() + "\"");
+    // Skip the header
+    std::string_view body = content.substr(std::min(content.find('\n'), content.size()));
+    if (!body.empty()) {
+        body.remove_prefix(1);
     }
 
-    // Clear the vectors
-    row.clear();
-    content.clear();
+    // Split the rows in chunks ending at line boundaries, small files are parsed in a single chunk
+    unsigned int threadCount = m_threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : m_threadCount;
+    threadCount = (unsigned int)std::min<size_t>(threadCount, std::max<size_t>(1, body.size() / MIN_CHUNK_SIZE));
 
-    // Skip the header
-    getline(csvFile, infoLine);
+    const size_t bodySize = body.size();
+    std::vector<std::string_view> chunks;
+    while (!body.empty())
+    {
+        size_t chunkEnd = chunks.size() + 1 == threadCount ? body.size() : body.size() / (threadCount - chunks.size());
+        chunkEnd = std::min(body.find('\n', chunkEnd), body.size() - 1) + 1;
+        chunks.push_back(body.substr(0, chunkEnd));
+        body.remove_prefix(chunkEnd);
+    }
 
-    // Fill the vectors with the content of the file
-    while (std::getline(csvFile, infoLine))
+    // Parse the chunks, the first one on this thread
+    std::vector<ParsedChunk> parsedChunks(chunks.size());
+    auto parse = [&chunks, &parsedChunks, runtime, bodySize](size_t i) {
+        try {
+            parseChunk(chunks[i], parsedChunks[i], runtime, bodySize);
+        } catch (...) {
+            parsedChunks[i].failure = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < chunks.size(); i++)
+    {
+        threads.emplace_back(parse, i);
+    }
+    if (!chunks.empty()) {
+        parse(0);
+    }
+    for (std::thread &thread : threads)
     {
-        std::stringstream sLine(infoLine);
-        row.clear();
+        thread.join();
+    }
+    if (runtime != nullptr && runtime->userInterupted) {
+        return resultat;
+    }
 
-        // Split the line with the delimiter ';'
-        while (std::getline(sLine, word, ';'))
-        {
-            row.push_back(word);
+    // Merge the stations in the file order, the first error of the file is reported
+    size_t stationCount = 0;
+    for (const ParsedChunk &chunk : parsedChunks)
+    {
+        stationCount += chunk.stations.size();
+    }
+    resultat.getStations().reserve(stationCount);
 
+    int row = 2; // first row after the header
+    for (ParsedChunk &chunk : parsedChunks)
+    {
+        if (chunk.failure) {
+            std::rethrow_exception(chunk.failure);
         }
-        // Add the row vector to the content vector
-        content.push_back(row);
+        if (!chunk.error.empty()) {
+            throw std::runtime_error("Error while parsing the file \""
+                                     + file.string()
+                                     + "\" at row "
+                                     + std::to_string(row + chunk.errorLine)
+                                     + ": " + chunk.error);
+        }
+        row += chunk.lineCount;
+        std::move(chunk.stations.begin(), chunk.stations.end(), std::back_inserter(resultat.getStations()));
     }
-    
-    // Create the stations
-    for (int i = 0; i < content.size(); i++)
+
+    resultat.assignStationIds();
+    if (runtime != nullptr) {
+        runtime->currentProgress = 1;
+    }
+    return resultat;
+}
+
+void CSVSerializer::parseChunk(std::string_view chunk, ParsedChunk &result, ParseRuntime *runtime, size_t bodySize)
+{
+    // Reserve one station per line
+    result.stations.reserve(std::count(chunk.begin(), chunk.end(), '\n') + 1);
+
+    size_t lineStart = 0;
+    size_t reportedBytes = 0;
+    for (; lineStart < chunk.size(); result.lineCount++)
     {
-        std::string OACI, name, lat, lon, status, nightVFR, fuel;
-
-        OACI = content[i][OACI_COLUMN - 1];
-        name = content[i][NAME_COLUMN - 1];
-        lat = content[i][LATITUDE_COLUMN - 1];
-        lon = content[i][LONGITUDE_COLUMN - 1];
-        status = content[i][STATUS_COLUMN - 1];
-        nightVFR = content[i][NIGHT_VFR_COLUMN - 1];
-        fuel = content[i][FUEL_COLUMN - 1];
-
-        bool excluded = false;
-        if (!content[i][EXCLUDE_COLUMN-1].empty()) {
-            excluded = true;
+        // Each chunk adds its share of the file to the progress, the chunks are parsed concurrently
+        if (runtime != nullptr && result.lineCount % PROGRESS_LINES == 0) {
+            if (runtime->userInterupted) {
+                return;
+            }
+            runtime->currentProgress.fetch_add((float)(lineStart - reportedBytes) / bodySize);
+            reportedBytes = lineStart;
         }
 
-        if (fuel.back() == '\r') {
-            fuel.pop_back(); // remove the last character (\r)
+        size_t lineEnd = std::min(chunk.find('\n', lineStart), chunk.size());
+        std::string_view line = chunk.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1; // skip the '\n'
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1); // remove the last character (\r)
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        // Split the line with the delimiter ';', missing trailing fields are left empty
+        std::array<std::string_view, FUEL_COLUMN> fields{};
+        for (size_t column = 0; column < fields.size(); column++)
+        {
+            size_t delimiter = line.find(';');
+            fields[column] = line.substr(0, delimiter);
+            if (delimiter == std::string_view::npos) {
+                break;
+            }
+            line.remove_prefix(delimiter + 1);
         }
 
+        bool excluded = !fields[EXCLUDE_COLUMN - 1].empty();
+
         double lat_value, lon_value;
 
+        // Errors are not thrown from the worker threads, the row number is only known once the previous chunks are parsed
         try {
-            lat_value = string2coordinate(lat);
-            lon_value = string2coordinate(lon);
+            lat_value = string2coordinate(fields[LATITUDE_COLUMN - 1]);
+            lon_value = string2coordinate(fields[LONGITUDE_COLUMN - 1]);
         } catch (std::exception &e) {
-            throw std::runtime_error("Error while parsing the file \""
-                                     + file.string()
-                                     + "\" at row "
-                                     + std::to_string(i + 2)
-                                     + ": " + e.what());
+            result.errorLine = result.lineCount;
+            result.error = e.what();
+            return;
         }
 
-        Location location{ lon_value, lat_value };
-        Station station (excluded, location, name, OACI, status, nightVFR, fuel);
-
         // Add the station to the map
-        resultat.getStations().emplace_back(station);
+        result.stations.emplace_back(
+            excluded,
+            Location{ lon_value, lat_value },
+            std::string(fields[NAME_COLUMN - 1]),
+            std::string(fields[OACI_COLUMN - 1]),
+            std::string(fields[STATUS_COLUMN - 1]),
+            std::string(fields[NIGHT_VFR_COLUMN - 1]),
+            std::string(fields[FUEL_COLUMN - 1]));
     }
-
-    return resultat;
 }
 
 void CSVSerializer::writePath(const std::filesystem::path &file, const Path &path) const
@@ -104,15 +178,23 @@ void CSVSerializer::writePath(const std::filesystem::path &file, const Path &pat
 void CSVSerializer::writeMap(const GeoMap &map, const std::filesystem::path &path) const
 {
     std::ofstream file{ path };
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error while opening the file \"" + path.string() + "\"");
+    }
+
+    // Same columns as the files read by parseMap
+    file << "Exclure;code OACI;Nom;Lattitude;Longitude;Statut;VFR nuit;Essence\n";
 
     for(const Station &s : map.getStations()) {
         file
+          << (s.isExcluded() ? "x" : "") << ";"
           << s.getOACI() << ";"
           << s.getName() << ";"
-          << s.getLocation().lat << ";"
-          << s.getLocation().lon << ";"
+          << coordinate2string(s.getLocation().lat, true) << ";"
+          << coordinate2string(s.getLocation().lon, false) << ";"
           << s.getStatus() << ";"
           << s.getNightVFR() << ";"
-          << s.getFuel() << ";\n";
+          << s.getFuel() << "\n";
     }
 }
@@ -2,14 +2,45 @@
 
 #include <iostream>
 #include <fstream>
+#include <exception>
+#include <string_view>
 
 #include "../geoserializer.h"
 
 class CSVSerializer : public GeoSerializer {
+private:
+    // Files are only split between threads in chunks of at least this many bytes
+    static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+    // Progress is reported and cancellation checked every this many lines
+    static constexpr int PROGRESS_LINES = 4096;
+
+    struct ParsedChunk {
+        std::vector<Station> stations;
+        int lineCount = 0;
+        int errorLine = 0;  // line of the error in the chunk, if there is one
+        std::string error;  // empty if the chunk was parsed without errors
+        std::exception_ptr failure; // any other exception, rethrown by the calling thread
+    };
+
+    unsigned int m_threadCount;
+
 public:
-    GeoMap parseMap(const std::filesystem::path &file) const override;
+    /**
+     * @brief Creates a CSV serializer.
+     * @param threadCount The maximum number of threads used to parse large files, 0 to use the hardware concurrency.
+     */
+    explicit CSVSerializer(unsigned int threadCount = 0)
+        : m_threadCount(threadCount)
+    {
+    }
+
+    GeoMap parseMap(const std::filesystem::path &file, ParseRuntime *runtime = nullptr) const override;
 
     void writePath(const std::filesystem::path &file, const Path &path) const override;
 
     void writeMap(const GeoMap &map, const std::filesystem::path &file) const override;
+
+private:
+    // runtime may be null, bodySize is the size of all the chunks together
+    static void parseChunk(std::string_view chunk, ParsedChunk &result, ParseRuntime *runtime, size_t bodySize);
 };
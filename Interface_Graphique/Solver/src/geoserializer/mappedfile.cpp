@@ -0,0 +1,90 @@
+#include "mappedfile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path &file)
+{
+    m_fileHandle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE) {
+        m_fileHandle = nullptr;
+        throw std::runtime_error("Error while opening the file \"" + file.string() + "\"");
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_fileHandle, &size)) {
+        CloseHandle(m_fileHandle);
+        throw std::runtime_error("Error while reading the size of the file \"" + file.string() + "\"");
+    }
+    if (size.QuadPart == 0)
+        return;
+
+    m_mappingHandle = CreateFileMappingW(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *data = m_mappingHandle == nullptr ? nullptr : MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        if (m_mappingHandle != nullptr)
+            CloseHandle(m_mappingHandle);
+        CloseHandle(m_fileHandle);
+        throw std::runtime_error("Error while mapping the file \"" + file.string() + "\"");
+    }
+    m_data = static_cast<const char *>(data);
+    m_size = (size_t)size.QuadPart;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mappingHandle != nullptr)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle != nullptr)
+        CloseHandle(m_fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path &file)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Error while opening the file \"" + file.string() + "\"");
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        throw std::runtime_error("Error while reading the size of the file \"" + file.string() + "\"");
+    }
+    if (status.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    void *data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid after the descriptor is closed
+    if (data == MAP_FAILED)
+        throw std::runtime_error("Error while mapping the file \"" + file.string() + "\"");
+    madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const char *>(data);
+    m_size = (size_t)status.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<char *>(m_data), m_size);
+}
+
+#endif
+
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+/**
+ * @brief Read-only memory mapping of a whole file. \n\n
+ * The content of the file can be read through contents() for as long as the
+ * MappedFile lives, without being copied. Empty files are not mapped, their
+ * content is an empty view.
+ */
+class MappedFile {
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_fileHandle = nullptr;
+    void *m_mappingHandle = nullptr;
+#endif
+
+public:
+    /**
+     * @brief Maps a file in memory.
+     * @param file The path to the file to map.
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::filesystem::path &file);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string_view contents() const { return { m_data, m_size }; }
+};
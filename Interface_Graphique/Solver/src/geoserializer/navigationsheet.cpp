@@ -0,0 +1,667 @@
+#include "navigationsheet.h"
+
+#include <charconv>
+#include <cmath>
+#include <string_view>
+
+#include "../geometry.h"
+#include "zipfile.h"
+
+namespace {
+
+/*
+ * The parts of the xlsx file that do not depend on the path, taken from the
+ * template the sheets used to be copied from. The theme is the default office
+ * theme, without its per-script fonts.
+ */
+
+constexpr std::string_view CONTENT_TYPES =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">)"
+    R"(<Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>)"
+    R"(<Default Extension="xml" ContentType="application/xml"/>)"
+    R"(<Override PartName="/xl/workbook.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml"/>)"
+    R"(<Override PartName="/xl/worksheets/sheet1.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml"/>)"
+    R"(<Override PartName="/xl/theme/theme1.xml" ContentType="application/vnd.openxmlformats-officedocument.theme+xml"/>)"
+    R"(<Override PartName="/xl/styles.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml"/>)"
+    R"(<Override PartName="/xl/sharedStrings.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml"/>)"
+    R"(</Types>)";
+
+constexpr std::string_view PACKAGE_RELATIONSHIPS =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">)"
+    R"(<Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="xl/workbook.xml"/>)"
+    R"(</Relationships>)";
+
+constexpr std::string_view WORKBOOK_RELATIONSHIPS =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">)"
+    R"(<Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet" Target="worksheets/sheet1.xml"/>)"
+    R"(<Relationship Id="rId2" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/theme" Target="theme/theme1.xml"/>)"
+    R"(<Relationship Id="rId3" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles" Target="styles.xml"/>)"
+    R"(<Relationship Id="rId4" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings" Target="sharedStrings.xml"/>)"
+    R"(</Relationships>)";
+
+constexpr std::string_view WORKBOOK =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<workbook xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships">)"
+    R"(<bookViews><workbookView/></bookViews>)"
+    R"(<sheets><sheet name="Sheet1" sheetId="1" r:id="rId1"/></sheets>)"
+    R"(</workbook>)";
+
+// the sheet headers are the first shared strings, followed by the station codes and names
+constexpr std::string_view SHARED_STRINGS_HEADER =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<sst xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" count=")";
+
+constexpr std::string_view SHEET_HEADER_STRINGS =
+    R"(<si><t>PTS</t></si><si><t>NOM</t></si><si><t>ALT</t></si><si><t>CAP</t></si><si><t>DIST (NM)</t></si><si><t>TPS</t></si>)";
+
+constexpr uint32_t SHEET_HEADER_STRING_COUNT = 6;
+
+constexpr std::string_view SHARED_STRINGS_FOOTER =
+    R"(</sst>)";
+
+constexpr std::string_view STYLES =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<styleSheet xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" xmlns:mc="http://schemas.openxmlformats.org/markup-compatibility/2006" mc:Ignorable="x14ac x16r2 xr" xmlns:x14ac="http://schemas.microsoft.com/office/spreadsheetml/2009/9/ac" xmlns:x16r2="http://schemas.microsoft.com/office/spreadsheetml/2015/02/main" xmlns:xr="http://schemas.microsoft.com/office/spreadsheetml/2014/revision">)"
+    R"(<fonts count="2" x14ac:knownFonts="1">)"
+    R"(<font>)"
+    R"(<sz val="12"/>)"
+    R"(<color theme="1"/>)"
+    R"(<name val="Calibri"/>)"
+    R"(<family val="2"/>)"
+    R"(<scheme val="minor"/>)"
+    R"(</font>)"
+    R"(<font>)"
+    R"(<sz val="12"/>)"
+    R"(<color theme="1"/>)"
+    R"(<name val="Calibri"/>)"
+    R"(<family val="2"/>)"
+    R"(<scheme val="minor"/>)"
+    R"(</font>)"
+    R"(</fonts>)"
+    R"(<fills count="4">)"
+    R"(<fill>)"
+    R"(<patternFill patternType="none"/>)"
+    R"(</fill>)"
+    R"(<fill>)"
+    R"(<patternFill patternType="gray125"/>)"
+    R"(</fill>)"
+    R"(<fill>)"
+    R"(<patternFill patternType="solid">)"
+    R"(<fgColor theme="9" tint="0.59999389629810485"/>)"
+    R"(<bgColor indexed="65"/>)"
+    R"(</patternFill>)"
+    R"(</fill>)"
+    R"(<fill>)"
+    R"(<patternFill patternType="solid">)"
+    R"(<fgColor theme="0" tint="-0.14999847407452621"/>)"
+    R"(<bgColor indexed="64"/>)"
+    R"(</patternFill>)"
+    R"(</fill>)"
+    R"(</fills>)"
+    R"(<borders count="10">)"
+    R"(<border>)"
+    R"(<left/>)"
+    R"(<right/>)"
+    R"(<top/>)"
+    R"(<bottom/>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</left>)"
+    R"(<right style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</right>)"
+    R"(<top style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</top>)"
+    R"(<bottom style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</bottom>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</left>)"
+    R"(<right style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</right>)"
+    R"(<top style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</top>)"
+    R"(<bottom/>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</left>)"
+    R"(<right style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</right>)"
+    R"(<top/>)"
+    R"(<bottom style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</bottom>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</left>)"
+    R"(<right style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</right>)"
+    R"(<top/>)"
+    R"(<bottom/>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</left>)"
+    R"(<right/>)"
+    R"(<top style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</top>)"
+    R"(<bottom/>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</left>)"
+    R"(<right/>)"
+    R"(<top style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</top>)"
+    R"(<bottom style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</bottom>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left/>)"
+    R"(<right/>)"
+    R"(<top style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</top>)"
+    R"(<bottom style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</bottom>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left/>)"
+    R"(<right style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</right>)"
+    R"(<top style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</top>)"
+    R"(<bottom style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</bottom>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(<border>)"
+    R"(<left/>)"
+    R"(<right style="thin">)"
+    R"(<color indexed="64"/>)"
+    R"(</right>)"
+    R"(<top/>)"
+    R"(<bottom/>)"
+    R"(<diagonal/>)"
+    R"(</border>)"
+    R"(</borders>)"
+    R"(<cellStyleXfs count="2">)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="0"/>)"
+    R"(<xf numFmtId="0" fontId="1" fillId="2" borderId="0" applyNumberFormat="0" applyBorder="0" applyAlignment="0" applyProtection="0"/>)"
+    R"(</cellStyleXfs>)"
+    R"(<cellXfs count="11">)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="0" xfId="0"/>)"
+    R"(<xf numFmtId="0" fontId="1" fillId="2" borderId="1" xfId="1" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="0" xfId="0" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="3" borderId="6" xfId="0" applyFill="1" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="3" borderId="7" xfId="0" applyFill="1" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="3" borderId="8" xfId="0" applyFill="1" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="2" xfId="0" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="3" xfId="0" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="4" xfId="0" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="9" xfId="0" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(<xf numFmtId="0" fontId="0" fillId="0" borderId="5" xfId="0" applyBorder="1" applyAlignment="1">)"
+    R"(<alignment horizontal="center" vertical="center" wrapText="1"/>)"
+    R"(</xf>)"
+    R"(</cellXfs>)"
+    R"(<cellStyles count="2">)"
+    R"(<cellStyle name="40&#160;% - Accent6" xfId="1" builtinId="51"/>)"
+    R"(<cellStyle name="Normal" xfId="0" builtinId="0"/>)"
+    R"(</cellStyles>)"
+    R"(<dxfs count="0"/>)"
+    R"(<tableStyles count="0" defaultTableStyle="TableStyleMedium2" defaultPivotStyle="PivotStyleLight16"/>)"
+    R"(<extLst>)"
+    R"(<ext uri="{EB79DEF2-80B8-43e5-95BD-54CBDDF9020C}" xmlns:x14="http://schemas.microsoft.com/office/spreadsheetml/2009/9/main">)"
+    R"(<x14:slicerStyles defaultSlicerStyle="SlicerStyleLight1"/>)"
+    R"(</ext>)"
+    R"(<ext uri="{9260A510-F301-46a8-8635-F512D64BE5F5}" xmlns:x15="http://schemas.microsoft.com/office/spreadsheetml/2010/11/main">)"
+    R"(<x15:timelineStyles defaultTimelineStyle="TimeSlicerStyleLight1"/>)"
+    R"(</ext>)"
+    R"(</extLst>)"
+    R"(</styleSheet>)";
+
+constexpr std::string_view THEME =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<a:theme xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" name="Th&#232;me Office">)"
+    R"(<a:themeElements>)"
+    R"(<a:clrScheme name="Office">)"
+    R"(<a:dk1>)"
+    R"(<a:sysClr val="windowText" lastClr="000000"/>)"
+    R"(</a:dk1>)"
+    R"(<a:lt1>)"
+    R"(<a:sysClr val="window" lastClr="FFFFFF"/>)"
+    R"(</a:lt1>)"
+    R"(<a:dk2>)"
+    R"(<a:srgbClr val="44546A"/>)"
+    R"(</a:dk2>)"
+    R"(<a:lt2>)"
+    R"(<a:srgbClr val="E7E6E6"/>)"
+    R"(</a:lt2>)"
+    R"(<a:accent1>)"
+    R"(<a:srgbClr val="4472C4"/>)"
+    R"(</a:accent1>)"
+    R"(<a:accent2>)"
+    R"(<a:srgbClr val="ED7D31"/>)"
+    R"(</a:accent2>)"
+    R"(<a:accent3>)"
+    R"(<a:srgbClr val="A5A5A5"/>)"
+    R"(</a:accent3>)"
+    R"(<a:accent4>)"
+    R"(<a:srgbClr val="FFC000"/>)"
+    R"(</a:accent4>)"
+    R"(<a:accent5>)"
+    R"(<a:srgbClr val="5B9BD5"/>)"
+    R"(</a:accent5>)"
+    R"(<a:accent6>)"
+    R"(<a:srgbClr val="70AD47"/>)"
+    R"(</a:accent6>)"
+    R"(<a:hlink>)"
+    R"(<a:srgbClr val="0563C1"/>)"
+    R"(</a:hlink>)"
+    R"(<a:folHlink>)"
+    R"(<a:srgbClr val="954F72"/>)"
+    R"(</a:folHlink>)"
+    R"(</a:clrScheme>)"
+    R"(<a:fontScheme name="Office">)"
+    R"(<a:majorFont>)"
+    R"(<a:latin typeface="Calibri Light" panose="020F0302020204030204"/>)"
+    R"(<a:ea typeface=""/>)"
+    R"(<a:cs typeface=""/>)"
+    R"(</a:majorFont>)"
+    R"(<a:minorFont>)"
+    R"(<a:latin typeface="Calibri" panose="020F0502020204030204"/>)"
+    R"(<a:ea typeface=""/>)"
+    R"(<a:cs typeface=""/>)"
+    R"(</a:minorFont>)"
+    R"(</a:fontScheme>)"
+    R"(<a:fmtScheme name="Office">)"
+    R"(<a:fillStyleLst>)"
+    R"(<a:solidFill>)"
+    R"(<a:schemeClr val="phClr"/>)"
+    R"(</a:solidFill>)"
+    R"(<a:gradFill rotWithShape="1">)"
+    R"(<a:gsLst>)"
+    R"(<a:gs pos="0">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:lumMod val="110000"/>)"
+    R"(<a:satMod val="105000"/>)"
+    R"(<a:tint val="67000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(<a:gs pos="50000">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:lumMod val="105000"/>)"
+    R"(<a:satMod val="103000"/>)"
+    R"(<a:tint val="73000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(<a:gs pos="100000">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:lumMod val="105000"/>)"
+    R"(<a:satMod val="109000"/>)"
+    R"(<a:tint val="81000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(</a:gsLst>)"
+    R"(<a:lin ang="5400000" scaled="0"/>)"
+    R"(</a:gradFill>)"
+    R"(<a:gradFill rotWithShape="1">)"
+    R"(<a:gsLst>)"
+    R"(<a:gs pos="0">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:satMod val="103000"/>)"
+    R"(<a:lumMod val="102000"/>)"
+    R"(<a:tint val="94000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(<a:gs pos="50000">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:satMod val="110000"/>)"
+    R"(<a:lumMod val="100000"/>)"
+    R"(<a:shade val="100000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(<a:gs pos="100000">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:lumMod val="99000"/>)"
+    R"(<a:satMod val="120000"/>)"
+    R"(<a:shade val="78000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(</a:gsLst>)"
+    R"(<a:lin ang="5400000" scaled="0"/>)"
+    R"(</a:gradFill>)"
+    R"(</a:fillStyleLst>)"
+    R"(<a:lnStyleLst>)"
+    R"(<a:ln w="6350" cap="flat" cmpd="sng" algn="ctr">)"
+    R"(<a:solidFill>)"
+    R"(<a:schemeClr val="phClr"/>)"
+    R"(</a:solidFill>)"
+    R"(<a:prstDash val="solid"/>)"
+    R"(<a:miter lim="800000"/>)"
+    R"(</a:ln>)"
+    R"(<a:ln w="12700" cap="flat" cmpd="sng" algn="ctr">)"
+    R"(<a:solidFill>)"
+    R"(<a:schemeClr val="phClr"/>)"
+    R"(</a:solidFill>)"
+    R"(<a:prstDash val="solid"/>)"
+    R"(<a:miter lim="800000"/>)"
+    R"(</a:ln>)"
+    R"(<a:ln w="19050" cap="flat" cmpd="sng" algn="ctr">)"
+    R"(<a:solidFill>)"
+    R"(<a:schemeClr val="phClr"/>)"
+    R"(</a:solidFill>)"
+    R"(<a:prstDash val="solid"/>)"
+    R"(<a:miter lim="800000"/>)"
+    R"(</a:ln>)"
+    R"(</a:lnStyleLst>)"
+    R"(<a:effectStyleLst>)"
+    R"(<a:effectStyle>)"
+    R"(<a:effectLst/>)"
+    R"(</a:effectStyle>)"
+    R"(<a:effectStyle>)"
+    R"(<a:effectLst/>)"
+    R"(</a:effectStyle>)"
+    R"(<a:effectStyle>)"
+    R"(<a:effectLst>)"
+    R"(<a:outerShdw blurRad="57150" dist="19050" dir="5400000" algn="ctr" rotWithShape="0">)"
+    R"(<a:srgbClr val="000000">)"
+    R"(<a:alpha val="63000"/>)"
+    R"(</a:srgbClr>)"
+    R"(</a:outerShdw>)"
+    R"(</a:effectLst>)"
+    R"(</a:effectStyle>)"
+    R"(</a:effectStyleLst>)"
+    R"(<a:bgFillStyleLst>)"
+    R"(<a:solidFill>)"
+    R"(<a:schemeClr val="phClr"/>)"
+    R"(</a:solidFill>)"
+    R"(<a:solidFill>)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:tint val="95000"/>)"
+    R"(<a:satMod val="170000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:solidFill>)"
+    R"(<a:gradFill rotWithShape="1">)"
+    R"(<a:gsLst>)"
+    R"(<a:gs pos="0">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:tint val="93000"/>)"
+    R"(<a:satMod val="150000"/>)"
+    R"(<a:shade val="98000"/>)"
+    R"(<a:lumMod val="102000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(<a:gs pos="50000">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:tint val="98000"/>)"
+    R"(<a:satMod val="130000"/>)"
+    R"(<a:shade val="90000"/>)"
+    R"(<a:lumMod val="103000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(<a:gs pos="100000">)"
+    R"(<a:schemeClr val="phClr">)"
+    R"(<a:shade val="63000"/>)"
+    R"(<a:satMod val="120000"/>)"
+    R"(</a:schemeClr>)"
+    R"(</a:gs>)"
+    R"(</a:gsLst>)"
+    R"(<a:lin ang="5400000" scaled="0"/>)"
+    R"(</a:gradFill>)"
+    R"(</a:bgFillStyleLst>)"
+    R"(</a:fmtScheme>)"
+    R"(</a:themeElements>)"
+    R"(<a:objectDefaults/>)"
+    R"(<a:extraClrSchemeLst/>)"
+    R"(<a:extLst>)"
+    R"(<a:ext uri="{05A4C25C-085E-4340-85A3-A5531E510DB2}">)"
+    R"(<thm15:themeFamily xmlns:thm15="http://schemas.microsoft.com/office/thememl/2012/main" name="Office Theme" id="{62F939B6-93AF-4DB8-9C6B-D6C7DFDC589F}" vid="{4A3C46E8-61CC-4603-A589-7422A47A8E4A}"/>)"
+    R"(</a:ext>)"
+    R"(</a:extLst>)"
+    R"(</a:theme>)";
+
+constexpr std::string_view SHEET_HEADER =
+    R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+    R"(<worksheet xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships">)";
+
+constexpr std::string_view SHEET_VIEWS =
+    R"(<sheetViews><sheetView showGridLines="0" tabSelected="1" zoomScale="150" workbookViewId="0"/></sheetViews>)"
+    R"(<sheetFormatPr baseColWidth="10" defaultRowHeight="16"/>)"
+    R"(<cols><col min="1" max="1" width="10.83203125" style="2"/><col min="2" max="2" width="21.6640625" style="2" customWidth="1"/><col min="3" max="16384" width="10.83203125" style="2"/></cols>)"
+    R"(<sheetData>)"
+    R"(<row r="1" ht="17"><c r="A1" s="1" t="s"><v>0</v></c><c r="B1" s="1" t="s"><v>1</v></c><c r="C1" s="1" t="s"><v>2</v></c><c r="D1" s="1" t="s"><v>3</v></c><c r="E1" s="1" t="s"><v>4</v></c><c r="F1" s="1" t="s"><v>5</v></c></row>)";
+
+constexpr std::string_view SHEET_FOOTER =
+    R"(<pageMargins left="0.7" right="0.7" top="0.75" bottom="0.75" header="0.3" footer="0.3"/>)"
+    R"(</worksheet>)";
+
+// Cell styles of styles.xml
+enum CellStyle {
+    HEADER = 1,
+    FIRST_LEG_PLACEHOLDER_D = 3, // grey cells above the first leg
+    FIRST_LEG_PLACEHOLDER_E = 4,
+    FIRST_LEG_PLACEHOLDER_F = 5,
+    PAIR_TOP = 6,                // each station and each leg spans two merged rows
+    PAIR_BOTTOM = 7,
+    FIRST_LEG_TOP = 8,
+};
+
+void appendNumber(std::string &out, long long value)
+{
+    char digits[24];
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+// appends the start of a cell element, <c r="A1" s="6"
+void appendCellStart(std::string &out, char column, uint32_t row, int style)
+{
+    out += "<c r=\"";
+    out += column;
+    appendNumber(out, row);
+    out += "\" s=\"";
+    appendNumber(out, style);
+    out += '"';
+}
+
+void appendEmptyCell(std::string &out, char column, uint32_t row, int style)
+{
+    appendCellStart(out, column, row, style);
+    out += "/>";
+}
+
+void appendNumberCell(std::string &out, char column, uint32_t row, int style, long long value)
+{
+    appendCellStart(out, column, row, style);
+    out += "><v>";
+    appendNumber(out, value);
+    out += "</v></c>";
+}
+
+// appends a cell referencing the shared string of index string
+void appendTextCell(std::string &out, char column, uint32_t row, int style, uint32_t string)
+{
+    appendCellStart(out, column, row, style);
+    out += " t=\"s\"><v>";
+    appendNumber(out, string);
+    out += "</v></c>";
+}
+
+void appendSharedString(std::string &out, std::string_view text)
+{
+    out += "<si><t xml:space=\"preserve\">";
+    for (char c : text) {
+        switch (c) {
+        case '&': out += "&amp;"; break;
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        default: out += c; break;
+        }
+    }
+    out += "</t></si>";
+}
+
+void appendMergedPair(std::string &out, char column, uint32_t topRow)
+{
+    out += "<mergeCell ref=\"";
+    out += column;
+    appendNumber(out, topRow);
+    out += ':';
+    out += column;
+    appendNumber(out, topRow + 1);
+    out += "\"/>";
+}
+
+}
+
+void NavigationSheetWriter::computeLegs(const std::vector<const Station *> &stations, Legs &legs)
+{
+    std::vector<Location> locations;
+    locations.reserve(stations.size());
+    for (const Station *station : stations)
+        locations.push_back(station->getLocation());
+
+    size_t legCount = stations.empty() ? 0 : stations.size() - 1;
+    legs.caps.resize(legCount);
+    legs.distances.resize(legCount);
+    geometry::legs(locations.data(), locations.size(), legs.caps.data(), legs.distances.data());
+}
+
+void NavigationSheetWriter::write(const std::filesystem::path &file, const std::vector<const Station *> &stations)
+{
+    computeLegs(stations, m_legs);
+
+    // station i spans rows 2i+2 and 2i+3 in columns A to C, the leg from station i
+    // to station i+1 spans rows 2i+3 and 2i+4 in columns D to F
+    const uint32_t stationCount = (uint32_t)stations.size();
+    const uint32_t lastRow = 2 * stationCount + 1;
+    const uint32_t stringCount = SHEET_HEADER_STRING_COUNT + 2 * stationCount;
+    m_strings.clear();
+    m_strings += SHARED_STRINGS_HEADER;
+    appendNumber(m_strings, stringCount);
+    m_strings += "\" uniqueCount=\"";
+    appendNumber(m_strings, stringCount);
+    m_strings += "\">";
+    m_strings += SHEET_HEADER_STRINGS;
+    m_sheet.clear();
+    m_sheet += SHEET_HEADER;
+    m_sheet += "<dimension ref=\"A1:F";
+    appendNumber(m_sheet, lastRow);
+    m_sheet += "\"/>";
+    m_sheet += SHEET_VIEWS;
+
+    for (uint32_t i = 0; i < stationCount; i++) {
+        const uint32_t top = 2 * i + 2, bottom = top + 1;
+
+        m_sheet += "<row r=\"";
+        appendNumber(m_sheet, top);
+        m_sheet += "\">";
+        appendTextCell(m_sheet, 'A', top, PAIR_TOP, SHEET_HEADER_STRING_COUNT + 2 * i);
+        appendTextCell(m_sheet, 'B', top, PAIR_TOP, SHEET_HEADER_STRING_COUNT + 2 * i + 1);
+        appendSharedString(m_strings, stations[i]->getOACI());
+        appendSharedString(m_strings, stations[i]->getName());
+        appendEmptyCell(m_sheet, 'C', top, PAIR_TOP);
+        if (i == 0) {
+            appendEmptyCell(m_sheet, 'D', top, FIRST_LEG_PLACEHOLDER_D);
+            appendEmptyCell(m_sheet, 'E', top, FIRST_LEG_PLACEHOLDER_E);
+            appendEmptyCell(m_sheet, 'F', top, FIRST_LEG_PLACEHOLDER_F);
+        } else {
+            appendEmptyCell(m_sheet, 'D', top, PAIR_BOTTOM);
+            appendEmptyCell(m_sheet, 'E', top, PAIR_BOTTOM);
+            appendEmptyCell(m_sheet, 'F', top, PAIR_BOTTOM);
+        }
+        m_sheet += "</row><row r=\"";
+        appendNumber(m_sheet, bottom);
+        m_sheet += "\">";
+        appendEmptyCell(m_sheet, 'A', bottom, PAIR_BOTTOM);
+        appendEmptyCell(m_sheet, 'B', bottom, PAIR_BOTTOM);
+        appendEmptyCell(m_sheet, 'C', bottom, PAIR_BOTTOM);
+        if (i + 1 < stationCount) {
+            int legStyle = i == 0 ? FIRST_LEG_TOP : PAIR_TOP;
+            appendNumberCell(m_sheet, 'D', bottom, legStyle, std::llround(m_legs.caps[i]));
+            appendNumberCell(m_sheet, 'E', bottom, legStyle, std::llround(m_legs.distances[i]));
+            appendEmptyCell(m_sheet, 'F', bottom, legStyle);
+        }
+        m_sheet += "</row>";
+    }
+    m_sheet += "</sheetData>";
+
+    if (stationCount > 0) {
+        m_sheet += "<mergeCells>";
+        for (uint32_t i = 0; i < stationCount; i++) {
+            for (char column : { 'A', 'B', 'C' })
+                appendMergedPair(m_sheet, column, 2 * i + 2);
+            if (i + 1 < stationCount) {
+                for (char column : { 'D', 'E', 'F' })
+                    appendMergedPair(m_sheet, column, 2 * i + 3);
+            }
+        }
+        m_sheet += "</mergeCells>";
+    }
+    m_sheet += SHEET_FOOTER;
+    m_strings += SHARED_STRINGS_FOOTER;
+
+    const ZipFileEntry entries[] = {
+        { "[Content_Types].xml", CONTENT_TYPES },
+        { "_rels/.rels", PACKAGE_RELATIONSHIPS },
+        { "xl/workbook.xml", WORKBOOK },
+        { "xl/_rels/workbook.xml.rels", WORKBOOK_RELATIONSHIPS },
+        { "xl/styles.xml", STYLES },
+        { "xl/theme/theme1.xml", THEME },
+        { "xl/sharedStrings.xml", m_strings },
+        { "xl/worksheets/sheet1.xml", m_sheet },
+    };
+    writeZipFile(file, entries);
+}
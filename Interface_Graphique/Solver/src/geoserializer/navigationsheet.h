@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../station.h"
+
+/**
+ * @brief Writes navigation sheets (fiches de navigation), xlsx files listing the stations
+ * of a path with the cap and the distance of each leg, for the pilots to fill the
+ * altitudes and times. \n\n
+ * The xlsx parts are generated directly, without OpenXLSX nor the Qt resource the
+ * template used to be copied from. A writer keeps its buffers between calls, reuse one
+ * to write the sheets of many paths.
+ */
+class NavigationSheetWriter {
+public:
+    /**
+     * @brief The cap (in degrees, 0..360) and the distance of each leg of a path.
+     */
+    struct Legs {
+        std::vector<double> caps;
+        std::vector<nauticmiles_t> distances;
+    };
+
+private:
+    Legs m_legs;
+    std::string m_sheet;
+    std::string m_strings;
+
+public:
+    /**
+     * @brief Computes the caps and distances of all the legs of a path in one pass.
+     * @param stations The stations of the path, in order.
+     * @param legs Filled with stations.size()-1 legs, leg i going from station i to station i+1.
+     */
+    static void computeLegs(const std::vector<const Station *> &stations, Legs &legs);
+
+    /**
+     * @brief Writes the navigation sheet of a path, caps and distances are rounded to units.
+     * @param file The path to the xlsx file to write, replaced if it exists.
+     * @param stations The stations of the path, in order.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void write(const std::filesystem::path &file, const std::vector<const Station *> &stations);
+};
@@ -1,9 +1,11 @@
 #include "xlsserializer.h"
-#include "QtCore/qfile.h"
+#include "navigationsheet.h"
 
 #include <OpenXLSX.hpp>
+#include <array>
+#include <algorithm>
 
-GeoMap XLSSerializer::parseMap(const std::filesystem::path& file) const
+GeoMap XLSSerializer::parseMap(const std::filesystem::path& file, ParseRuntime *runtime) const
 {
     GeoMap map{};
 
@@ -13,89 +15,107 @@ GeoMap XLSSerializer::parseMap(const std::filesystem::path& file) const
     std::string sheetName = doc.workbook().worksheetNames()[0];
     OpenXLSX::XLWorksheet worksheet = doc.workbook().worksheet(sheetName);
 
-    for (auto row = 2; row <= worksheet.rowCount(); row++) { // skip the header
-        try {
-            // Check if the station is excluded
-            bool excluded = false;
-            auto exclude = worksheet.cell(row, EXCLUDE_COLUMN).value().get<std::string>();
-            if (exclude == "x" || exclude == "X") {
-                excluded = true;
-            }
+    // Walk the rows in order instead of looking each cell up by its coordinates,
+    // a lookup scans the sheet from its first row which made loading quadratic
+    uint32_t rowCount = worksheet.rowCount();
+    if (rowCount >= 2) {
+        map.getStations().reserve(rowCount - 1);
+    }
+
+    std::array<std::string, FUEL_COLUMN> fields;
 
-            // Get all the fields
-            std::string OACI, name, lat, lon, status, nightVFR, fuel;
+    for (OpenXLSX::XLRow &row : worksheet.rows(2, std::max<uint32_t>(rowCount, 2))) { // skip the header
+        if (runtime != nullptr && row.rowNumber() % PROGRESS_ROWS == 0) {
+            if (runtime->userInterupted)
+                return map;
+            runtime->currentProgress = (float)row.rowNumber() / rowCount;
+        }
 
-            OACI = worksheet.cell(row, OACI_COLUMN).value().get<std::string>();
-            name = worksheet.cell(row, NAME_COLUMN).value().get<std::string>();
-            lat = worksheet.cell(row, LATITUDE_COLUMN).value().get<std::string>();
-            lon = worksheet.cell(row, LONGITUDE_COLUMN).value().get<std::string>();
-            status = worksheet.cell(row, STATUS_COLUMN).value().get<std::string>();
-            nightVFR = worksheet.cell(row, NIGHT_VFR_COLUMN).value().get<std::string>();
-            fuel = worksheet.cell(row, FUEL_COLUMN).value().get<std::string>();
+        try {
+            // Get the fields, only the first columns are read
+            size_t column = 0;
+            for (OpenXLSX::XLCell &cell : row.cells(FUEL_COLUMN)) {
+                fields[column++] = cell.value().get<std::string>();
+            }
 
-            if(OACI == "")
+            if (fields[OACI_COLUMN - 1].empty())
                 break;
 
-            // Create a Location from the coordinates
-            Location location = Location::fromNECoordinates(string2coordinate(lat), string2coordinate(lon));
+            // Check if the station is excluded
+            const std::string &exclude = fields[EXCLUDE_COLUMN - 1];
+            bool excluded = exclude == "x" || exclude == "X";
 
-            // Create a Station
-            Station station(excluded, location, name, OACI, status, nightVFR, fuel);
+            // Create a Location from the coordinates
+            Location location = Location::fromNECoordinates(string2coordinate(fields[LATITUDE_COLUMN - 1]), string2coordinate(fields[LONGITUDE_COLUMN - 1]));
 
             // Add the station to the map
-            map.getStations().push_back(station);
+            map.getStations().emplace_back(
+                excluded,
+                location,
+                std::move(fields[NAME_COLUMN - 1]),
+                std::move(fields[OACI_COLUMN - 1]),
+                std::move(fields[STATUS_COLUMN - 1]),
+                std::move(fields[NIGHT_VFR_COLUMN - 1]),
+                std::move(fields[FUEL_COLUMN - 1]));
         } catch (std::exception &e) {
             throw std::runtime_error("Error while parsing the file \""
                                      + file.string()
                                      + "\" at row "
-                                     + std::to_string(row)
+                                     + std::to_string(row.rowNumber())
                                      + ": " + e.what());
         }
     }
 
+    map.assignStationIds();
+    if (runtime != nullptr)
+        runtime->currentProgress = 1;
     return map;
 }
 
 void XLSSerializer::writePath(const std::filesystem::path& file, const Path& path) const
 {
-    // Delete the file if it already exists
-    if (std::filesystem::exists("FicheDeNavigation.xlsx"))
+    // The navigation sheet of the path, see NavigationSheetWriter
+    NavigationSheetWriter{}.write(file, path.getStations());
+}
+
+void XLSSerializer::writeMap(const GeoMap &map, const std::filesystem::path &file) const
+{
+    // Start from an empty workbook, the file is replaced if it already exists
+    if (std::filesystem::exists(file))
     {
-        std::filesystem::remove("FicheDeNavigation.xlsx");
+        std::filesystem::remove(file);
     }
 
-    // Copy the template file
-    QFile::copy(":/resources/resources/FicheDeNavigationModel.xlsx", QString::fromStdString(file.string()));
-
-    // Open the file
     OpenXLSX::XLDocument doc;
-    doc.open(file.string());
-    auto wks = doc.workbook().worksheet("Sheet1");
+    doc.create(file.string());
+    OpenXLSX::XLWorksheet worksheet = doc.workbook().worksheet(doc.workbook().worksheetNames()[0]);
 
-    std::vector<const Station *> stations = path.getStations();
+    const std::vector<Station> &stations = map.getStations();
 
-    // Fill with stations
-    int line;
-    for (int idx = 0; idx < stations.size(); idx++)
-    {
-        line = 2*idx + 2; // 2, 4, 6, ...
-        wks.cell("A" + std::to_string(line)).value() = stations[idx]->getOACI();
-        wks.cell("B" + std::to_string(line)).value() = stations[idx]->getName();
-    }
-
-    // Fill with distances and caps
-    for (int idx = 0; idx < stations.size() - 1; idx++)
-    {
-        line = 2 * idx + 3; // 3, 5, 7, ...
-
-        nauticmiles_t distance = geometry::distance(stations[idx]->getLocation(), stations[idx + 1]->getLocation());
-        distance = std::round(distance);
+    // Same columns as the files read by parseMap, rows are filled in order rather than cell by cell
+    auto writeRow = [](OpenXLSX::XLRow &row, const std::array<std::string, FUEL_COLUMN> &fields) {
+        size_t column = 0;
+        for (OpenXLSX::XLCell &cell : row.cells(FUEL_COLUMN)) {
+            cell.value() = fields[column++];
+        }
+    };
 
-        double cap = geometry::cap(stations[idx]->getLocation(), stations[idx + 1]->getLocation());
-        cap = std::round(cap);
+    auto row = worksheet.rows(1, (uint32_t)stations.size() + 1).begin();
+    writeRow(*row, { "Exclure", "code OACI", "Nom", "Lattitude", "Longitude", "Statut", "VFR nuit", "Essence" });
 
-        wks.cell("D" + std::to_string(line)).value() = cap;
-        wks.cell("E" + std::to_string(line)).value() = distance;
+    std::array<std::string, FUEL_COLUMN> fields;
+    for (const Station &s : stations)
+    {
+        ++row;
+        fields[EXCLUDE_COLUMN - 1].assign(s.isExcluded() ? 1 : 0, 'x');
+        fields[OACI_COLUMN - 1] = s.getOACI();
+        fields[NAME_COLUMN - 1] = s.getName();
+        fields[LATITUDE_COLUMN - 1] = coordinate2string(s.getLocation().lat, true);
+        fields[LONGITUDE_COLUMN - 1] = coordinate2string(s.getLocation().lon, false);
+        fields[STATUS_COLUMN - 1] = s.getStatus();
+        fields[NIGHT_VFR_COLUMN - 1] = s.getNightVFR();
+        fields[FUEL_COLUMN - 1] = s.getFuel();
+        writeRow(*row, fields);
     }
 
     doc.save();
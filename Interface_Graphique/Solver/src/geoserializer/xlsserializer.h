@@ -4,7 +4,12 @@
 #include "../geometry.h"
 
 class XLSSerializer : public GeoSerializer {
+private:
+    // Progress is reported and cancellation checked every this many rows
+    static constexpr uint32_t PROGRESS_ROWS = 1024;
+
 public:
-    GeoMap parseMap(const std::filesystem::path &file) const override;
+    GeoMap parseMap(const std::filesystem::path &file, ParseRuntime *runtime = nullptr) const override;
     void writePath(const std::filesystem::path &file, const Path &path) const override;
+    void writeMap(const GeoMap &map, const std::filesystem::path &file) const override;
 };
\ No newline at end of file
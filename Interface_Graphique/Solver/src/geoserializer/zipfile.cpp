@@ -0,0 +1,33 @@
+#include "zipfile.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <zippy.hpp>
+
+void writeZipFile(const std::filesystem::path &file, std::span<const ZipFileEntry> entries)
+{
+    size_t contentSize = 0;
+    for (const ZipFileEntry &entry : entries)
+        contentSize += entry.content.size();
+
+    mz_zip_archive archive{};
+    bool built = mz_zip_writer_init_heap(&archive, 0, contentSize / 4 + 1024);
+    for (const ZipFileEntry &entry : entries) {
+        built = built && mz_zip_writer_add_mem(&archive, entry.name.c_str(), entry.content.data(), entry.content.size(), MZ_BEST_SPEED);
+    }
+    void *archiveData = nullptr;
+    size_t archiveSize = 0;
+    built = built && mz_zip_writer_finalize_heap_archive(&archive, &archiveData, &archiveSize);
+    mz_zip_writer_end(&archive);
+    if (!built) {
+        mz_free(archiveData);
+        throw std::runtime_error("Error while compressing the file \"" + file.string() + "\"");
+    }
+
+    std::ofstream out{ file, std::ios::binary | std::ios::trunc };
+    out.write(static_cast<const char *>(archiveData), archiveSize);
+    mz_free(archiveData);
+    if (!out)
+        throw std::runtime_error("Error while writing the file \"" + file.string() + "\"");
+}
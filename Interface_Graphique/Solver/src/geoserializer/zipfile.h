@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief A file to store in a zip archive, see writeZipFile.
+ */
+struct ZipFileEntry {
+    std::string name;
+    std::string_view content;
+};
+
+/**
+ * @brief Writes a zip archive holding the given entries, compressed with the deflate
+ * implementation vendored with OpenXLSX. \n\n
+ * The archive is built in memory and written at once, entries are compressed with the
+ * fastest level, the documents written by the application are repetitive enough for it
+ * to get most of the gain.
+ * @param file The path to the archive to write, replaced if it exists.
+ * @param entries The files to store, in order.
+ * @throws std::runtime_error if the archive cannot be built or written.
+ */
+void writeZipFile(const std::filesystem::path &file, std::span<const ZipFileEntry> entries);
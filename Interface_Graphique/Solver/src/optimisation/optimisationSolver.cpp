@@ -2,12 +2,14 @@
 
 #define NUMBER_REGION 4
 #define FUEL_SECURITY_PERCENTAGE 0.25
+//Relative margin added to the radius of the spatial index queries, the distance of the policy can be a bit shorter than the exact one
+#define RANGE_SEARCH_MARGIN 0.01
 
 
 #include <map>
 #include <iostream>
 #include <list>
-#include <algorithm>    
+#include <algorithm>
 #include <limits>
 #include <iostream>
 #include <random>
@@ -17,91 +19,66 @@
 
 
 /**
-* Seperate the map into 4 distinct regions : 
+* Seperate the map into 4 distinct regions :
 *	1 - Northwest region (index : 0)
 *	2 - Southwest region (index : 1)
 *	3 - Southeast region (index : 2)
 *	4 - Northeast region (index : 3)
-* This function return a vector of 4 pointers on ProblemMap.
+* This function return a vector of 4 lists of stations, by index in the map.
 */
-std::vector<ProblemMap*> OptimisationSolver::seperateRegion(const ProblemMap& map)
+std::vector<std::vector<problemidx_t>> OptimisationSolver::seperateRegion(const ProblemMap& map)
 {
-	//Initialization 
-	std::vector<ProblemMap*> regions;
-	ProblemMap* regionNorthEast = new ProblemMap();
-	ProblemMap* regionNorthOuest = new ProblemMap();
-	ProblemMap* regionSouthEast = new ProblemMap();
-	ProblemMap* regionSouthOuest = new ProblemMap();
-
-	//Create a map that associates the ProblemMap with it's associated number region
-	std::map<int, ProblemMap*> regionCorrespondance
-	{
-		{0, regionNorthOuest },
-		{1, regionSouthOuest},
-		{2, regionSouthEast},
-		{3, regionNorthEast}
-	};
-	
+	//Initialization : the list of stations of each region is at the index of the region
+	std::vector<std::vector<problemidx_t>> regions(NUMBER_REGION);
 
 	//Check if the station is in any of the imposed limits
-	for (ProblemStation currentProblemStation : map)
+	for (problemidx_t i = 0; i < map.size(); i++)
 	{
 		for (int regionIndice = 0; regionIndice < NUMBER_REGION; regionIndice++)
 		{
-			if (breitling_constraints::isStationInMandatoryRegion(*currentProblemStation.getOriginalStation(), regionIndice))
+			if (map.isInMandatoryRegion(i, regionIndice))
 			{
-				regionCorrespondance[regionIndice]->emplace_back(currentProblemStation);
+				regions[regionIndice].push_back(i);
 			}
 		}
 	}
-	
-	//We aadd the ProblemMap into the vector in the correct order
-	regions.push_back(regionNorthOuest);
-	regions.push_back(regionSouthOuest);
-	regions.push_back(regionSouthEast);
-	regions.push_back(regionNorthEast);
-	
 
 	return regions;
 }
 
 
 /**
-*Initialize the path accordingly to the Dataset : 
+*Initialize the path accordingly to the Dataset :
 * The starting station and the end staion is incuded in the dataset.
-* We select a random station in each region to fulfill the regionds requierments. 
+* We select a random station in each region to fulfill the regionds requierments.
 */
-void OptimisationSolver::initializePath(const std::vector<ProblemMap*> regions, ProblemStation* startingProblemStation, ProblemStation* endProblemStation)
+template<class Distances>
+void OptimisationSolver::initializePath(const ProblemMap& map, const Distances& distances, const std::vector<std::vector<problemidx_t>>& regions, problemidx_t startingProblemStation, problemidx_t endProblemStation)
 {
 	m_chemin.clear();
+	m_pathStations.clear();
 	srand((unsigned)time(NULL));
 	std::random_device rd;
 	std::mt19937 gen(rd());
-	std::uniform_int_distribution<> distributionRegion0(0, regions[0]->size()-1);
-	std::uniform_int_distribution<> distributionRegion1(0, regions[1]->size()-1);
-	std::uniform_int_distribution<> distributionRegion2(0, regions[2]->size()-1);
-	std::uniform_int_distribution<> distributionRegion3(0, regions[3]->size()-1);
-	m_chemin.emplace_back(startingProblemStation);
+	std::uniform_int_distribution<> distributionRegion0(0, regions[0].size()-1);
+	std::uniform_int_distribution<> distributionRegion1(0, regions[1].size()-1);
+	std::uniform_int_distribution<> distributionRegion2(0, regions[2].size()-1);
+	std::uniform_int_distribution<> distributionRegion3(0, regions[3].size()-1);
+	insertInPath(m_chemin.end(), startingProblemStation);
 
-	if (!startingProblemStation->isAccessibleAtNight() && tools::isTimeInNightPeriod(m_dataset.departureTime, m_dataset))
+	if (!map.isAccessibleAtNight(startingProblemStation) && tools::isTimeInNightPeriod(m_dataset.departureTime, m_dataset))
 	{
 		throw std::runtime_error("Departure is done in the night on a station that isn't accessible at night");
 	}
 
 
-	int regionOfStartStation = 0;
 	int regionOfEndStation = 0;
 
-	ProblemStation* northEastProblemStation;
-	ProblemStation* northWestProblemStation;
-	ProblemStation* southEastProblemStation;
-	ProblemStation* southWestProblemStation;
-	
 	for (int i = 0; i < NUMBER_REGION; i++)
 	{
-		for (ProblemStation u : *regions[i])
+		for (problemidx_t u : regions[i])
 		{
-			if (u.getOriginalStation()->getName() == endProblemStation->getOriginalStation()->getName())
+			if (u == endProblemStation)
 			{
 				regionOfEndStation = i;
 			}
@@ -111,115 +88,102 @@ void OptimisationSolver::initializePath(const std::vector<ProblemMap*> regions,
 
 
 	//We select a random station from each region
-	
-	northEastProblemStation = new ProblemStation(regions[0]->at(distributionRegion0(gen)));
-	northWestProblemStation = new ProblemStation((regions[1]->at(distributionRegion1(gen))));
-	southEastProblemStation = new ProblemStation((regions[2]->at(distributionRegion2(gen))));
-	southWestProblemStation = new ProblemStation((regions[3]->at(distributionRegion3(gen))));
+
+	problemidx_t northEastProblemStation = regions[0].at(distributionRegion0(gen));
+	problemidx_t northWestProblemStation = regions[1].at(distributionRegion1(gen));
+	problemidx_t southEastProblemStation = regions[2].at(distributionRegion2(gen));
+	problemidx_t southWestProblemStation = regions[3].at(distributionRegion3(gen));
 
 	//Creation of a distance variable for each station
-	timedistance_t * neDistance = new timedistance_t( geometry::distance(startingProblemStation->getLocation(), northEastProblemStation->getLocation()));
-	timedistance_t * swDistance = new timedistance_t( geometry::distance(startingProblemStation->getLocation(), southWestProblemStation->getLocation()));
-	timedistance_t* seDistance = new timedistance_t( geometry::distance(startingProblemStation->getLocation(), southEastProblemStation->getLocation()));
-	timedistance_t* nwDistance = new timedistance_t( geometry::distance(startingProblemStation->getLocation(), northWestProblemStation->getLocation()));
+	timedistance_t neDistance = nauticMilesBetween(distances, startingProblemStation, northEastProblemStation);
+	timedistance_t swDistance = nauticMilesBetween(distances, startingProblemStation, southWestProblemStation);
+	timedistance_t seDistance = nauticMilesBetween(distances, startingProblemStation, southEastProblemStation);
+	timedistance_t nwDistance = nauticMilesBetween(distances, startingProblemStation, northWestProblemStation);
+
 
-	
 	//A map with the distance as key so that we can get the station associated
-	std::map<timedistance_t*, ProblemStation*> distanceProblemStation
+	std::map<timedistance_t*, problemidx_t> distanceProblemStation
 	{
-		{neDistance, northEastProblemStation},
-		{swDistance, southWestProblemStation},
-		{seDistance, southEastProblemStation},
-		{nwDistance, northWestProblemStation},
+		{&neDistance, northEastProblemStation},
+		{&swDistance, southWestProblemStation},
+		{&seDistance, southEastProblemStation},
+		{&nwDistance, northWestProblemStation},
 	};
 
 	//A map that connects the distance with the correct region
 	std::map<int ,timedistance_t*> orderStation
 	{
-		{0,nwDistance},
-		{1,swDistance},
-		{2,seDistance},
-		{3,neDistance},
+		{0,&nwDistance},
+		{1,&swDistance},
+		{2,&seDistance},
+		{3,&neDistance},
 	};
 
-	
+
 	//We compare the distance to find the closest point to the starting point
-	
-	//This vector contains a list of the calculated distances 
+
+	//This vector contains a list of the calculated distances
 	std::vector<timedistance_t*> distanceVector;
-	distanceVector.emplace_back(neDistance);
-	distanceVector.emplace_back(swDistance);
-	distanceVector.emplace_back(seDistance);
-	distanceVector.emplace_back(nwDistance);
+	distanceVector.emplace_back(&neDistance);
+	distanceVector.emplace_back(&swDistance);
+	distanceVector.emplace_back(&seDistance);
+	distanceVector.emplace_back(&nwDistance);
 
-	//If the end problem station is already in a region, we do not have to add a random station in that specific region 
+	//If the end problem station is already in a region, we do not have to add a random station in that specific region
 	/*/if (regionOfEndStation > 0)
 	{
 		auto it = std::find(distanceVector.begin(), distanceVector.end(), orderStation[regionOfEndStation]);
 		distanceVector.erase(it);
 	}*/
-	
+
 	////We find the closest station to the last station added to the path
 	while (!distanceVector.empty())
-	{	
-		
-		std::list<timedistance_t> closestStation;
-		for (timedistance_t* i : distanceVector)
-		{
-			closestStation.emplace_back(*i);
-		}
-
-		closestStation.sort();
+	{
 		distanceVector = tools::SortTimeDistance(distanceVector);
-	
-		ProblemStation* closestProblemStation = distanceProblemStation[distanceVector.front()];
+
+		problemidx_t closestProblemStation = distanceProblemStation[distanceVector.front()];
 
 		//If the end station is a part of the region, we do not add it during the sorting but at the end
-		if (endProblemStation->getOriginalStation()->getName() != distanceProblemStation[distanceVector.front()]->getOriginalStation()->getName())
+		if (endProblemStation != closestProblemStation)
 		{
-			m_chemin.emplace_back(distanceProblemStation[distanceVector.front()]);
+			insertInPath(m_chemin.end(), closestProblemStation);
 		}
-		
-		/*std::cout << "The name of the addded station" << closestProblemStation->getName() << std::endl;*/
 
 		//We calculate the distance of every station compared to the last added station
-		*neDistance =  geometry::distance(closestProblemStation->getLocation(), northEastProblemStation->getLocation());
-		*swDistance =  geometry::distance(closestProblemStation->getLocation(), southWestProblemStation->getLocation());
-		*seDistance =  geometry::distance(closestProblemStation->getLocation(), southEastProblemStation->getLocation());
-		*nwDistance =  geometry::distance(closestProblemStation->getLocation(), northWestProblemStation->getLocation());
+		neDistance = nauticMilesBetween(distances, closestProblemStation, northEastProblemStation);
+		swDistance = nauticMilesBetween(distances, closestProblemStation, southWestProblemStation);
+		seDistance = nauticMilesBetween(distances, closestProblemStation, southEastProblemStation);
+		nwDistance = nauticMilesBetween(distances, closestProblemStation, northWestProblemStation);
 		distanceVector.erase(distanceVector.begin());
 
 	}
-	
-	m_chemin.emplace_back(endProblemStation);
+
+	insertInPath(m_chemin.end(), endProblemStation);
 
 
 
 }
 
-ProblemPath OptimisationSolver::adaptProblemPath(const std::vector<const ProblemStation*>& path)
+ProblemPath OptimisationSolver::solveForPath(const ProblemMap& map, SolverRuntime* runtime)
 {
-	ProblemPath adapted;
-	adapted.reserve(path.size());
-	for (const ProblemStation* s : path)
-		adapted.push_back(*s);
-	return adapted;
+	indexMap(map);
+	return withDistancePolicy(m_distancePolicy, map, [&](const auto& distances) { return solve(map, distances, runtime); }, m_artifactCache);
 }
 
-ProblemPath OptimisationSolver::solveForPath(const ProblemMap& map, SolverRuntime* runtime)
+template<class Distances>
+ProblemPath OptimisationSolver::solve(const ProblemMap& map, const Distances& distances, SolverRuntime* runtime)
 {
 	srand((unsigned)time(NULL));
 	bool doablePath = false;
 	bool pathLongEnough = false;
-	bool validPath; 
-	std::vector<ProblemStation*> skipList{};
-	std::vector<const ProblemStation*> *comparePath = new std::vector<const ProblemStation*>;
-	ProblemStation startingProblemStation = map[m_dataset.departureStation];
-	ProblemStation endProblemStation = map[m_dataset.targetStation];
+	bool validPath;
+	ProblemPath comparePath;
+	const problemidx_t startingProblemStation = (problemidx_t)m_dataset.departureStation;
+	const problemidx_t endProblemStation = (problemidx_t)m_dataset.targetStation;
 	ProblemPath currentSolution{}, bestSolution{};
 	const  int maximumNumberOfSearches = 200;
 	float progressSpeed = static_cast<float>(1) / maximumNumberOfSearches;
-	
+
 
 	do
 	{
@@ -227,33 +191,23 @@ ProblemPath OptimisationSolver::solveForPath(const ProblemMap& map, SolverRuntim
 		pathLongEnough = false;
 		validPath = false;
 
-		initializePath(seperateRegion(map), &startingProblemStation, &endProblemStation);
-		addRefuelStationIfFirstStationUnreachable(map, m_chemin);
-		//std::cout << std::endl << "Does if statisfy fuel usage = " << breitling_constraints::satisfiesFuelConstraints(m_dataset,chemin) << std::endl;
+		initializePath(map, distances, seperateRegion(map), startingProblemStation, endProblemStation);
+		addRefuelStationIfFirstStationUnreachable(map, distances, m_chemin);
 		while (!(doablePath && pathLongEnough))
 		{
 
 			resetTestVariable();
-			//interface_mock::writePathToFile(map, transformToPath(chemin), "out.svg");
-			for (std::vector<const ProblemStation*>::iterator iteratorStation = m_chemin.begin(); iteratorStation != m_chemin.end() - 1 && m_chemin.size() < breitling_constraints::MINIMUM_STATION_COUNT /* && chemin.size() < 100 */; ++iteratorStation)
+			for (ProblemPath::iterator iteratorStation = m_chemin.begin(); iteratorStation != m_chemin.end() - 1 && m_chemin.size() < breitling_constraints::MINIMUM_STATION_COUNT /* && chemin.size() < 100 */; ++iteratorStation)
 			{
 
-				std::vector <ProblemStation*> selectionGroup = connectProblemStationsTogether(map, *iteratorStation[0], *iteratorStation[1], m_travel, false);
+				ProblemPath selectionGroup = connectProblemStationsTogether(map, distances, iteratorStation[0], iteratorStation[1], m_travel, false);
 				if (selectionGroup.empty())
 				{
-					findIntermidiateRefillableStation(map, m_chemin, m_travel);
+					findIntermidiateRefillableStation(map, distances, m_travel);
 				}
-				for (ProblemStation* groupProblemStation : selectionGroup)
+				for (problemidx_t groupProblemStation : selectionGroup)
 				{
-					iteratorStation = m_chemin.insert(iteratorStation + 1, groupProblemStation);
-					/*	TestPath(chemin);*/
-					if (selectionGroup.size() > 2)
-					{
-
-					}
-
-
-
+					iteratorStation = insertInPath(iteratorStation + 1, groupProblemStation);
 				}
 				if (m_chemin.size() >= breitling_constraints::MINIMUM_STATION_COUNT)
 				{
@@ -262,29 +216,29 @@ ProblemPath OptimisationSolver::solveForPath(const ProblemMap& map, SolverRuntim
 
 			}
 
-			if (findProblematicProblemStation(m_chemin, m_travel) != m_chemin.size())
+			if (findProblematicProblemStation(map, distances, m_travel) != m_chemin.size())
 			{
-				findIntermidiateRefillableStation(map, m_chemin, m_travel);
+				findIntermidiateRefillableStation(map, distances, m_travel);
 			}
-			if (breitling_constraints::satisfiesFuelConstraints(m_dataset, adaptProblemPath(m_chemin)) == true)
+			if (breitling_constraints::satisfiesFuelConstraints(map, m_dataset, m_chemin) == true)
 			{
 				doablePath = true;
 			}
 			else
 			{
 				doablePath = false;
-				findIntermidiateRefillableStation(map, m_chemin, m_travel);
+				findIntermidiateRefillableStation(map, distances, m_travel);
 
 				if (m_chemin.size() >= breitling_constraints::MINIMUM_STATION_COUNT)
 				{
 
-					initializePath(seperateRegion(map), &startingProblemStation, &endProblemStation);
+					initializePath(map, distances, seperateRegion(map), startingProblemStation, endProblemStation);
 				}
 
 			}
 
 			//Protection system that check that the path has been changed if not hat means that there has been a problem with the number of disponible stations.
-			if (!hasThePathBeenChanged(comparePath))
+			if (!hasThePathBeenChanged(&comparePath))
 			{
 
 				//std::cout << "time? " << breitling_constraints::satisfiesTimeConstraints(breitlingData, path)
@@ -295,28 +249,28 @@ ProblemPath OptimisationSolver::solveForPath(const ProblemMap& map, SolverRuntim
 
 		}
 
-		validPath = breitling_constraints::satisfiesFuelConstraints(m_dataset, adaptProblemPath(m_chemin)) && breitling_constraints::satisfiesPathConstraints(map, m_dataset, adaptProblemPath(m_chemin)) && breitling_constraints::satisfiesRegionsConstraints(adaptProblemPath(m_chemin)) && breitling_constraints::satisfiesStationCountConstraints(adaptProblemPath(m_chemin));
+		currentSolution = m_chemin;
+		validPath = breitling_constraints::satisfiesFuelConstraints(map, m_dataset, currentSolution) && breitling_constraints::satisfiesPathConstraints(map, m_dataset, currentSolution) && breitling_constraints::satisfiesRegionsConstraints(map, currentSolution) && breitling_constraints::satisfiesStationCountConstraints(currentSolution);
 
-		currentSolution = adaptProblemPath(m_chemin);
 		if (bestSolution.empty())
 		{
 			bestSolution = currentSolution;
 		}else
-		if (getLength(currentSolution) / m_dataset.planeSpeed < getLength(bestSolution) / m_dataset.planeSpeed && validPath)
+		if (getLength(map, currentSolution) / m_dataset.planeSpeed < getLength(map, bestSolution) / m_dataset.planeSpeed && validPath)
 		{
 			bestSolution = currentSolution;
 		}
 
-		runtime->foundSolutionCount = (getLength(bestSolution) / m_dataset.planeSpeed < 24);
+		runtime->foundSolutionCount = (getLength(map, bestSolution) / m_dataset.planeSpeed < 24);
 		runtime->discoveredSolutionCount += 1;
 		runtime->currentProgress += progressSpeed;
-		
-	std::cout << "Progress Bar : " << runtime->discoveredSolutionCount << " ---  " << "Time of solution : " << getLength(currentSolution) / m_dataset.planeSpeed << " ->  " << getLength(bestSolution) / m_dataset.planeSpeed << std::endl;
+
+	std::cout << "Progress Bar : " << runtime->discoveredSolutionCount << " ---  " << "Time of solution : " << getLength(map, currentSolution) / m_dataset.planeSpeed << " ->  " << getLength(map, bestSolution) / m_dataset.planeSpeed << std::endl;
 
 	} while (runtime->currentProgress < 1 && runtime->foundSolutionCount != 1);
-		
-	
-	
+
+
+
 	return bestSolution;
 }
 
@@ -324,141 +278,133 @@ ProblemPath OptimisationSolver::solveForPath(const ProblemMap& map, SolverRuntim
 
 
 
+/*
+* Builds the spatial index and the masks of refuel/night stations used by RefuelableStation, once per map
+*/
+void OptimisationSolver::indexMap(const ProblemMap& map)
+{
+	m_spatialIndex = SpatialIndex{ getUnitVectors(map) };
+	m_refuelStations = DynamicBitSet(map.size());
+	m_nightStations = DynamicBitSet(map.size());
+	m_pathStations = DynamicBitSet(map.size());
+	for (size_t i = 0; i < map.size(); i++)
+	{
+		if (map.canBeUsedToFuel(i))
+			m_refuelStations.setSet(i);
+		if (map.isAccessibleAtNight(i))
+			m_nightStations.setSet(i);
+	}
+}
+
 /**
 * Searches for stations that can be reached with the current disponible fuel
 * If refuable is equal to true, then a condition is placed on the search : We only select station that can be use to refuel the plane
+* The indices of the stations in the map are written to reachableStations in increasing order, along with their distance to centerProblemStation
+* The range is checked on the distances of the policy, the spatial index only preselects the stations
 */
-
-std::vector<ProblemStation> OptimisationSolver::RefuelableStation(const ProblemMap& map, const ProblemStation& centerProblemStation, travel_variables travel, bool refuable)
+template<class Distances>
+void OptimisationSolver::RefuelableStation(const ProblemMap& map, const Distances& distances, problemidx_t centerProblemStation, const travel_variables& travel, bool refuable, std::vector<SpatialIndex::Neighbour>& reachableStations)
 {
-	
-	std::vector<ProblemStation> reachablePoint;
+	reachableStations.clear();
 	double quantityOfFuelLeft = m_dataset.planeFuelCapacity - travel.distanceSinceLastRefuel / m_dataset.planeSpeed * m_dataset.planeFuelUsage;
 	//Max distance of with the current remaining fuel
 	double maxDistanceOfTravel = quantityOfFuelLeft * m_dataset.planeFuelUsage / m_dataset.planeSpeed;
 
-	//It is not necessary to look for reachble stations if the max distance that we can go is negatif 
-	if (maxDistanceOfTravel > 0)
+	//It is not necessary to look for reachble stations if the max distance that we can go is negatif
+	if (maxDistanceOfTravel <= 0)
 	{
-		for (ProblemStation point : map)
-		{
+		return;
+	}
 
-			timedistance_t distanceBetweenPoints = (geometry::distance(centerProblemStation.getLocation(), point.getLocation())) / m_dataset.planeSpeed;
-			//If the distance between the two point is smaller than the maximum travel distance
-			
-			if (distanceBetweenPoints < maxDistanceOfTravel) 
-			{
-				daytime_t timeAtArrival = geometry::distance(centerProblemStation.getLocation(), point.getLocation()) / m_dataset.planeSpeed;
-				bool nightTime = tools::isTimeInNightPeriod(travel.currentTime + timeAtArrival, m_dataset);
-				
-				//If there is a need for the station to be a station that can be used to refuel the plane
-				if (refuable)
-				{
-					
-					//We check that the station is a refuel point
-					if (point.canBeUsedToFuel())
-					{
-						if (nightTime)
-						{
-							if (point.isAccessibleAtNight())
-							{
-								reachablePoint.push_back(point);
-							}
-						}
-						else
-						{
-							reachablePoint.push_back(point);
-						}
-						
-					}
-				}
-				else
-				{
-					//We add it simply to the list
-					if (nightTime)
-					{
-						if (point.isAccessibleAtNight())
-						{
-							reachablePoint.push_back(point);
-						}
-					}
-					else
-					{
-						reachablePoint.push_back(point);
-					}
-				}
-			}
+	//The spatial index and the masks are only built once per map
+	if (m_spatialIndex.size() != map.size())
+	{
+		indexMap(map);
+	}
 
-		}
+	//Only the stations that can be used to refuel the plane are preselected when refuable is true
+	m_spatialIndex.withinRadius(getUnitVectors(map)[centerProblemStation], maxDistanceOfTravel * m_dataset.planeSpeed * (1 + RANGE_SEARCH_MARGIN), [&](size_t station, nauticmiles_t) {
+		return !refuable || m_refuelStations.isSet(station);
+	}, reachableStations);
+
+	//A station is kept if it is closer than the maximum travel distance, and if it is accessible at night when the plane
+	//would land there during the night, its distance is replaced by the one of the policy
+	size_t keptStations = 0;
+	for (const SpatialIndex::Neighbour& neighbour : reachableStations)
+	{
+		nauticmiles_t distance = nauticMilesBetween(distances, centerProblemStation, neighbour.index);
+		timedistance_t distanceBetweenPoints = distance / m_dataset.planeSpeed;
+		if (distanceBetweenPoints >= maxDistanceOfTravel)
+			continue;
+		if (!m_nightStations.isSet(neighbour.index) && tools::isTimeInNightPeriod(travel.currentTime + distanceBetweenPoints, m_dataset))
+			continue;
+		reachableStations[keptStations++] = { neighbour.index, distance };
 	}
+	reachableStations.resize(keptStations);
 
+	//Stations are listed in the map order, so that ties are broken the same way whatever the layout of the index
+	std::sort(reachableStations.begin(), reachableStations.end(), [](const SpatialIndex::Neighbour& a, const SpatialIndex::Neighbour& b) { return a.index < b.index; });
+}
 
-	return reachablePoint;
+//Inserts station in the path before position, returns an iterator to the inserted station
+ProblemPath::iterator OptimisationSolver::insertInPath(ProblemPath::const_iterator position, problemidx_t station)
+{
+	m_pathStations.setSet(station);
+	return m_chemin.insert(position, station);
 }
 
 
 /*
-* We select a station from all the reachble station from the a starting point and we give the each station a score. 
-* The goal is to select the station that has the loest score 
+* We select a station from all the reachble station from the a starting point and we give the each station a score.
+* The goal is to select the station that has the loest score
+* Stations of the skip list (by index in the map) and of the path cannot be selected
+* Returns NO_STATION if no station can be selected
 */
-
-ProblemStation* OptimisationSolver::stationSelectionInReach(const ProblemMap& map, const ProblemStation& startProblemStation, const ProblemStation& destinationProblemStation, std::vector<ProblemStation*> skipList, travel_variables* travel, bool refuelable)
+template<class Distances>
+problemidx_t OptimisationSolver::stationSelectionInReach(const ProblemMap& map, const Distances& distances, problemidx_t startProblemStation, problemidx_t destinationProblemStation, const DynamicBitSet& skipList, travel_variables* travel, bool refuelable)
 {
-	//Iterate for each station in the reachable station to find witch station has the best closest to destinationProblemStation/farthest to startProblemStation ration. 
-	ProblemStation* SelectedProblemStation{};
-    bool ElementInPath = false;
+	//Iterate for each station in the reachable station to find witch station has the best closest to destinationProblemStation/farthest to startProblemStation ration.
+	problemidx_t SelectedProblemStation = NO_STATION;
     timedistance_t ratio = std::numeric_limits<timedistance_t>::max();
-	std::vector<ProblemStation> reachableProblemStations{};
-	Station* destinationStation = (Station*)destinationProblemStation.getOriginalStation();
-	timedistance_t calculatedRatio;
-	Location halfWayPoint = tools::findHalfWayCoordinates(startProblemStation.getLocation(), destinationProblemStation.getLocation());
+	std::vector<SpatialIndex::Neighbour>& reachableProblemStations = m_neighboursBuffer;
+	Location halfWayPoint = tools::findHalfWayCoordinates(map.getLocation(startProblemStation), map.getLocation(destinationProblemStation));
+
+	RefuelableStation(map, distances, startProblemStation, *travel, refuelable, reachableProblemStations);
 
-	reachableProblemStations = RefuelableStation(map, startProblemStation, *travel,refuelable);
-	
 	//If there is no reachable station, there is no selection possible
 	if (reachableProblemStations.empty())
 	{
-		return nullptr;
+		return NO_STATION;
 	}
 
-	for (ProblemStation i : reachableProblemStations)
+	for (const SpatialIndex::Neighbour& neighbour : reachableProblemStations)
 	{
-		const Station* currentStation = i.getOriginalStation();
-		timedistance_t calculatedRatio, midwayPoint;
-		midwayPoint = (geometry::distance(destinationProblemStation.getLocation(), startProblemStation.getLocation()) / 2);
-	
-		calculatedRatio = geometry::distance(halfWayPoint, i.getLocation());
-		
-		if (geometry::distance(i.getLocation(), startProblemStation.getLocation()) + travel->distanceSinceLastRefuel / m_dataset.planeSpeed * m_dataset.planeFuelUsage > 0)
+		const problemidx_t i = (problemidx_t)neighbour.index;
+		timedistance_t calculatedRatio = geometry::distance(halfWayPoint, map.getLocation(i));
+
+		if (neighbour.distance + travel->distanceSinceLastRefuel / m_dataset.planeSpeed * m_dataset.planeFuelUsage > 0)
 		{
 			travel_variables trajet = *travel;
-			trajet.distanceSinceLastRefuel = +geometry::distance(i.getLocation(), startProblemStation.getLocation());
+			trajet.distanceSinceLastRefuel = +neighbour.distance;
 			float remainingFuel = m_dataset.planeFuelCapacity - trajet.distanceSinceLastRefuel / m_dataset.planeSpeed * m_dataset.planeFuelUsage;
 			if (remainingFuel > 0)
 			{
-				if (tools::ProblemStationInProblemStationVector(skipList, i) == false && currentStation->getName() == destinationStation->getName())
+				if (!skipList.isSet(i) && i == destinationProblemStation)
 				{
-					SelectedProblemStation = new ProblemStation(i);
-
-					return SelectedProblemStation;
-				} 
+					return i;
+				}
 
-				if (calculatedRatio < ratio && tools::ProblemStationInPath(m_chemin, i) == false && tools::ProblemStationInProblemStationVector(skipList, i) == false)
+				if (calculatedRatio < ratio && !m_pathStations.isSet(i) && !skipList.isSet(i))
 				{
-					SelectedProblemStation = new ProblemStation(i);
+					SelectedProblemStation = i;
 					ratio = calculatedRatio;
-					//std::cout << SelectedProblemStation->getName() << std::endl;
 				}
-				ElementInPath = false;
 			}
-			
-		}
 
-	
+		}
 
 	}
 
-	//std::cout << SelectedProblemStation->getName() << std::endl;
 	return SelectedProblemStation;
 }
 
@@ -475,35 +421,34 @@ void OptimisationSolver::resetTestVariable()
 /*
 Finds the station which cannot be reached because the remaining fuel isn't sufficient and add a station that can be used to refuel the plane before the problematic station
 */
-void OptimisationSolver::findIntermidiateRefillableStation(const ProblemMap& map, const std::vector<const ProblemStation*> path, travel_variables * travel)
+template<class Distances>
+void OptimisationSolver::findIntermidiateRefillableStation(const ProblemMap& map, const Distances& distances, travel_variables * travel)
 {
-	
-
-	//TestPath(chemin);
 	bool noMoreProblem = false;
 	travel_variables* voyage = travel;
 	do
 	{
 		//Pointe the iterator to the problematic station
-		std::vector< const ProblemStation*>::iterator stationIterator = m_chemin.begin() + findProblematicProblemStation(m_chemin, voyage);
+		ProblemPath::iterator stationIterator = m_chemin.begin() + findProblematicProblemStation(map, distances, voyage);
 		//If the iterator points to the last station in the path, then there is no problem detected so there is no need to correct the station
 		if (stationIterator != m_chemin.end())
 		{
 
 			do
 			{
-				//We add a station before the problematic station : 
+				//We add a station before the problematic station :
 				//if there is no station that the plane can fly to with the current disponible fuel, than we need to go back again
 				stationIterator = stationIterator - 1;
-				updateTravelVariable(voyage, *stationIterator);
-			
-			} while (RefuelableStation(map, *stationIterator[0], *voyage,true).empty());
+				updateTravelVariable(map, distances, voyage, *stationIterator);
+
+				RefuelableStation(map, distances, *stationIterator, *voyage, true, m_neighboursBuffer);
+			} while (m_neighboursBuffer.empty());
 
 			//We add the station(s)
-			std::vector<ProblemStation* > groupOfProblemStation = connectProblemStationsTogether(map, *stationIterator[0], *stationIterator[1], voyage, true);
-			for (ProblemStation* emergencyProblemStation : groupOfProblemStation)
+			ProblemPath groupOfProblemStation = connectProblemStationsTogether(map, distances, stationIterator[0], stationIterator[1], voyage, true);
+			for (problemidx_t emergencyProblemStation : groupOfProblemStation)
 			{
-				stationIterator = m_chemin.insert(stationIterator + 1, emergencyProblemStation);
+				stationIterator = insertInPath(stationIterator + 1, emergencyProblemStation);
 
 			}
 		}
@@ -515,98 +460,83 @@ void OptimisationSolver::findIntermidiateRefillableStation(const ProblemMap& map
 
 
 	} while (!noMoreProblem);
-	//TestPath(chemin);
 
 }
 
-//Transform a <const ProblemStation*> vector into a Path
-Path OptimisationSolver::transformToPath(ProblemPath path)
+//Transform a ProblemPath into a Path
+Path OptimisationSolver::transformToPath(const ProblemMap& map, const ProblemPath& path)
 {
 	Path trajet{};
 
-	for ( ProblemStation iterator : path)
+	for (problemidx_t iterator : path)
 	{
-		trajet.getStations().emplace_back(iterator.getOriginalStation());
+		trajet.getStations().emplace_back(map.getOriginalStation(iterator));
 	}
 	return trajet;
 }
 
-//A special problem can be face when we add a random station to the path: 
+//A special problem can be face when we add a random station to the path:
 //The distance between the start station and the first station may not be reachable by the plan so we add a station that can be used as a refuel station to connect the starting station and the first station
-void OptimisationSolver::addRefuelStationIfFirstStationUnreachable(const ProblemMap& map, std::vector<const ProblemStation*> path)
+template<class Distances>
+void OptimisationSolver::addRefuelStationIfFirstStationUnreachable(const ProblemMap& map, const Distances& distances, ProblemPath path)
 {
 	travel_variables voyage;
 	double quantityOfFuelLeft =0;
 	//Max travel time with the current remaining fuel
 	double maxTimeTravel =0;
-	std::vector<ProblemStation*> skip{};
-	
+	DynamicBitSet skip(map.size());
+
 
 	do
 	{
-		updateTravelVariable(&voyage, path[1]);
+		updateTravelVariable(map, distances, &voyage, path[1]);
 		quantityOfFuelLeft = m_dataset.planeFuelCapacity - voyage.distanceSinceLastRefuel / m_dataset.planeSpeed * m_dataset.planeFuelUsage;
 		maxTimeTravel = quantityOfFuelLeft * m_dataset.planeFuelUsage / m_dataset.planeSpeed;
 		if (maxTimeTravel < 0)
 		{
-			path.insert( path.begin()+1, stationSelectionInReach(map, *path[0], *path[1], skip, &voyage, true) );
+			path.insert( path.begin()+1, stationSelectionInReach(map, distances, path[0], path[1], skip, &voyage, true) );
 		}
 
 	}while(maxTimeTravel < 0);
-	
+
 }
 
-bool OptimisationSolver::hasThePathBeenChanged(std::vector<const ProblemStation*> *path)
+bool OptimisationSolver::hasThePathBeenChanged(ProblemPath *path)
 {
-	
-	if ( m_chemin.size() != path->size())
-	{
-		copyPathToObject(path);
-		return true;
-		
-	}
-	for (size_t index = 0; index < path->size(); ++index)
+	if (m_chemin == *path)
 	{
-		std::vector<const ProblemStation*> compareStation = *path;
-		if (m_chemin[index]->getOriginalStation()->getName() != compareStation[index]->getOriginalStation()->getName())
-		{
-			copyPathToObject(path);
-			return true;
-			
-		}
+		return false;
 	}
-	
-	return false;
+	copyPathToObject(path);
+	return true;
 }
 
-void OptimisationSolver::copyPathToObject(std::vector<const ProblemStation*> *copy)
+void OptimisationSolver::copyPathToObject(ProblemPath *copy)
 {
-	copy->clear();
-	for (const ProblemStation* stations : m_chemin)
-	{
-		copy->emplace_back(stations);
-	}
+	*copy = m_chemin;
 }
 
 
 
 
 
-//Update the travel variable up to the selected point in the 
-void OptimisationSolver::updateTravelVariable(travel_variables* travel, const ProblemStation* point)
+//Update the travel variable up to the selected point in the
+template<class Distances>
+void OptimisationSolver::updateTravelVariable(const ProblemMap& map, const Distances& distances, travel_variables* travel, problemidx_t point)
 {
 	bool reachedSelectedProblemStation = false;
 	travel->flightDistance = 0;
-	for (std::vector<const ProblemStation*>::iterator iteratorProblemStation = m_chemin.begin() + 1; iteratorProblemStation != m_chemin.end() && !reachedSelectedProblemStation; ++iteratorProblemStation)
+	for (ProblemPath::iterator iteratorProblemStation = m_chemin.begin() + 1; iteratorProblemStation != m_chemin.end() && !reachedSelectedProblemStation; ++iteratorProblemStation)
 	{
-		travel->flightDistance = geometry::distance(iteratorProblemStation[-1]->getLocation(), iteratorProblemStation[0]->getLocation());
+		nauticmiles_t legDistance = nauticMilesBetween(distances, iteratorProblemStation[-1], iteratorProblemStation[0]);
+		travel->flightDistance = legDistance;
 		travel->currentTime = m_dataset.departureTime + travel->flightDistance / m_dataset.planeSpeed;
-		travel->distanceSinceLastRefuel =+geometry::distance(iteratorProblemStation[-1]->getLocation(), iteratorProblemStation[0]->getLocation());
-		if (iteratorProblemStation[0]->canBeUsedToFuel())
+		travel->distanceSinceLastRefuel =+legDistance;
+		if (map.canBeUsedToFuel(iteratorProblemStation[0]))
 		{
 			travel->distanceSinceLastRefuel = 0;
 		}
-		if (point->getOriginalStation()->getName() == iteratorProblemStation[0]->getOriginalStation()->getName())
+		if (point == iteratorProblemStation[0])
 		{
 			reachedSelectedProblemStation = true;
 		}
@@ -618,23 +548,22 @@ void OptimisationSolver::updateTravelVariable(travel_variables* travel, const Pr
 /*Connect 2 distants points in a path
 The connection return the stations between 0 to n stations between the two points : 0 if there is no station that can connect the two points or else n stations that connect the 2 points
 */
-std::vector<ProblemStation*> OptimisationSolver::connectProblemStationsTogether(const ProblemMap& map, const ProblemStation& startProblemStation, const ProblemStation& endProblemStation, travel_variables* travel, bool refuelable)
+template<class Distances>
+ProblemPath OptimisationSolver::connectProblemStationsTogether(const ProblemMap& map, const Distances& distances, problemidx_t startProblemStation, problemidx_t endProblemStation, travel_variables* travel, bool refuelable)
 {
-	
-	std::vector<ProblemStation*> resultProblemStation;
-	std::vector<ProblemStation*> skipList;
-	ProblemStation *SelectedProblemStation{};
-	ProblemStation *currentProblemStation = (ProblemStation*)&startProblemStation;
-	const Station* endStation = endProblemStation.getOriginalStation();
+	ProblemPath resultProblemStation;
+	DynamicBitSet skipList(map.size());
+	problemidx_t SelectedProblemStation;
+	problemidx_t currentProblemStation = startProblemStation;
 	bool elementAdded = false;
 	bool firstElementAdded = false;
 	bool errorPassage = false;
-	
-	
+
+
 	// At everypassage, we add a new station even if the next station is in reach
-	//This operation make it so that at least, one station is added at each passage 
-	skipList.emplace_back(new ProblemStation(endProblemStation));
-	
+	//This operation make it so that at least, one station is added at each passage
+	skipList.setSet(endProblemStation);
+
 	do
 	{
 		//Security mesure : If the remaining fuel is lower than FUEL_SECURITY_PERCENTAGE, the next station need to be a refuelable station
@@ -643,28 +572,27 @@ std::vector<ProblemStation*> OptimisationSolver::connectProblemStationsTogether(
 			refuelable = true;
 		}
 		//If there is no station selected, than this route isn't vailable so we return an empty vector
-		SelectedProblemStation = stationSelectionInReach(map, *currentProblemStation, endProblemStation, skipList, travel, refuelable);
-		if (nullptr == SelectedProblemStation)
+		SelectedProblemStation = stationSelectionInReach(map, distances, currentProblemStation, endProblemStation, skipList, travel, refuelable);
+		if (NO_STATION == SelectedProblemStation)
 		{
 			if (resultProblemStation.empty() || (errorPassage && resultProblemStation.empty()))
 			{
-				return std::vector<ProblemStation*>();
+				return ProblemPath();
 			}
 			else
 			{
 				errorPassage = true;
-				skipList.emplace_back(resultProblemStation[0]);
-				SelectedProblemStation = (ProblemStation*)&startProblemStation;
+				skipList.setSet(resultProblemStation[0]);
+				SelectedProblemStation = startProblemStation;
 			}
-			
-			
+
+
 		}
 		errorPassage = false;
-		nauticmiles_t currentDistance = geometry::distance(currentProblemStation->getLocation(), SelectedProblemStation->getLocation());
+		nauticmiles_t currentDistance = nauticMilesBetween(distances, currentProblemStation, SelectedProblemStation);
 		travel->flightDistance = travel->flightDistance  + currentDistance;
-		//travel->currentTime = m_dataset.departureTime + travel->flightDistance / m_dataset.planeSpeed;
 		travel->currentTime = fmod(m_dataset.departureTime + travel->flightDistance / m_dataset.planeSpeed,24.f);
-		if (!SelectedProblemStation->canBeUsedToFuel())
+		if (!map.canBeUsedToFuel(SelectedProblemStation))
 		{
 			travel->distanceSinceLastRefuel = travel->distanceSinceLastRefuel + currentDistance;
 		}
@@ -677,14 +605,12 @@ std::vector<ProblemStation*> OptimisationSolver::connectProblemStationsTogether(
 		//If the remaining fuel is superior to 0, that the selected station can be reached so we add the station to the connection vector between the 2 points in the path
 		if (remainingFuel > 0)
 		{
-		
+
 			elementAdded = true;
 			firstElementAdded = true;
 			//Station added to the connexion station
-			resultProblemStation.emplace_back(SelectedProblemStation);
-			skipList.emplace_back(SelectedProblemStation);
-			
-		
+			resultProblemStation.push_back(SelectedProblemStation);
+			skipList.setSet(SelectedProblemStation);
 
 		}
 		else
@@ -692,61 +618,52 @@ std::vector<ProblemStation*> OptimisationSolver::connectProblemStationsTogether(
 			//If the fuel left in the plane isn't enough to cover the distance, we search for an other station that will permit us to do the route. We reset our travel variable
 			travel->flightDistance = travel->flightDistance - currentDistance;
 			travel->currentTime = m_dataset.departureTime + travel->flightDistance / m_dataset.planeSpeed;
-			if (!SelectedProblemStation->canBeUsedToFuel())
+			if (!map.canBeUsedToFuel(SelectedProblemStation))
 			{
 				travel->distanceSinceLastRefuel = travel->distanceSinceLastRefuel - currentDistance;
 			}
-			skipList.emplace_back(SelectedProblemStation);
+			skipList.setSet(SelectedProblemStation);
 			elementAdded = false;
 		}
-		
+
 		//If the element is valid, we can add it to the connexion vecor
 		if (elementAdded == true && firstElementAdded)
 		{
-			refuelable = false;
 			skipList.clear();
 			currentProblemStation = SelectedProblemStation;
 			elementAdded = false;
 			refuelable = false;
 			//We cannot add this station that are already in the connexion vector
-			for(ProblemStation *  i : resultProblemStation)
+			for (problemidx_t i : resultProblemStation)
 			{
-				skipList.emplace_back(i);
+				skipList.setSet(i);
 			}
-			/*if (resultProblemStation.size() == 3)
-			{
-				std::cout << "Night" << std::endl;
-			}*/
-			
 		}
-	
-	
-		
 
-	} while (endStation->getName() != currentProblemStation->getOriginalStation()->getName()); // This loop is to be done until the selected station is the destination station
-	
+	} while (endProblemStation != currentProblemStation); // This loop is to be done until the selected station is the destination station
+
 	//The last station added is always the destination station so  we need to remove it because it is already in the path
 	resultProblemStation.pop_back();
-	
-	
+
+
 	return resultProblemStation;
 }
 
 //Find the station in a path where the remaining fuel is < 0. In this situation, it means that this station cannot be reached. If there is no problematic station, the method return le number associated to the last station with corrrespond to the size of the path.
 //If there is a problematic station, this method return its index and update the travel variable.
-size_t  OptimisationSolver::findProblematicProblemStation(std::vector<const ProblemStation*> path, travel_variables* travel)
+template<class Distances>
+size_t  OptimisationSolver::findProblematicProblemStation(const ProblemMap& map, const Distances& distances, travel_variables* travel)
 {
 
 	nauticmiles_t currentDistance = 0;
 	nauticmiles_t distanceSinceLastRefuel = 0;
 	for (size_t i = 1; i < m_chemin.size(); i++) {
-		const ProblemStation* station = m_chemin[i];
-		nauticmiles_t flightDistance = geometry::distance(m_chemin[i - 1]->getLocation(), station->getLocation());
+		const problemidx_t station = m_chemin[i];
+		nauticmiles_t flightDistance = nauticMilesBetween(distances, m_chemin[i - 1], station);
 		currentDistance += flightDistance;
 		distanceSinceLastRefuel += flightDistance;
 		daytime_t currentTime = m_dataset.departureTime + currentDistance / m_dataset.planeSpeed;
-		//std::cout << std::endl << "ProblemStation number " << i << "  : " << distanceSinceLastRefuel;
-		if (station->canBeUsedToFuel())
+		if (map.canBeUsedToFuel(station))
 		{
 			distanceSinceLastRefuel = 0;
 		}else
@@ -759,10 +676,9 @@ size_t  OptimisationSolver::findProblematicProblemStation(std::vector<const Prob
 				travel->currentTime = currentTime;
 				return i;
 			}
-			//std::cout << std::endl << "    Fuel left  " << remainingFuel << std::endl;
 		}
-		
-		
+
+
 	}
 
 	return  m_chemin.size();
@@ -770,11 +686,11 @@ size_t  OptimisationSolver::findProblematicProblemStation(std::vector<const Prob
 
 
 //Check if a station is in the vector
-bool tools::ProblemStationInPath(std::vector<const ProblemStation*> path, ProblemStation& station)
+bool tools::ProblemStationInPath(const std::vector<const ProblemStation*>& path, const ProblemStation& station)
 {
 	for (const ProblemStation* i : path)
 	{
-		if (i->getOriginalStation()->getName() == station.getOriginalStation()->getName())
+		if (i->getOriginalStation()->getId() == station.getOriginalStation()->getId())
 		{
 			return true;
 		}
@@ -783,7 +699,7 @@ bool tools::ProblemStationInPath(std::vector<const ProblemStation*> path, Proble
 }
 
 //Check if a station is in the vector
-bool tools::ProblemStationInProblemStationVector(std::vector<ProblemStation*>stationVector, ProblemStation& station)
+bool tools::ProblemStationInProblemStationVector(const std::vector<ProblemStation*>& stationVector, const ProblemStation& station)
 {
 	if (stationVector.empty())
 	{
@@ -791,7 +707,7 @@ bool tools::ProblemStationInProblemStationVector(std::vector<ProblemStation*>sta
 	}
 	for (const ProblemStation* i : stationVector)
 	{
-		if (i->getOriginalStation()->getName() == station.getOriginalStation()->getName())
+		if (i->getOriginalStation()->getId() == station.getOriginalStation()->getId())
 		{
 			return true;
 		}
@@ -800,7 +716,7 @@ bool tools::ProblemStationInProblemStationVector(std::vector<ProblemStation*>sta
 }
 
 //Check if the end station is in the vector
-bool tools::EndProblemStationInReachableProblemStations(std::vector<ProblemStation*> stations, ProblemStation& endProblemStation)
+bool tools::EndProblemStationInReachableProblemStations(const std::vector<ProblemStation*>& stations, const ProblemStation& endProblemStation)
 {
 	
 	return ProblemStationInProblemStationVector(stations,endProblemStation);
@@ -881,20 +797,23 @@ Location tools::findHalfWayCoordinates(Location start, Location end)
 	return Location((start.longitude + end.longitude)/2,(start.latitude + end.latitude)/2);
 }
 
+
+
 //Test a path to seen the remaining fuel at each station on the console
-void OptimisationSolver::TestPath(std::vector<const ProblemStation*>& chemin)
+template<class Distances>
+void OptimisationSolver::TestPath(const ProblemMap& map, const Distances& distances, const ProblemPath& chemin)
 {
 	std::cout << std::endl;
 	nauticmiles_t currentDistance = 0;
 	nauticmiles_t distanceSinceLastRefuel = 0;
 	for (size_t i = 1; i < chemin.size(); i++) {
-		const ProblemStation* station = chemin[i];
-		nauticmiles_t flightDistance = geometry::distance(chemin[i - 1]->getLocation(), station->getLocation());
+		const problemidx_t station = chemin[i];
+		nauticmiles_t flightDistance = nauticMilesBetween(distances, chemin[i - 1], station);
 		currentDistance += flightDistance;
 		distanceSinceLastRefuel += flightDistance;
 		daytime_t currentTime = m_dataset.departureTime + currentDistance / m_dataset.planeSpeed;
-		std::cout << "ProblemStation number (" << station->getOriginalStation()->getName() << ") " << i << "  : " << distanceSinceLastRefuel;
-		if (station->canBeUsedToFuel()) {
+		std::cout << "ProblemStation number (" << map.getOriginalStation(station)->getName() << ") " << i << "  : " << distanceSinceLastRefuel;
+		if (map.canBeUsedToFuel(station)) {
 			distanceSinceLastRefuel = 0;
 		}
 		float remainingFuel = m_dataset.planeFuelCapacity - distanceSinceLastRefuel / m_dataset.planeSpeed * m_dataset.planeFuelUsage;
@@ -904,6 +823,4 @@ void OptimisationSolver::TestPath(std::vector<const ProblemStation*>& chemin)
 	std::cout << std::endl;
 	std::cout << std::endl;
 	std::cout << std::endl;
-}
-
- 
+}
\ No newline at end of file
@@ -4,7 +4,11 @@
 #include "../breitling/label_setting_breitling.h"
 #include "../breitling/BreitlingSolver.h"
 #include "../geometry.h"
+#include "../spatialindex.h"
+#include "../distancepolicy.h"
+#include "../breitling/structures.h"
 #include <map>
+#include <limits>
 #include "../breitling/breitlingnatural.h"
 
 typedef double timedistance_t;
@@ -12,9 +16,9 @@ typedef double timedistance_t;
 namespace tools
 {
 
-	bool ProblemStationInPath(std::vector<const ProblemStation*> path, ProblemStation& station);
-	bool ProblemStationInProblemStationVector(std::vector<ProblemStation*>stationVector, ProblemStation& station);
-	bool EndProblemStationInReachableProblemStations(std::vector<ProblemStation*> stations,  ProblemStation& endProblemStation);
+	bool ProblemStationInPath(const std::vector<const ProblemStation*>& path, const ProblemStation& station);
+	bool ProblemStationInProblemStationVector(const std::vector<ProblemStation*>& stationVector, const ProblemStation& station);
+	bool EndProblemStationInReachableProblemStations(const std::vector<ProblemStation*>& stations, const ProblemStation& endProblemStation);
 	std::vector<timedistance_t*> SortTimeDistance(std::vector<timedistance_t*> distanceList);
 	Location findHalfWayCoordinates(Location start, Location end);
 	static inline bool isTimeInNightPeriod(daytime_t time, const BreitlingData& dataset) {
@@ -43,29 +47,57 @@ struct travel_variables
 
 class OptimisationSolver : public PathSolver 
 {
+	//Value returned by the selection of a station when there is no station to select
+	static constexpr problemidx_t NO_STATION = std::numeric_limits<problemidx_t>::max();
+
 	BreitlingData m_dataset;
 	travel_variables* m_travel = new travel_variables();
-	std::vector<const ProblemStation*> m_chemin;
+	ProblemPath m_chemin;
+	//Spatial index over the map stations and buffer for its queries, used to find reachable stations
+	SpatialIndex m_spatialIndex;
+	std::vector<SpatialIndex::Neighbour> m_neighboursBuffer;
+	//Stations that can be used to refuel the plane / that are accessible at night, by index in the map
+	DynamicBitSet m_refuelStations;
+	DynamicBitSet m_nightStations;
+	//Stations of m_chemin by index in the map, kept up to date by insertInPath
+	DynamicBitSet m_pathStations;
+	//How the distances between stations are measured, see DistancePolicy
+	DistancePolicy m_distancePolicy;
 public:
 
-	OptimisationSolver(const BreitlingData& dataset)
-		: m_dataset(dataset)
+	OptimisationSolver(const BreitlingData& dataset, DistancePolicy distancePolicy = DistancePolicy::SPHERICAL)
+		: m_dataset(dataset), m_distancePolicy(distancePolicy)
 	{
 	}
-	void TestPath(std::vector<const ProblemStation*>& chemin);
-	std::vector<ProblemMap*> seperateRegion(const ProblemMap& map);
-	void initializePath(const std::vector<ProblemMap*> regions,ProblemStation* startingProblemStation, ProblemStation* endProblemStation);
 	ProblemPath solveForPath(const ProblemMap& map, SolverRuntime* runtime) override;
-	std::vector<ProblemStation> RefuelableStation(const ProblemMap& map, const ProblemStation& centerProblemStation, travel_variables travel, bool refuelable);
-	ProblemStation* stationSelectionInReach(const ProblemMap& map, const ProblemStation& startProblemStation,const ProblemStation& destinationProblemStation, std::vector<ProblemStation*> skipList, travel_variables* travel, bool refuelable);
-	size_t findProblematicProblemStation(std::vector<const ProblemStation*> path, travel_variables* travel);
-	std::vector<ProblemStation*> connectProblemStationsTogether(const ProblemMap& map,const ProblemStation& startProblemStation, const ProblemStation& endProblemStation, travel_variables* travel, bool refuelable);
-	void updateTravelVariable(travel_variables* travel, const ProblemStation* point);
+
+private:
+	//Distances is one of the distance sources of distancepolicy.h, chosen by solveForPath
+	template<class Distances>
+	ProblemPath solve(const ProblemMap& map, const Distances& distances, SolverRuntime* runtime);
+	template<class Distances>
+	void TestPath(const ProblemMap& map, const Distances& distances, const ProblemPath& chemin);
+	std::vector<std::vector<problemidx_t>> seperateRegion(const ProblemMap& map);
+	template<class Distances>
+	void initializePath(const ProblemMap& map, const Distances& distances, const std::vector<std::vector<problemidx_t>>& regions, problemidx_t startingProblemStation, problemidx_t endProblemStation);
+	void indexMap(const ProblemMap& map);
+	ProblemPath::iterator insertInPath(ProblemPath::const_iterator position, problemidx_t station);
+	template<class Distances>
+	void RefuelableStation(const ProblemMap& map, const Distances& distances, problemidx_t centerProblemStation, const travel_variables& travel, bool refuelable, std::vector<SpatialIndex::Neighbour>& reachableStations);
+	template<class Distances>
+	problemidx_t stationSelectionInReach(const ProblemMap& map, const Distances& distances, problemidx_t startProblemStation, problemidx_t destinationProblemStation, const DynamicBitSet& skipList, travel_variables* travel, bool refuelable);
+	template<class Distances>
+	size_t findProblematicProblemStation(const ProblemMap& map, const Distances& distances, travel_variables* travel);
+	template<class Distances>
+	ProblemPath connectProblemStationsTogether(const ProblemMap& map, const Distances& distances, problemidx_t startProblemStation, problemidx_t endProblemStation, travel_variables* travel, bool refuelable);
+	template<class Distances>
+	void updateTravelVariable(const ProblemMap& map, const Distances& distances, travel_variables* travel, problemidx_t point);
 	void resetTestVariable();
-	void findIntermidiateRefillableStation(const ProblemMap& map, std::vector<const ProblemStation*> path, travel_variables* travel);
-	static inline Path transformToPath(ProblemPath path);
-	void addRefuelStationIfFirstStationUnreachable(const ProblemMap& map, std::vector<const ProblemStation*> path);
-	bool hasThePathBeenChanged(std::vector<const ProblemStation*> *path);
-	void copyPathToObject(std::vector<const ProblemStation*> *copy);
-	static ProblemPath adaptProblemPath(const std::vector<const ProblemStation*>& path);
+	template<class Distances>
+	void findIntermidiateRefillableStation(const ProblemMap& map, const Distances& distances, travel_variables* travel);
+	static inline Path transformToPath(const ProblemMap& map, const ProblemPath& path);
+	template<class Distances>
+	void addRefuelStationIfFirstStationUnreachable(const ProblemMap& map, const Distances& distances, ProblemPath path);
+	bool hasThePathBeenChanged(ProblemPath* path);
+	void copyPathToObject(ProblemPath* copy);
 };
\ No newline at end of file
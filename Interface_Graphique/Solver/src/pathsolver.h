@@ -1,25 +1,46 @@
 #pragma once
 
 #include "geomap.h"
+#include "distancematrix.h"
+#include "candidateset.h"
 #include "path.h"
+#include "artifactcache.h"
+#include "dynamicbitset.h"
+#include "breitling/mandatoryregions.h"
 
+#include <iterator>
+#include <stdint.h>
+
+/*
+ * A station of a ProblemMap, as a value. Used where stations are handled one at a
+ * time (paths, the UI, exports), hot loops should read the map's arrays instead.
+ */
 struct ProblemStation {
 private:
   const Station *m_station;
+  geometry::UnitVector m_unitVector; // cached, stations do not move during a solve
   bool m_isAccessibleAtNight;
   bool m_canBeUsedToFuel;
 public:
   ProblemStation(const Station *station, bool isAccessibleAtNight, bool canBeUsedToFuel)
-    : m_station(station), m_isAccessibleAtNight(isAccessibleAtNight), m_canBeUsedToFuel(canBeUsedToFuel)
+    : m_station(station), m_unitVector(geometry::toUnitVector(station->getLocation())),
+    m_isAccessibleAtNight(isAccessibleAtNight), m_canBeUsedToFuel(canBeUsedToFuel)
+  {
+  }
+
+  ProblemStation(const Station *station, const geometry::UnitVector &unitVector, bool isAccessibleAtNight, bool canBeUsedToFuel)
+    : m_station(station), m_unitVector(unitVector),
+    m_isAccessibleAtNight(isAccessibleAtNight), m_canBeUsedToFuel(canBeUsedToFuel)
   {
   }
 
   ProblemStation() 
-    : m_station(nullptr), m_isAccessibleAtNight(false), m_canBeUsedToFuel(false)
+    : m_station(nullptr), m_unitVector{}, m_isAccessibleAtNight(false), m_canBeUsedToFuel(false)
   {
   }
 
   const Location &getLocation() const { return m_station->getLocation(); }
+  const geometry::UnitVector &getUnitVector() const { return m_unitVector; }
   bool isAccessibleAtNight() const { return m_isAccessibleAtNight; }
   bool canBeUsedToFuel() const { return m_canBeUsedToFuel; }
   const Station *getOriginalStation() const { return m_station; }
@@ -28,26 +49,184 @@ public:
   bool operator<(const ProblemStation &other) const { return m_station < other.m_station; } // necessary for std::set<ProblemStation>
 };
 
-typedef std::vector<ProblemStation> ProblemMap;
-typedef std::vector<ProblemStation> ProblemPath;
+/*
+ * The stations a solver works on, as a structure of arrays: the locations, unit
+ * vectors, flags and regions of all the stations are each stored contiguously, a
+ * loop over one of them does not follow a pointer to each Station.
+ *
+ * Stations are identified by their index. map[i] and iterators return
+ * ProblemStation values, built from the arrays.
+ */
+class ProblemMap {
+private:
+  std::vector<const Station *> m_stations;
+  std::vector<Location> m_locations;
+  std::vector<geometry::UnitVector> m_unitVectors; // cached, stations do not move during a solve
+  DynamicBitSet m_accessibleAtNight;
+  DynamicBitSet m_canBeUsedToFuel;
+  std::vector<uint8_t> m_mandatoryRegions;         // see breitling_constraints::getMandatoryRegions
+
+public:
+  class Iterator {
+  private:
+    const ProblemMap *m_map;
+    size_t m_index;
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = ProblemStation;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = ProblemStation;
+
+    Iterator() : m_map(nullptr), m_index(0) {}
+    Iterator(const ProblemMap *map, size_t index) : m_map(map), m_index(index) {}
+
+    ProblemStation operator*() const { return (*m_map)[m_index]; }
+    ProblemStation operator[](difference_type offset) const { return (*m_map)[m_index + offset]; }
+    Iterator &operator++() { m_index++; return *this; }
+    Iterator &operator--() { m_index--; return *this; }
+    Iterator operator++(int) { Iterator previous = *this; m_index++; return previous; }
+    Iterator operator--(int) { Iterator previous = *this; m_index--; return previous; }
+    Iterator &operator+=(difference_type offset) { m_index += offset; return *this; }
+    Iterator &operator-=(difference_type offset) { m_index -= offset; return *this; }
+    Iterator operator+(difference_type offset) const { return { m_map, m_index + offset }; }
+    Iterator operator-(difference_type offset) const { return { m_map, m_index - offset }; }
+    difference_type operator-(const Iterator &other) const { return (difference_type)m_index - (difference_type)other.m_index; }
+    bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+    auto operator<=>(const Iterator &other) const { return m_index <=> other.m_index; }
+  };
+
+  void reserve(size_t stationCount)
+  {
+    m_stations.reserve(stationCount);
+    m_locations.reserve(stationCount);
+    m_unitVectors.reserve(stationCount);
+    m_accessibleAtNight.reserve(stationCount);
+    m_canBeUsedToFuel.reserve(stationCount);
+    m_mandatoryRegions.reserve(stationCount);
+  }
+
+  void emplace_back(const Station *station, bool isAccessibleAtNight, bool canBeUsedToFuel)
+  {
+    m_stations.push_back(station);
+    m_locations.push_back(station->getLocation());
+    m_unitVectors.push_back(geometry::toUnitVector(station->getLocation()));
+    m_accessibleAtNight.pushBack(isAccessibleAtNight);
+    m_canBeUsedToFuel.pushBack(canBeUsedToFuel);
+    m_mandatoryRegions.push_back(breitling_constraints::getMandatoryRegions(station->getLocation()));
+  }
+
+  size_t size() const { return m_stations.size(); }
+  bool empty() const { return m_stations.empty(); }
+
+  ProblemStation operator[](size_t i) const { return { m_stations[i], m_unitVectors[i], isAccessibleAtNight(i), canBeUsedToFuel(i) }; }
+  ProblemStation front() const { return (*this)[0]; }
+  ProblemStation back() const { return (*this)[size() - 1]; }
+  Iterator begin() const { return { this, 0 }; }
+  Iterator end() const { return { this, size() }; }
+
+  const Station *getOriginalStation(size_t i) const { return m_stations[i]; }
+  const Location &getLocation(size_t i) const { return m_locations[i]; }
+  const geometry::UnitVector &getUnitVector(size_t i) const { return m_unitVectors[i]; }
+  bool isAccessibleAtNight(size_t i) const { return m_accessibleAtNight.isSet(i); }
+  bool canBeUsedToFuel(size_t i) const { return m_canBeUsedToFuel.isSet(i); }
+  uint8_t getMandatoryRegions(size_t i) const { return m_mandatoryRegions[i]; }
+  bool isInMandatoryRegion(size_t i, size_t region) const { return (m_mandatoryRegions[i] >> region) & 1; }
+
+  const std::vector<Location> &getLocations() const { return m_locations; }
+  const std::vector<geometry::UnitVector> &getUnitVectors() const { return m_unitVectors; }
+};
+
+typedef uint32_t problemidx_t; // index of a station in a ProblemMap
+
+/*
+ * The indices in the map of the stations of a path. Solvers produce and work on
+ * indices, the stations are only looked up when the result is shown or exported
+ * (see toPath).
+ */
+typedef std::vector<problemidx_t> ProblemPath;
+
+inline nauticmiles_t getDistance(const ProblemStation &s1, const ProblemStation &s2) {
+    return geometry::distance(s1.getUnitVector(), s2.getUnitVector());
+}
+
+inline nauticmiles_t getDistance(const ProblemMap &map, problemidx_t s1, problemidx_t s2) {
+    return geometry::distance(map.getUnitVector(s1), map.getUnitVector(s2));
+}
+
+// The stations of a path, for the serializers and the UI
+inline Path toPath(const ProblemMap &map, const ProblemPath &path) {
+    Path stations;
+    stations.getStations().reserve(path.size());
+    for (problemidx_t station : path)
+        stations.getStations().push_back(map.getOriginalStation(station));
+    return stations;
+}
 
-inline std::vector<std::vector<nauticmiles_t>> getDistancesMatrix(const ProblemMap &map) {
-    std::vector<std::vector<nauticmiles_t>> distances(map.size(), std::vector<nauticmiles_t>(map.size(), 0));
+// The stations' unit vectors as a contiguous array, usable with geometry::distances
+inline const std::vector<geometry::UnitVector> &getUnitVectors(const ProblemMap &map) {
+    return map.getUnitVectors();
+}
 
-    for (size_t i = 0; i < map.size(); ++i) {
-        for (size_t j = 0; j < map.size(); ++j) {
-            distances[i][j] = geometry::distance(map[i].getLocation(), map[j].getLocation());
-        }
+// The key of the artifacts computed from map, see ArtifactCache. Changes when a station is added, moved or changes flags
+inline uint64_t getMapHash(const ProblemMap &map) {
+    ContentHash hash;
+    hash.add(map.size());
+    for (size_t i = 0; i < map.size(); i++) {
+        hash.add(map.getUnitVector(i));
+        hash.add((uint8_t)(map.isAccessibleAtNight(i) | map.canBeUsedToFuel(i) << 1));
     }
+    return hash.value();
+}
+
+inline StationDistanceMatrix getDistancesMatrix(const ProblemMap &map) {
+    return StationDistanceMatrix::compute(getUnitVectors(map));
+}
+
+// read from cache if it holds the matrix of map, computed and stored otherwise. cache may be null
+inline StationDistanceMatrix getDistancesMatrix(const ProblemMap &map, const ArtifactCache *cache) {
+    uint64_t key = ContentHash{}.add(getMapHash(map)).add(sizeof(matrixdistance_t)).value();
+    return ArtifactCache::getOrCompute<StationDistanceMatrix>(cache, "distances", key, [&map] { return getDistancesMatrix(map); });
+}
+
+// 4 times smaller than getDistancesMatrix, for maps too large for a full precision matrix
+inline QuantizedStationDistanceMatrix getQuantizedDistancesMatrix(const ProblemMap &map) {
+    return QuantizedStationDistanceMatrix::compute(getUnitVectors(map));
+}
+
+inline QuantizedStationDistanceMatrix getQuantizedDistancesMatrix(const ProblemMap &map, const ArtifactCache *cache) {
+    return ArtifactCache::getOrCompute<QuantizedStationDistanceMatrix>(cache, "quantized-distances", getMapHash(map), [&map] { return getQuantizedDistancesMatrix(map); });
+}
 
-    return distances;
+// exact distances computed on the fly, see SphericalDistances and HaversineDistances
+inline SphericalDistances getSphericalDistances(const ProblemMap &map) {
+    return SphericalDistances::compute(getUnitVectors(map));
+}
+
+inline HaversineDistances getHaversineDistances(const ProblemMap &map) {
+    return HaversineDistances::compute(map.getLocations());
+}
+
+// distances computed on the fly from a local projection of the map, regional maps only (see PlanarDistances)
+inline PlanarDistances getPlanarDistances(const ProblemMap &map) {
+    return PlanarDistances::compute(getUnitVectors(map));
+}
+
+// the stations a local search should try to link each station to, see CandidateSet
+inline CandidateSet getCandidateSet(const ProblemMap &map) {
+    return CandidateSet{ getUnitVectors(map) };
+}
+
+inline CandidateSet getCandidateSet(const ProblemMap &map, const ArtifactCache *cache) {
+    uint64_t key = ContentHash{}.add(getMapHash(map)).add(CandidateSet::DEFAULT_NEAREST_COUNT).add(CandidateSet::DEFAULT_QUADRANT_COUNT).value();
+    return ArtifactCache::getOrCompute<CandidateSet>(cache, "candidates", key, [&map] { return getCandidateSet(map); });
 }
 
 // should be namespaced
-inline nauticmiles_t getLength(const ProblemPath &path) {
+inline nauticmiles_t getLength(const ProblemMap &map, const ProblemPath &path) {
     nauticmiles_t length = 0;
     for (size_t i = 1; i < path.size(); i++)
-        length += geometry::distance(path[i].getLocation(), path[i - 1].getLocation());
+        length += getDistance(map, path[i], path[i - 1]);
     return length;
 }
 
@@ -73,5 +252,15 @@ public:
      */
     virtual ProblemPath solveForPath(const ProblemMap &map, SolverRuntime *runtime) = 0;
 
+    /*
+     * Lets the solver keep its preprocessing (distance matrices, candidate sets...)
+     * between runs, see ArtifactCache. The cache may be null, which is the default,
+     * otherwise it must outlive the calls to solveForPath.
+     */
+    void setArtifactCache(const ArtifactCache *cache) { m_artifactCache = cache; }
+
+protected:
+    const ArtifactCache *m_artifactCache = nullptr;
+
 };
 
@@ -0,0 +1,107 @@
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+SpatialIndex::SpatialIndex(const std::vector<geometry::UnitVector> &points)
+{
+  if (points.size() > std::numeric_limits<uint32_t>::max())
+    throw std::invalid_argument("Too many points for a spatial index");
+
+  m_nodes.reserve(points.size());
+  for (size_t i = 0; i < points.size(); i++)
+    m_nodes.push_back({ points[i], (uint32_t)i, 0 });
+
+  build(0, m_nodes.size());
+}
+
+void SpatialIndex::build(size_t begin, size_t end)
+{
+  if (end - begin <= LEAF_SIZE)
+    return;
+
+  // split along the axis on which the points are the most spread out
+  geometry::UnitVector min = m_nodes[begin].point, max = m_nodes[begin].point;
+  for (size_t n = begin + 1; n < end; n++) {
+    const geometry::UnitVector &p = m_nodes[n].point;
+    min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+    max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+  }
+  double extents[] = { max.x - min.x, max.y - min.y, max.z - min.z };
+  uint8_t axis = (uint8_t)(std::max_element(extents, extents + 3) - extents);
+
+  size_t mid = (begin + end) / 2;
+  std::nth_element(m_nodes.begin() + begin, m_nodes.begin() + mid, m_nodes.begin() + end,
+    [axis](const Node &n1, const Node &n2) { return axisValue(n1.point, axis) < axisValue(n2.point, axis); });
+  m_nodes[mid].splitAxis = axis;
+
+  build(begin, mid);
+  build(mid + 1, end);
+}
+
+double SpatialIndex::distanceToChordSquared(nauticmiles_t distance)
+{
+  double angle = distance / geography::EARTH_RADIUS_NM;
+  if (angle >= geometry::PI)
+    return std::numeric_limits<double>::infinity();
+  double chord = 2 * sin(angle / 2);
+  return chord * chord;
+}
+
+std::vector<SpatialIndex::Neighbour> SpatialIndex::nearest(const geometry::UnitVector &point, size_t k) const
+{
+  // (squared chord, node) pairs, sorted by distance
+  std::vector<std::pair<double, uint32_t>> best;
+  best.reserve(k + 1);
+  if (k > 0)
+    searchNearest(0, m_nodes.size(), point, k, best);
+
+  std::vector<Neighbour> neighbours;
+  neighbours.reserve(best.size());
+  for (const auto &[chord, n] : best)
+    neighbours.push_back({ m_nodes[n].index, geometry::distance(point, m_nodes[n].point) });
+  return neighbours;
+}
+
+void SpatialIndex::searchNearest(size_t begin, size_t end, const geometry::UnitVector &point, size_t k, std::vector<std::pair<double, uint32_t>> &best) const
+{
+  auto tryNode = [&](size_t n) {
+    double d = chordSquared(point, m_nodes[n].point);
+    auto isBefore = [this](const std::pair<double, uint32_t> &a, const std::pair<double, uint32_t> &b) {
+      return a.first < b.first || (a.first == b.first && m_nodes[a.second].index < m_nodes[b.second].index);
+    };
+    std::pair<double, uint32_t> candidate{ d, (uint32_t)n };
+    if (best.size() == k && !isBefore(candidate, best.back()))
+      return;
+    best.insert(std::upper_bound(best.begin(), best.end(), candidate, isBefore), candidate);
+    if (best.size() > k)
+      best.pop_back();
+  };
+  auto worst = [&]() {
+    return best.size() < k ? std::numeric_limits<double>::infinity() : best.back().first;
+  };
+
+  if (end - begin <= LEAF_SIZE) {
+    for (size_t n = begin; n < end; n++)
+      tryNode(n);
+    return;
+  }
+
+  size_t mid = (begin + end) / 2;
+  double diff = axisValue(point, m_nodes[mid].splitAxis) - axisValue(m_nodes[mid].point, m_nodes[mid].splitAxis);
+  tryNode(mid);
+  if (diff < 0) {
+    searchNearest(begin, mid, point, k, best);
+    if (diff * diff <= worst())
+      searchNearest(mid + 1, end, point, k, best);
+  } else {
+    searchNearest(mid + 1, end, point, k, best);
+    if (diff * diff <= worst())
+      searchNearest(begin, mid, point, k, best);
+  }
+}
+
+void SpatialIndex::withinRadius(const geometry::UnitVector &point, nauticmiles_t radius, std::vector<Neighbour> &out) const
+{
+  withinRadius(point, radius, [](size_t, nauticmiles_t) { return true; }, out);
+}
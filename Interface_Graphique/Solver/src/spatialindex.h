@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <utility>
+#include <stdint.h>
+
+#include "geometry.h"
+
+/*
+ * Spatial index over a fixed set of points, usually the stations of a ProblemMap
+ * (see getUnitVectors), built once in O(NlogN) and queried many times.
+ *
+ * It is a k-d tree on the points' unit vectors. The great circle distance between
+ * two points grows with the euclidean (chord) distance between their unit vectors
+ * so the tree is searched with squared chord lengths, no trigonometry is involved
+ * but for the distances that are reported.
+ *
+ * Points are referred to by their index in the vector the index was built from.
+ * On equal distances the point with the lowest index is preferred, as a linear
+ * scan over the points would.
+ */
+class SpatialIndex {
+public:
+  static constexpr size_t NO_POINT = std::numeric_limits<size_t>::max();
+
+  struct Neighbour {
+    size_t index;
+    nauticmiles_t distance;
+  };
+
+private:
+  static constexpr size_t LEAF_SIZE = 8;
+
+  // the tree is implicit, the node splitting the range [begin,end) is the one at (begin+end)/2,
+  // ranges of at most LEAF_SIZE nodes are not split and are scanned linearly
+  struct Node {
+    geometry::UnitVector point;
+    uint32_t index;    // index of the point in the original vector
+    uint8_t splitAxis; // 0,1,2 for x,y,z
+  };
+
+  std::vector<Node> m_nodes;
+
+public:
+  SpatialIndex() {}
+  explicit SpatialIndex(const std::vector<geometry::UnitVector> &points);
+
+  size_t size() const { return m_nodes.size(); }
+
+  /*
+   * Finds the k points nearest to point, sorted by increasing distance.
+   * Fewer than k points are returned if the index does not contain enough.
+   */
+  std::vector<Neighbour> nearest(const geometry::UnitVector &point, size_t k) const;
+
+  /*
+   * Finds all points that are strictly closer than radius to point, in no
+   * particular order. out is cleared first.
+   */
+  void withinRadius(const geometry::UnitVector &point, nauticmiles_t radius, std::vector<Neighbour> &out) const;
+
+  /*
+   * Same as withinRadius but only keeps the points for which predicate(index, distance)
+   * returns true. Points are appended to out in the order they are visited, use
+   * this with a precomputed mask (see DynamicBitSet) rather than filtering the
+   * points afterwards.
+   */
+  template<class Predicate>
+  void withinRadius(const geometry::UnitVector &point, nauticmiles_t radius, Predicate &&predicate, std::vector<Neighbour> &out) const
+  {
+    out.clear();
+    searchRadius(0, m_nodes.size(), point, distanceToChordSquared(radius), predicate, out);
+  }
+
+  /*
+   * Finds the point nearest to point for which predicate(index, distance) returns
+   * true, ignoring points that are not strictly closer than maxDistance.
+   * Returns NO_POINT if there is no such point, otherwise the distance to the
+   * found point is written to *distance if it is not null.
+   *
+   * The predicate is only evaluated on points that are closer than the best
+   * match so far, expensive predicates are fine.
+   */
+  template<class Predicate>
+  size_t nearestSatisfying(const geometry::UnitVector &point, Predicate &&predicate,
+    nauticmiles_t maxDistance = std::numeric_limits<nauticmiles_t>::max(), nauticmiles_t *distance = nullptr) const
+  {
+    size_t bestNode = NO_POINT;
+    double bestChordSquared = distanceToChordSquared(maxDistance);
+    searchSatisfying(0, m_nodes.size(), point, predicate, bestNode, bestChordSquared);
+    if (bestNode == NO_POINT)
+      return NO_POINT;
+    if (distance != nullptr)
+      *distance = geometry::distance(point, m_nodes[bestNode].point);
+    return m_nodes[bestNode].index;
+  }
+
+private:
+  void build(size_t begin, size_t end);
+
+  static double chordSquared(const geometry::UnitVector &v1, const geometry::UnitVector &v2)
+  {
+    double dx = v1.x - v2.x, dy = v1.y - v2.y, dz = v1.z - v2.z;
+    return dx * dx + dy * dy + dz * dz;
+  }
+
+  static double axisValue(const geometry::UnitVector &v, uint8_t axis)
+  {
+    return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+  }
+
+  // squared chord length of an arc of the given length, infinite if the arc is longer than half the earth's circumference
+  static double distanceToChordSquared(nauticmiles_t distance);
+
+  template<class Predicate>
+  void searchSatisfying(size_t begin, size_t end, const geometry::UnitVector &point, Predicate &predicate,
+    size_t &bestNode, double &bestChordSquared) const
+  {
+    auto tryNode = [&](size_t n) {
+      double d = chordSquared(point, m_nodes[n].point);
+      bool closer = d < bestChordSquared || (d == bestChordSquared && bestNode != NO_POINT && m_nodes[n].index < m_nodes[bestNode].index);
+      if (!closer)
+        return;
+      if (!predicate((size_t)m_nodes[n].index, geometry::distance(point, m_nodes[n].point)))
+        return;
+      bestChordSquared = d;
+      bestNode = n;
+    };
+
+    if (end - begin <= LEAF_SIZE) {
+      for (size_t n = begin; n < end; n++)
+        tryNode(n);
+      return;
+    }
+
+    size_t mid = (begin + end) / 2;
+    double diff = axisValue(point, m_nodes[mid].splitAxis) - axisValue(m_nodes[mid].point, m_nodes[mid].splitAxis);
+    tryNode(mid);
+    if (diff < 0) {
+      searchSatisfying(begin, mid, point, predicate, bestNode, bestChordSquared);
+      if (diff * diff <= bestChordSquared)
+        searchSatisfying(mid + 1, end, point, predicate, bestNode, bestChordSquared);
+    } else {
+      searchSatisfying(mid + 1, end, point, predicate, bestNode, bestChordSquared);
+      if (diff * diff <= bestChordSquared)
+        searchSatisfying(begin, mid, point, predicate, bestNode, bestChordSquared);
+    }
+  }
+
+  void searchNearest(size_t begin, size_t end, const geometry::UnitVector &point, size_t k, std::vector<std::pair<double, uint32_t>> &best) const;
+
+  template<class Predicate>
+  void searchRadius(size_t begin, size_t end, const geometry::UnitVector &point, double chordSquaredRadius,
+    Predicate &predicate, std::vector<Neighbour> &out) const
+  {
+    auto tryNode = [&](size_t n) {
+      if (chordSquared(point, m_nodes[n].point) >= chordSquaredRadius)
+        return;
+      nauticmiles_t distance = geometry::distance(point, m_nodes[n].point);
+      if (predicate((size_t)m_nodes[n].index, distance))
+        out.push_back({ m_nodes[n].index, distance });
+    };
+
+    if (end - begin <= LEAF_SIZE) {
+      for (size_t n = begin; n < end; n++)
+        tryNode(n);
+      return;
+    }
+
+    size_t mid = (begin + end) / 2;
+    double diff = axisValue(point, m_nodes[mid].splitAxis) - axisValue(m_nodes[mid].point, m_nodes[mid].splitAxis);
+    tryNode(mid);
+    if (diff < 0 || diff * diff < chordSquaredRadius)
+      searchRadius(begin, mid, point, chordSquaredRadius, predicate, out);
+    if (diff >= 0 || diff * diff < chordSquaredRadius)
+      searchRadius(mid + 1, end, point, chordSquaredRadius, predicate, out);
+  }
+};
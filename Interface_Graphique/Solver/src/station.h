@@ -1,12 +1,20 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <utility>
+#include <stdint.h>
 
 #include "geography.h"
-#include <string>
+
+typedef uint32_t stationid_t;
 
 class Station {
+public:
+    static constexpr stationid_t NO_ID = -1;
+
 private:
+    stationid_t m_id = NO_ID; // given when the station is loaded, see GeoMap::assignStationIds
     bool m_excluded;
     Location m_location;
     std::string m_name;
@@ -16,17 +24,18 @@ private:
     std::string m_fuel;
 
 public:
-    Station(const bool &excluded, const Location &location, const std::string &name, const std::string &OACI, const std::string &status, const std::string &nightVFR, const std::string &fuel)
-      : m_location(location)
+    Station(const bool &excluded, const Location &location, std::string name, std::string OACI, std::string status, std::string nightVFR, std::string fuel)
+      : m_excluded(excluded),
+        m_location(location),
+        m_name(std::move(name)),
+        m_OACI(std::move(OACI)),
+        m_status(std::move(status)),
+        m_nightVFR(std::move(nightVFR)),
+        m_fuel(std::move(fuel))
     {
-        m_excluded = excluded;
-        m_name = name;
-        m_OACI = OACI;
-        m_status = status;
-        m_nightVFR = nightVFR;
-        m_fuel = fuel;
     }
 
+    stationid_t getId() const { return m_id; }
     const bool &isExcluded() const { return m_excluded; }
     const Location &getLocation() const { return m_location; }
     const std::string &getName() const { return m_name; }
@@ -35,6 +44,7 @@ public:
     const std::string &getNightVFR() const { return m_nightVFR; }
     const std::string &getFuel() const { return m_fuel; }
 
+    void setId(stationid_t id) { m_id = id; }
     void setExcluded(const bool &excluded) { m_excluded = excluded; }
     void setLocation(const Location &location) { m_location = location; }
     void setName(const std::string &name) { m_name = name; }
@@ -43,6 +53,12 @@ public:
     void setNightVFR(const std::string &nightVFR) { m_nightVFR = nightVFR; }
     void setFuel(const std::string &fuel) { m_fuel = fuel; }
 
+    // Ids that no other station of the process has, count consecutive ones starting from the returned id
+    static stationid_t reserveIds(size_t count) {
+        static std::atomic<stationid_t> nextId = 0;
+        return nextId.fetch_add((stationid_t)count);
+    }
+
     bool operator==(const Station &other) const { return m_location == other.m_location; }
     bool operator!=(const Station &other) const { return m_location != other.m_location; }
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include "station.h"
+
+typedef uint32_t attributeid_t;
+
+/*
+ * Distinct values of a categorical station attribute (status, night VFR, fuel),
+ * each value is given a small id in the order it is first seen.
+ */
+class AttributeDictionary {
+private:
+    std::vector<std::string> m_values;
+    std::unordered_map<std::string, attributeid_t> m_ids;
+
+public:
+    attributeid_t intern(const std::string &value)
+    {
+        auto [entry, inserted] = m_ids.try_emplace(value, (attributeid_t)m_values.size());
+        if (inserted)
+            m_values.push_back(value);
+        return entry->second;
+    }
+
+    size_t size() const { return m_values.size(); }
+    const std::string &getValue(attributeid_t id) const { return m_values[id]; }
+};
+
+/*
+ * Set of attribute ids, one bit per id of an AttributeDictionary.
+ */
+class AttributeMask {
+private:
+    std::vector<uint64_t> m_words;
+
+public:
+    explicit AttributeMask(size_t idCount) : m_words((idCount + 63) / 64, 0) {}
+
+    void set(attributeid_t id) { m_words[id / 64] |= 1ull << (id % 64); }
+    bool test(attributeid_t id) const { return (m_words[id / 64] >> (id % 64)) & 1; }
+};
+
+/*
+ * The categorical attributes of a list of stations, interned when the stations
+ * are loaded or edited. Filters on these attributes are then AttributeMasks tested
+ * with the stations' ids instead of string comparisons or lookups per station.
+ *
+ * Values are never removed from the dictionaries, the number of stations using
+ * each value tells which ones are still in use after edits.
+ */
+class StationAttributes {
+public:
+    enum Attribute {
+        STATUS, NIGHT_VFR, FUEL,
+        ATTRIBUTE_COUNT
+    };
+
+private:
+    std::array<AttributeDictionary, ATTRIBUTE_COUNT> m_dictionaries;
+    std::array<std::vector<attributeid_t>, ATTRIBUTE_COUNT> m_ids;        // per station
+    std::array<std::vector<uint32_t>, ATTRIBUTE_COUNT> m_stationCounts;  // per id
+
+public:
+    static const std::string &getValue(const Station &station, Attribute attribute)
+    {
+        switch (attribute) {
+        case STATUS:    return station.getStatus();
+        case NIGHT_VFR: return station.getNightVFR();
+        default:        return station.getFuel();
+        }
+    }
+
+    void assign(const std::vector<Station> &stations)
+    {
+        for (size_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+            m_dictionaries[attribute] = {};
+            m_ids[attribute].clear();
+            m_ids[attribute].reserve(stations.size());
+            m_stationCounts[attribute].clear();
+        }
+        for (const Station &station : stations)
+            append(station);
+    }
+
+    void append(const Station &station)
+    {
+        for (size_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+            attributeid_t id = intern((Attribute)attribute, station);
+            m_ids[attribute].push_back(id);
+            m_stationCounts[attribute][id]++;
+        }
+    }
+
+    // must be called when an attribute of the station-th station changes
+    void update(size_t station, const Station &value)
+    {
+        for (size_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+            attributeid_t &id = m_ids[attribute][station];
+            m_stationCounts[attribute][id]--;
+            id = intern((Attribute)attribute, value);
+            m_stationCounts[attribute][id]++;
+        }
+    }
+
+    attributeid_t getId(size_t station, Attribute attribute) const { return m_ids[attribute][station]; }
+    const AttributeDictionary &getDictionary(Attribute attribute) const { return m_dictionaries[attribute]; }
+    bool isUsed(Attribute attribute, attributeid_t id) const { return m_stationCounts[attribute][id] > 0; }
+
+    // the mask of the ids whose value satisfies predicate(const std::string &)
+    template<class Predicate>
+    AttributeMask makeMask(Attribute attribute, Predicate &&predicate) const
+    {
+        const AttributeDictionary &dictionary = m_dictionaries[attribute];
+        AttributeMask mask{ dictionary.size() };
+        for (attributeid_t id = 0; id < dictionary.size(); id++) {
+            if (predicate(dictionary.getValue(id)))
+                mask.set(id);
+        }
+        return mask;
+    }
+
+private:
+    attributeid_t intern(Attribute attribute, const Station &station)
+    {
+        attributeid_t id = m_dictionaries[attribute].intern(getValue(station, attribute));
+        if (id == m_stationCounts[attribute].size())
+            m_stationCounts[attribute].push_back(0);
+        return id;
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "station.h"
+
+/*
+ * Finds the stations of a list by id or by OACI code in constant time, instead of
+ * comparing names or codes with every station.
+ *
+ * Several stations may share an OACI code (or have none), the code is then mapped
+ * to one of them.
+ */
+class StationIndex {
+private:
+    std::unordered_map<stationid_t, size_t> m_positions;
+    std::unordered_map<std::string, stationid_t> m_idsByOACI;
+
+public:
+    void assign(const std::vector<Station> &stations)
+    {
+        m_positions.clear();
+        m_idsByOACI.clear();
+        m_positions.reserve(stations.size());
+        m_idsByOACI.reserve(stations.size());
+        for (size_t i = 0; i < stations.size(); i++)
+            append(stations, i);
+    }
+
+    // the position-th station must have been added to the list
+    void append(const std::vector<Station> &stations, size_t position)
+    {
+        const Station &station = stations[position];
+        m_positions[station.getId()] = position;
+        m_idsByOACI.try_emplace(station.getOACI(), station.getId());
+    }
+
+    // must be called when the OACI code of the position-th station changes
+    void updateOACI(const std::vector<Station> &stations, size_t position, const std::string &previousOACI)
+    {
+        const Station &station = stations[position];
+        auto entry = m_idsByOACI.find(previousOACI);
+        if (entry != m_idsByOACI.end() && entry->second == station.getId()) {
+            // another station may have the previous code
+            m_idsByOACI.erase(entry);
+            for (const Station &other : stations) {
+                if (other.getOACI() == previousOACI) {
+                    m_idsByOACI.emplace(previousOACI, other.getId());
+                    break;
+                }
+            }
+        }
+        m_idsByOACI.try_emplace(station.getOACI(), station.getId());
+    }
+
+    // the position of the station in the list, or -1 if no station has the id
+    size_t findPosition(stationid_t id) const
+    {
+        auto entry = m_positions.find(id);
+        return entry == m_positions.end() ? -1 : entry->second;
+    }
+
+    // Station::NO_ID if no station has the code
+    stationid_t findByOACI(const std::string &OACI) const
+    {
+        auto entry = m_idsByOACI.find(OACI);
+        return entry == m_idsByOACI.end() ? Station::NO_ID : entry->second;
+    }
+};
@@ -79,7 +79,7 @@ public:
 
 class TSPGenetics : public Genetics<ProblemPath> {
 private:
-    const std::vector<ProblemStation> *m_availableStations;
+    const ProblemMap *m_availableStations;
 public:
     TSPGenetics(const ProblemMap &map)
         : m_availableStations(&map)
@@ -89,20 +89,16 @@ public:
     void genRandomIndividuals(std::vector<ProblemPath> &individuals) override
     {
         std::generate(individuals.begin(), individuals.end(), [this]() {
-            std::vector<size_t> indices( m_availableStations->size() );
-            std::iota(indices.begin(), indices.end(), 0);
-            std::shuffle(indices.begin(), indices.end(), random);
-            ProblemPath path;
-            path.reserve(m_availableStations->size());
-            for (size_t i = 0; i < indices.size(); i++)
-                path.push_back(m_availableStations->at(indices[i]));
+            ProblemPath path( m_availableStations->size() );
+            std::iota(path.begin(), path.end(), 0);
+            std::shuffle(path.begin(), path.end(), random);
             return path;
         });
     }
 
     score_t scoreIndividual(const ProblemPath &ind) override
     {
-        return -getLength(ind)-geometry::distance(ind[0].getLocation(), ind[ind.size() - 1].getLocation());
+        return -getLength(*m_availableStations, ind)-getDistance(*m_availableStations, ind[0], ind[ind.size() - 1]);
     }
 
     ProblemPath mutateIndividual(const ProblemPath &parent) override
@@ -1,5 +1,7 @@
 #include "tsp_nearest_multistart_opt.h"
 
+#include <numeric>
+
 /*
  * Compute a path in the map passing through all the stations using the nearest neighbour algorithm and an optional optimization algorithm.
  * If a start/end station has been provided, it must be in the map.
@@ -17,24 +19,39 @@ ProblemPath TspNearestMultistartOptSolver::solveForPath(const ProblemMap &map, S
     ProblemPath bestPath;
     nauticmiles_t bestLength = std::numeric_limits<nauticmiles_t>::max();
 
-    // duplication of the map
-    std::vector<const ProblemStation *> leftStations;
-    for (const ProblemStation &station : map) {
-        leftStations.push_back(&station);
-    }
+    // the stations left to start a path from
+    std::vector<size_t> leftStations(map.size());
+    std::iota(leftStations.begin(), leftStations.end(), 0);
+
+    // Candidate neighbours of every station, shared by all threads, the local searches only try to link stations to their candidates
+    const CandidateSet candidates = m_optAlgo != 0 ? getCandidateSet(map, m_artifactCache) : CandidateSet{};
 
     // Run threads
-    for (unsigned int i = 0; i < m_nbThread; i++) {
-        std::thread thread{[&]() {
-            solveMultiStartThread(map, leftStations, bestPath, bestLength, mutex, runtime);
-        }};
-        threads.push_back(std::move(thread));
-    }
+    auto runThreads = [&](const auto &matrix) {
+        for (unsigned int i = 0; i < m_nbThread; i++) {
+            std::thread thread{[&]() {
+                solveMultiStartThread(map, matrix, candidates, leftStations, bestPath, bestLength, mutex, runtime);
+            }};
+            threads.push_back(std::move(thread));
+        }
 
-    // Wait for threads to finish
-    for (auto &thread : threads) {
-        thread.join();
-    }
+        // Wait for threads to finish
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    };
+
+    auto runWithDistances = [&](const auto &distances) {
+        if (m_startStation != NO_STATION && m_endStation != NO_STATION) { // Start and end stations are defined (case 4)
+            // The distance between start and end is seen as 0 so that the edge is kept in the cycle
+            runThreads(ZeroEdgeOverlay{ distances, m_startStation, m_endStation });
+        } else {
+            runThreads(distances);
+        }
+    };
+
+    // Compute the distances (a matrix by default), shared by all threads
+    withDistancePolicy(m_distancePolicy, map, runWithDistances, m_artifactCache);
 
     // Return best path
     return bestPath;
@@ -46,9 +63,10 @@ ProblemPath TspNearestMultistartOptSolver::solveForPath(const ProblemMap &map, S
  *
  * This method is used by the different threads.
  */
-void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map, std::vector<const ProblemStation *> &leftStations, ProblemPath &bestPath,
-                                                          nauticmiles_t &bestLength, std::mutex &mutex, SolverRuntime *runtime) const {
-    const ProblemStation *current_station;
+template<class Matrix>
+void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map, const Matrix &distances, const CandidateSet &candidates, std::vector<size_t> &leftStations,
+                                                          ProblemPath &bestPath, nauticmiles_t &bestLength, std::mutex &mutex, SolverRuntime *runtime) const {
+    size_t current_station;
 
     while (!runtime->userInterupted) {
         // Get the current station
@@ -64,20 +82,8 @@ void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map,
         runtime->foundSolutionCount = 1;
         mutex.unlock();
 
-        // Compute the distance matrix
-        std::vector<std::vector<nauticmiles_t>> distances;
-        distances = getDistancesMatrix(map);
-
-        if (m_startStation != nullptr && m_endStation != nullptr) { // Start and end stations are defined (case 4)
-            // Modify the distance matrix to set the distance between start and end to 0
-            const int startIdx = (std::find(map.begin(), map.end(), *m_startStation) - map.begin());
-            const int endIdx = (std::find(map.begin(), map.end(), *m_endStation) - map.begin());
-            distances[startIdx][endIdx] = 0;
-            distances[endIdx][startIdx] = 0;
-        }
-
         // Compute the path
-        ProblemPath path = nearestNeighborPath(map, current_station, &distances);
+        ProblemPath path = nearestNeighborPath(map, current_station, distances);
 
         // Close the path
         path.push_back(path.front());
@@ -86,17 +92,17 @@ void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map,
         if (m_optAlgo == 0) {
             // Skip optimization
         } else if (m_optAlgo == 2) {
-            path = tsp_optimization::o2opt(path, map, &distances, &runtime->userInterupted);
+            path = tsp_optimization::o2opt(path, map, distances, candidates, &runtime->userInterupted);
         } else if (m_optAlgo == 3) {
-            path = tsp_optimization::o3opt(path, map, &distances, &runtime->userInterupted);
+            path = tsp_optimization::o3opt(path, map, distances, candidates, &runtime->userInterupted);
         }
 
         // Start and end stations are not defined and the path is not a cycle (case 1)
-        if (m_startStation == nullptr && !m_loop) {
+        if (m_startStation == NO_STATION && !m_loop) {
             nauticmiles_t max = 0, current = 0;
             int idx = 0;
             for (int i = 0; i < path.size() - 2; i++) { // First to second last station
-                current = geometry::distance(path[i].getLocation(), path[i + 1].getLocation());
+                current = getDistance(map, path[i], path[i + 1]);
                 if (current > max) {
                     max = current;
                     idx = i;
@@ -107,22 +113,22 @@ void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map,
         }
 
         // Start station is defined but not the end station and the path is a cycle (case 5)
-        if (m_startStation != nullptr && m_loop) {
+        if (m_startStation != NO_STATION && m_loop) {
             path.pop_back();
-            auto it = std::find(path.begin(), path.end(), *m_startStation); // Find the start station
+            auto it = std::find(path.begin(), path.end(), m_startStation); // Find the start station
             std::rotate(path.begin(), it, path.end());
             path.push_back(path.front());
         }
 
         // Start station is defined but not the end station and the path is not a cycle (case 3)
-        if (m_startStation != nullptr && m_endStation == nullptr && !m_loop) {
+        if (m_startStation != NO_STATION && m_endStation == NO_STATION && !m_loop) {
             path.pop_back();
-            auto it = std::find(path.begin(), path.end(), *m_startStation); // Find the start station
+            auto it = std::find(path.begin(), path.end(), m_startStation); // Find the start station
             assert(it != path.end());
             std::rotate(path.begin(), it, path.end());
 
-            nauticmiles_t left_dist = geometry::distance(path.front().getLocation(), path.back().getLocation());
-            nauticmiles_t right_dist = geometry::distance(path.front().getLocation(), path[1].getLocation());
+            nauticmiles_t left_dist = getDistance(map, path.front(), path.back());
+            nauticmiles_t right_dist = getDistance(map, path.front(), path[1]);
             if (right_dist > left_dist) {
                 std::reverse(path.begin(), path.end());
                 std::rotate(path.begin(), path.end(), path.end());
@@ -130,28 +136,23 @@ void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map,
         }
 
         // Start and end stations are defined (case 4)
-        if (m_startStation != nullptr && m_endStation != nullptr && !m_loop) {
-
-            // Find the start station and the end station
-            const int startIdx = (std::find(path.begin(), path.end(), *m_startStation) - path.begin());
-            const int endIdx = (std::find(path.begin(), path.end(), *m_endStation) - path.begin());
-
+        if (m_startStation != NO_STATION && m_endStation != NO_STATION && !m_loop) {
             path.pop_back();
-            auto it = std::find(path.begin(), path.end(), *m_startStation); // Find the start station
+            auto it = std::find(path.begin(), path.end(), m_startStation); // Find the start station
             std::rotate(path.begin(), it, path.end());
 
-            if (path[1] == *m_endStation) {
+            if (path[1] == m_endStation) {
                 std::reverse(path.begin(), path.end());
                 std::rotate(path.begin(), path.end() - 1, path.end());
             }
         }
 
         // Update the best path
-        nauticmiles_t currentLength = getLength(path);
+        nauticmiles_t currentLength = getLength(map, path);
         mutex.lock();
         if (currentLength < bestLength) {
             bestLength = currentLength;
-            bestPath = path;
+            bestPath = std::move(path);
         }
         mutex.unlock();
     }
@@ -162,71 +163,65 @@ void TspNearestMultistartOptSolver::solveMultiStartThread(const ProblemMap &map,
  * A valid starting station must be provided.
  * To obtain a closed path, the same station should be provided as both the start and end station.
  *
- * THROWS : - invalid_argument exception if start/endStation is null
- *          - invalid_argument exception if start/endStation is not in the map
+ * THROWS : - invalid_argument exception if startStation is not an index of the map
  */
+template<class Matrix>
 [[nodiscard]]
-ProblemPath TspNearestMultistartOptSolver::nearestNeighborPath(const ProblemMap &map, const ProblemStation * const startStation,
-                                                               std::vector<std::vector<nauticmiles_t>> *distances) const {
-    std::vector<std::vector<nauticmiles_t>> distanceMatrix;
-    if (distances == nullptr) {
-        distanceMatrix = getDistancesMatrix(map);
-        distances = &distanceMatrix;
-    }
-
-    // Check arguments
-    if (startStation == nullptr) {
-        throw std::invalid_argument("startStation must not be null");
-    }
-
-    // Initialize remaining stations
-    std::vector<const ProblemStation *> remainingStations;
-    for (const ProblemStation &station : map) {
-        remainingStations.push_back(&station);
-    }
-
-    // Find start station
-    const auto startIndex = std::find(remainingStations.begin(), remainingStations.end(), startStation);
-    if (startIndex == remainingStations.end()) { // Not found
+ProblemPath TspNearestMultistartOptSolver::nearestNeighborPath(const ProblemMap &map, size_t startStation,
+                                                               const Matrix &distances) const {
+    // Check arguments, stations are identified by their index in the map to read the distance matrix
+    if (startStation >= map.size()) { // Not found
         throw std::invalid_argument("startStation is not in the map");
     }
+    const size_t startIndex = startStation;
 
-    // Remove start station from remaining stations
-    remainingStations.erase(startIndex);
+    // Initialize remaining stations, without the start station
+    std::vector<size_t> remainingStations;
+    for (size_t i = 0; i < map.size(); i++) {
+        if (i != startIndex)
+            remainingStations.push_back(i);
+    }
 
     ProblemPath path;
 
     // Add start station to path
-    path.push_back(*startStation);
+    path.push_back((problemidx_t)startStation);
+    size_t lastIndex = startIndex;
 
     // Add remaining stations to path
     while (!remainingStations.empty()) {
 
-        // Find the nearest station
-        const ProblemStation *nearestStation = nullptr;
-        nauticmiles_t minDistance = std::numeric_limits<nauticmiles_t>::infinity();
+        // Find the nearest station, planar distances (see PlanarDistances) are compared squared
+        auto comparedDistance = [&distances](size_t from, size_t to) {
+            if constexpr (requires { distances.squared(from, to); }) {
+                return distances.squared(from, to);
+            } else {
+                return distances(from, to);
+            }
+        };
+        typedef decltype(comparedDistance(0, 0)) distance_t;
+        size_t nearestPosition = 0;
+        distance_t minDistance = std::numeric_limits<distance_t>::max();
 
-        for (const ProblemStation* const station : remainingStations) {
+        for (size_t position = 0; position < remainingStations.size(); position++) {
 
             // Find the distance between the last station in path and the current station
-            //const int index1 = std::find(map.begin(), map.end(), path.back()) - map.begin();
-            //const int index2 = std::find(map.begin(), map.end(), *station) - map.begin();
-            //const nauticmiles_t distance = (*distances)[index1][index2];
-            const nauticmiles_t distance = geometry::distance(path.back().getLocation(), station->getLocation());
+            const distance_t distance = comparedDistance(lastIndex, remainingStations[position]);
 
-            // Update the nearest station
-            if (distance < minDistance) {
+            // Update the nearest station, quantized distances may be equal where the real ones are not
+            if (distance < minDistance || (Matrix::QUANTIZED && distance == minDistance &&
+                distances.exact(lastIndex, remainingStations[position]) < distances.exact(lastIndex, remainingStations[nearestPosition]))) {
                 minDistance = distance;
-                nearestStation = station;
+                nearestPosition = position;
             }
         }
 
         // Add the nearest station to path
-        path.push_back(*nearestStation);
+        lastIndex = remainingStations[nearestPosition];
+        path.push_back((problemidx_t)lastIndex);
 
         // Remove the nearest station from remaining stations
-        const auto nearestStationIndex = std::find(remainingStations.begin(), remainingStations.end(), nearestStation);
-        remainingStations.erase(nearestStationIndex);
+        remainingStations.erase(remainingStations.begin() + nearestPosition);
     }
 
     return path;
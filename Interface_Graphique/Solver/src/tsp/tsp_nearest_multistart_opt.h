@@ -5,15 +5,20 @@
 #include <assert.h>
 
 #include "../pathsolver.h"
+#include "../distancepolicy.h"
 #include "tsp_optimization.h"
 
 class TspNearestMultistartOptSolver : public PathSolver {
+public:
+    static constexpr size_t NO_STATION = -1; // value of startStation/endStation if none is required
+
 private:
     unsigned int m_nbThread;
     unsigned int m_optAlgo;
     bool m_loop;
-    const ProblemStation *m_startStation;
-    const ProblemStation *m_endStation;
+    size_t m_startStation; // indices in the map
+    size_t m_endStation;
+    DistancePolicy m_distancePolicy;
 
 public:
     /*
@@ -22,7 +27,7 @@ public:
      *
      *                          start
      *                           /\
-     *                      null/  \!null
+     *                NO_STATION/  \index
      *                     /             \
      *                 loop               loop
      *                  /\                 /\
@@ -30,15 +35,19 @@ public:
      *                              /
      *                            end
      *                            /\
-     *                       null/  \!null
+     *                 NO_STATION/  \index
+     *
+     * distancePolicy chooses between speed, memory and accuracy of the distances used while searching (see DistancePolicy),
+     * the length of the returned path is always exact.
      *
      * THROWS : - invalid_argument exception if the parameters are invalid
      *          - invalid_argument exception if the number of threads is 0
      *          - invalid_argument exception if the optimization algorithm is invalid
      */
-    TspNearestMultistartOptSolver(unsigned int nbThread, unsigned int optAlgo, bool loop, const ProblemStation *startStation,
-                                  const ProblemStation *endStation)
-      : m_nbThread(nbThread), m_optAlgo(optAlgo), m_loop(loop), m_startStation(startStation), m_endStation(endStation)
+    TspNearestMultistartOptSolver(unsigned int nbThread, unsigned int optAlgo, bool loop, size_t startStation,
+                                  size_t endStation, DistancePolicy distancePolicy = DistancePolicy::MATRIX)
+      : m_nbThread(nbThread), m_optAlgo(optAlgo), m_loop(loop), m_startStation(startStation), m_endStation(endStation),
+        m_distancePolicy(distancePolicy)
     {
         // Check arguments
         if (nbThread == 0) {
@@ -47,17 +56,17 @@ public:
         if (optAlgo != 0 && optAlgo != 2 && optAlgo != 3) {
             throw std::invalid_argument("Invalid optimization algorithm (must be 0, 2 or 3)");
         }
-        if (startStation == nullptr && endStation != nullptr) {
+        if (startStation == NO_STATION && endStation != NO_STATION) {
             throw std::invalid_argument("The start station must be defined if the end station is defined");
         }
-        if (endStation != nullptr && loop) {
-            throw std::invalid_argument("The end station must be null if the path is a loop");
+        if (endStation != NO_STATION && loop) {
+            throw std::invalid_argument("The end station must be NO_STATION if the path is a loop");
         }
     }
 
     /*
      * Compute a path in the map passing through all the stations using the nearest neighbour algorithm and an optional optimization algorithm.
-     * If a start/end station has been provided, it must be in the map.
+     * If a start/end station has been provided, it must be an index of the map.
      *
      * It uses a multi-start meta-heuristic to improve the result.
      * The returned path is the best path found.
@@ -72,20 +81,20 @@ private:
      * Compute a path in the map passing through all the stations using the nearest neighbour algorithm and an optional optimization algorithm.
      * If a start/end station has been provided, it must be in the map.
      *
-     * This method is used by the different threads.
+     * This method is used by the different threads, they all share the same (read-only) distance matrix and candidate set.
      */
-    void solveMultiStartThread(const ProblemMap &map, std::vector<const ProblemStation *> &leftStations, ProblemPath &bestPath,
-                               nauticmiles_t &bestLength, std::mutex &mutex, SolverRuntime *runtime) const;
+    template<class Matrix>
+    void solveMultiStartThread(const ProblemMap &map, const Matrix &distances, const CandidateSet &candidates, std::vector<size_t> &leftStations,
+                               ProblemPath &bestPath, nauticmiles_t &bestLength, std::mutex &mutex, SolverRuntime *runtime) const;
 
     /*
      * Compute a path in the map passing through all the stations using the nearest neighbour algorithm.
      * A valid starting station must be provided.
      * To obtain a closed path, the same station should be provided as both the start and end station.
      *
-     * THROWS : - invalid_argument exception if start/endStation is null
-     *          - invalid_argument exception if start/endStation is not in the map
+     * THROWS : - invalid_argument exception if startStation is not an index of the map
      */
+    template<class Matrix>
     [[nodiscard]]
-    ProblemPath nearestNeighborPath(const ProblemMap &map, const ProblemStation *const startStation,
-                                    std::vector<std::vector<nauticmiles_t>> *distances) const;
+    ProblemPath nearestNeighborPath(const ProblemMap &map, size_t startStation, const Matrix &distances) const;
 };
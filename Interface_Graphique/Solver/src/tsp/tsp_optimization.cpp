@@ -1,65 +1,76 @@
 #include "tsp_optimization.h"
 
+#include <utility>
+#include <initializer_list>
+
 
 namespace tsp_optimization {
 
+    /*
+     * Quantized matrices (see QuantizedDistanceMatrix) may give the same length to two sets of edges
+     * that do not have the same real length, this breaks such ties using the exact distances.
+     * Returns true if the new edges are shorter than the old ones.
+     */
+    template<class Matrix>
+    static bool isExactlyShorter(const Matrix &distances, std::initializer_list<std::pair<problemidx_t, problemidx_t>> newEdges,
+                                 std::initializer_list<std::pair<problemidx_t, problemidx_t>> oldEdges) {
+        nauticmiles_t newLength = 0, oldLength = 0;
+        for (const auto &[from, to] : newEdges)
+            newLength += distances.exact(from, to);
+        for (const auto &[from, to] : oldEdges)
+            oldLength += distances.exact(from, to);
+        return newLength < oldLength;
+    }
+
     /*
      * Optimize a path using the 2-opt algorithm.
      * Obviously, this algorithm will not return the optimal path but will only try to improve the given path.
      *
-     * You can pass a matrix (vector of vector) of distances between stations.
-     * If it is not provided, the distances will be computed using the geometry::distance function.
+     * The distances between stations are read from one of the distance sources of a DistancePolicy (see
+     * distancepolicy.h) or from a ZeroEdgeOverlay of one.
      *
-     * The map is used to know how to read the distances matrix.
+     * The path holds the indices of its stations in the map, which are also their indices in the distances.
      *
      * WARNING : Even if this algorithm is faster than the 3-opt algorithm, it can still take a long time to compute on large instance.
      * You can limit the time by passing a pointer to a boolean that you can set to true to stop the algorithm (in another thread for example).
      */
+    template<class Matrix>
     [[maybe_unused]] [[nodiscard]]
-    ProblemPath o2opt(const ProblemPath &path, const ProblemMap &map, std::vector<std::vector<nauticmiles_t>> *distances,
-                      bool *stop) {
+    ProblemPath o2opt(const ProblemPath &path, const Matrix &distances, bool *stop) {
         // Handle errors
         if (path.empty()) {
             throw std::invalid_argument("The path cannot be empty");
         }
 
-        // Compute the distance matrix if it is not provided
-        std::vector<std::vector<nauticmiles_t>> distanceMatrix;
-        if (distances == nullptr) {
-            distanceMatrix = getDistancesMatrix(map);
-            distances = &distanceMatrix;
-        }
-
-        ProblemPath optimizedPath = path;
-
-        // Get the order of the stations in the path
-        std::vector<int> pathOrder{};
-        for (const ProblemStation &station : optimizedPath) {
-            int index = std::find(map.begin(), map.end(), station) - map.begin();
-            pathOrder.push_back(index);
-        }
+        // The stations of the path are their indices in the map and in the distances matrix
+        ProblemPath pathOrder = path;
 
         bool improved = true;
 
         while (improved) {
             improved = false;
-            for (size_t i = 0; i < (optimizedPath.size() - 1); ++i) {
-                for (size_t j = i + 1; j < (optimizedPath.size() - 1); ++j) {
+            for (size_t i = 0; i < (pathOrder.size() - 1); ++i) {
+                // Length of the (i,i+1) edge, only changes when the path is modified
+                auto edgeLength = distances(pathOrder[i], pathOrder[i + 1]);
+
+                for (size_t j = i + 1; j < (pathOrder.size() - 1); ++j) {
 
                     // Check if we have exceeded the time limit
                     if (stop && *stop) {
-                        return optimizedPath;
+                        return pathOrder;
                     }
 
-                    if ((*distances)[pathOrder[i]][pathOrder[j]] +
-                        (*distances)[pathOrder[i + 1]][pathOrder[j + 1]]
-                        <
-                        (*distances)[pathOrder[i]][pathOrder[i + 1]] +
-                        (*distances)[pathOrder[j]][pathOrder[j + 1]]) {
+                    auto newLength = distances(pathOrder[i], pathOrder[j]) + distances(pathOrder[i + 1], pathOrder[j + 1]);
+                    auto oldLength = edgeLength + distances(pathOrder[j], pathOrder[j + 1]);
+
+                    if (newLength < oldLength || (Matrix::QUANTIZED && newLength == oldLength && isExactlyShorter(distances,
+                        { { pathOrder[i], pathOrder[j] }, { pathOrder[i + 1], pathOrder[j + 1] } },
+                        { { pathOrder[i], pathOrder[i + 1] }, { pathOrder[j], pathOrder[j + 1] } }))) {
 
                         // Change the order of the stations
                         std::reverse(pathOrder.begin() + i + 1,
                                      pathOrder.begin() + j + 1);
+                        edgeLength = distances(pathOrder[i], pathOrder[i + 1]);
 
                         improved = true;
                     }
@@ -67,13 +78,7 @@ namespace tsp_optimization {
             }
         }
 
-        // Convert path order to path
-        optimizedPath.clear();
-        for (size_t i = 0; i < pathOrder.size(); ++i) {
-            optimizedPath.push_back(map[pathOrder[i]]);
-        }
-
-        return optimizedPath;
+        return pathOrder;
     }
 
 
@@ -81,58 +86,48 @@ namespace tsp_optimization {
      * Optimize a path using the 3-opt algorithm.
      * Obviously, this algorithm will not return the optimal path but will only try to improve the given path.
      *
-     * You can pass a matrix (vector of vector) of distances between stations.
-     * If it is not provided, the distances will be computed using the geometry::distance function.
+     * The distances between stations are read from one of the distance sources of a DistancePolicy (see
+     * distancepolicy.h) or from a ZeroEdgeOverlay of one.
      *
-     * The map is used to know how to read the distances matrix.
+     * The path holds the indices of its stations in the map, which are also their indices in the distances.
      *
      * WARNING : This algorithm can take a long time to compute.
      * You can limit the time by passing a pointer to a boolean that you can set to true to stop the algorithm (in another thread).
      */
-    ProblemPath o3opt(const ProblemPath &path, const ProblemMap &map, std::vector<std::vector<nauticmiles_t>> *distances,
-                      bool *stop) {
+    template<class Matrix>
+    ProblemPath o3opt(const ProblemPath &path, const Matrix &distances, bool *stop) {
         // Handle errors
         if (path.empty()) {
             throw std::invalid_argument("The path cannot be empty");
         }
 
-        // Compute the distance matrix if it is not provided
-        std::vector<std::vector<nauticmiles_t>> distanceMatrix;
-        if (distances == nullptr) {
-            distanceMatrix = getDistancesMatrix(map);
-            distances = &distanceMatrix;
-        }
-
-        ProblemPath optimizedPath = path;
-
-        // Get the order of the stations in the path
-        std::vector<int> pathOrder{};
-        for (const ProblemStation &station : optimizedPath) {
-            int index = std::find(map.begin(), map.end(), station) - map.begin();
-            pathOrder.push_back(index);
-        }
+        // The stations of the path are their indices in the map and in the distances matrix
+        ProblemPath pathOrder = path;
 
         bool improved = true;
 
         while (improved) {
             improved = false;
-            for (size_t i = 0 ; i < (optimizedPath.size() - 1); ++i) {
-                for (size_t j = i + 1; j < (optimizedPath.size() - 1); ++j) {
-                    for (size_t k = j + 1; k < (optimizedPath.size() - 1); ++k) {
+            for (size_t i = 0 ; i < (pathOrder.size() - 1); ++i) {
+                for (size_t j = i + 1; j < (pathOrder.size() - 1); ++j) {
+                    for (size_t k = j + 1; k < (pathOrder.size() - 1); ++k) {
 
                         // Check if we have exceeded the time limit
                         if (stop && *stop) {
-                            return optimizedPath;
+                            return pathOrder;
                         }
 
+                        auto newLength = distances(pathOrder[i], pathOrder[j]) +
+                                         distances(pathOrder[i + 1], pathOrder[k]) +
+                                         distances(pathOrder[j + 1], pathOrder[k + 1]);
+                        auto oldLength = distances(pathOrder[i], pathOrder[i + 1]) +
+                                         distances(pathOrder[j], pathOrder[j + 1]) +
+                                         distances(pathOrder[k], pathOrder[k + 1]);
+
                         // Change path if the new one is better
-                        if ((*distances)[pathOrder[i]][pathOrder[j]] +
-                            (*distances)[pathOrder[i + 1]][pathOrder[k]] +
-                            (*distances)[pathOrder[j + 1]][pathOrder[k + 1]]
-                            <
-                            (*distances)[pathOrder[i]][pathOrder[i + 1]] +
-                            (*distances)[pathOrder[j]][pathOrder[j + 1]] +
-                            (*distances)[pathOrder[k]][pathOrder[k + 1]]) {
+                        if (newLength < oldLength || (Matrix::QUANTIZED && newLength == oldLength && isExactlyShorter(distances,
+                            { { pathOrder[i], pathOrder[j] }, { pathOrder[i + 1], pathOrder[k] }, { pathOrder[j + 1], pathOrder[k + 1] } },
+                            { { pathOrder[i], pathOrder[i + 1] }, { pathOrder[j], pathOrder[j + 1] }, { pathOrder[k], pathOrder[k + 1] } }))) {
 
                             // Reverse the path between j and k
                             std::reverse(pathOrder.begin() + j + 1,
@@ -149,12 +144,186 @@ namespace tsp_optimization {
             }
         }
 
-        // Convert path order to path
-        optimizedPath.clear();
+        return pathOrder;
+    }
+
+    /*
+     * Position of every station in the path, -1 for the stations that are not in it.
+     * The first station of a closed path is also its last one, the first position is kept.
+     */
+    static std::vector<int> getPositions(const ProblemPath &pathOrder, size_t mapSize) {
+        std::vector<int> positions(mapSize, -1);
         for (size_t i = 0; i < pathOrder.size(); ++i) {
-            optimizedPath.push_back(map[pathOrder[i]]);
+            if (positions[pathOrder[i]] == -1) {
+                positions[pathOrder[i]] = (int)i;
+            }
+        }
+        return positions;
+    }
+
+    /*
+     * Same as o2opt but only tries the moves that link a station to one of its candidates.
+     *
+     * A move removes the (i,i+1) and (j,j+1) edges and adds the (i,j) and (i+1,j+1) ones. For a
+     * station a and its candidate c, the (a,c) edge can be either of the new edges.
+     */
+    template<class Matrix>
+    [[maybe_unused]] [[nodiscard]]
+    ProblemPath o2opt(const ProblemPath &path, const ProblemMap &map, const Matrix &distances, const CandidateSet &candidates, bool *stop) {
+        // Handle errors
+        if (path.empty()) {
+            throw std::invalid_argument("The path cannot be empty");
+        }
+
+        // The stations of the path are their indices in the map and in the distances matrix
+        ProblemPath pathOrder = path;
+        std::vector<int> positions = getPositions(pathOrder, map.size());
+        const int lastEdge = (int)pathOrder.size() - 2; // the (lastEdge,lastEdge+1) edge is the last one
+
+        // Tries the move between the (i,i+1) and (j,j+1) edges, returns true if it was applied
+        auto tryMove = [&](int i, int j) {
+            if (i < 0 || j > lastEdge || j <= i + 1) {
+                return false;
+            }
+            auto newLength = distances(pathOrder[i], pathOrder[j]) + distances(pathOrder[i + 1], pathOrder[j + 1]);
+            auto oldLength = distances(pathOrder[i], pathOrder[i + 1]) + distances(pathOrder[j], pathOrder[j + 1]);
+
+            if (newLength < oldLength || (Matrix::QUANTIZED && newLength == oldLength && isExactlyShorter(distances,
+                { { pathOrder[i], pathOrder[j] }, { pathOrder[i + 1], pathOrder[j + 1] } },
+                { { pathOrder[i], pathOrder[i + 1] }, { pathOrder[j], pathOrder[j + 1] } }))) {
+
+                // Change the order of the stations
+                std::reverse(pathOrder.begin() + i + 1,
+                             pathOrder.begin() + j + 1);
+                for (int k = i + 1; k <= j; ++k) {
+                    positions[pathOrder[k]] = k;
+                }
+                return true;
+            }
+            return false;
+        };
+
+        bool improved = true;
+
+        while (improved) {
+            improved = false;
+            for (int p = 0; p <= lastEdge + 1; ++p) {
+                for (uint32_t candidate : candidates.candidates(pathOrder[p])) {
+
+                    // Check if we have exceeded the time limit
+                    if (stop && *stop) {
+                        return pathOrder;
+                    }
+
+                    int q = positions[candidate];
+                    if (q == -1) {
+                        continue;
+                    }
+                    // (a,c) as the (i,j) edge, then as the (i+1,j+1) edge
+                    if (tryMove(std::min(p, q), std::max(p, q)) || tryMove(std::min(p, q) - 1, std::max(p, q) - 1)) {
+                        improved = true;
+                        break; // the station at p changed
+                    }
+                }
+            }
+        }
+
+        return pathOrder;
+    }
+
+    /*
+     * Same as o3opt but only tries the moves whose first two new edges link stations to one of their candidates.
+     *
+     * A move removes the (i,i+1), (j,j+1) and (k,k+1) edges and adds the (i,j), (i+1,k) and (j+1,k+1) ones,
+     * j is taken among the candidates of the station at i and k among the candidates of the station at i+1.
+     */
+    template<class Matrix>
+    ProblemPath o3opt(const ProblemPath &path, const ProblemMap &map, const Matrix &distances, const CandidateSet &candidates, bool *stop) {
+        // Handle errors
+        if (path.empty()) {
+            throw std::invalid_argument("The path cannot be empty");
+        }
+
+        // The stations of the path are their indices in the map and in the distances matrix
+        ProblemPath pathOrder = path;
+        std::vector<int> positions = getPositions(pathOrder, map.size());
+        const int lastEdge = (int)pathOrder.size() - 2; // the (lastEdge,lastEdge+1) edge is the last one
+
+        bool improved = true;
+
+        while (improved) {
+            improved = false;
+            for (int i = 0; i < lastEdge; ++i) {
+                bool moved = false;
+                for (uint32_t candidateJ : candidates.candidates(pathOrder[i])) {
+                    int j = positions[candidateJ];
+                    if (j <= i || j >= lastEdge) {
+                        continue;
+                    }
+                    for (uint32_t candidateK : candidates.candidates(pathOrder[i + 1])) {
+                        int k = positions[candidateK];
+                        if (k <= j || k > lastEdge) {
+                            continue;
+                        }
+
+                        // Check if we have exceeded the time limit
+                        if (stop && *stop) {
+                            return pathOrder;
+                        }
+
+                        auto newLength = distances(pathOrder[i], pathOrder[j]) +
+                                         distances(pathOrder[i + 1], pathOrder[k]) +
+                                         distances(pathOrder[j + 1], pathOrder[k + 1]);
+                        auto oldLength = distances(pathOrder[i], pathOrder[i + 1]) +
+                                         distances(pathOrder[j], pathOrder[j + 1]) +
+                                         distances(pathOrder[k], pathOrder[k + 1]);
+
+                        // Change path if the new one is better
+                        if (newLength < oldLength || (Matrix::QUANTIZED && newLength == oldLength && isExactlyShorter(distances,
+                            { { pathOrder[i], pathOrder[j] }, { pathOrder[i + 1], pathOrder[k] }, { pathOrder[j + 1], pathOrder[k + 1] } },
+                            { { pathOrder[i], pathOrder[i + 1] }, { pathOrder[j], pathOrder[j + 1] }, { pathOrder[k], pathOrder[k + 1] } }))) {
+
+                            // Reverse the path between j and k
+                            std::reverse(pathOrder.begin() + j + 1,
+                                         pathOrder.begin() + k + 1);
+
+                            // Reverse the path between i and j
+                            std::reverse(pathOrder.begin() + i + 1,
+                                         pathOrder.begin() + j + 1);
+
+                            for (int p = i + 1; p <= k; ++p) {
+                                positions[pathOrder[p]] = p;
+                            }
+                            moved = improved = true;
+                            break;
+                        }
+                    }
+                    if (moved) {
+                        break; // the stations at i and i+1 changed
+                    }
+                }
+            }
         }
 
-        return optimizedPath;
+        return pathOrder;
     }
+
+#define INSTANTIATE_OPTIMIZATIONS(Distances) \
+    template ProblemPath o2opt(const ProblemPath &, const Distances &, bool *); \
+    template ProblemPath o3opt(const ProblemPath &, const Distances &, bool *); \
+    template ProblemPath o2opt(const ProblemPath &, const ProblemMap &, const Distances &, const CandidateSet &, bool *); \
+    template ProblemPath o3opt(const ProblemPath &, const ProblemMap &, const Distances &, const CandidateSet &, bool *); \
+    template ProblemPath o2opt(const ProblemPath &, const ZeroEdgeOverlay<Distances> &, bool *); \
+    template ProblemPath o3opt(const ProblemPath &, const ZeroEdgeOverlay<Distances> &, bool *); \
+    template ProblemPath o2opt(const ProblemPath &, const ProblemMap &, const ZeroEdgeOverlay<Distances> &, const CandidateSet &, bool *); \
+    template ProblemPath o3opt(const ProblemPath &, const ProblemMap &, const ZeroEdgeOverlay<Distances> &, const CandidateSet &, bool *);
+
+    // one instantiation per distance policy, see distancepolicy.h
+    INSTANTIATE_OPTIMIZATIONS(SphericalDistances)
+    INSTANTIATE_OPTIMIZATIONS(HaversineDistances)
+    INSTANTIATE_OPTIMIZATIONS(PlanarDistances)
+    INSTANTIATE_OPTIMIZATIONS(StationDistanceMatrix)
+    INSTANTIATE_OPTIMIZATIONS(QuantizedStationDistanceMatrix)
+
+#undef INSTANTIATE_OPTIMIZATIONS
 }
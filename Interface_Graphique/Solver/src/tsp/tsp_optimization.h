@@ -10,31 +10,48 @@ namespace tsp_optimization {
      * Optimize a path using the 2-opt algorithm.
      * Obviously, this algorithm will not return the optimal path but will only try to improve the given path.
      *
-     * You can pass a matrix (vector of vector) of distances between stations.
-     * If it is not provided, the distances will be computed using the geometry::distance function.
+     * The distances between stations are read from one of the distance sources of a DistancePolicy (see
+     * distancepolicy.h) or from a ZeroEdgeOverlay of one.
      *
-     * The map is used to know how to read the distances matrix.
+     * The path holds the indices of its stations in the map, which are also their indices in the distances.
      *
      * WARNING : Even if this algorithm is faster than the 3-opt algorithm, it can still take a long time to compute on large instance.
      * You can limit the time by passing a pointer to a boolean that you can set to true to stop the algorithm (in another thread for example).
      */
+    template<class Matrix>
     [[maybe_unused]] [[nodiscard]]
-    ProblemPath o2opt(const ProblemPath &path, const ProblemMap &map, std::vector<std::vector<nauticmiles_t>> *distances = nullptr,
-                      bool *stop = nullptr);
+    ProblemPath o2opt(const ProblemPath &path, const Matrix &distances, bool *stop = nullptr);
 
     /*
      * Optimize a path using the 3-opt algorithm.
      * Obviously, this algorithm will not return the optimal path but will only try to improve the given path.
      *
-     * You can pass a matrix (vector of vector) of distances between stations.
-     * If it is not provided, the distances will be computed using the geometry::distance function.
+     * The distances between stations are read from one of the distance sources of a DistancePolicy (see
+     * distancepolicy.h) or from a ZeroEdgeOverlay of one.
      *
-     * The map is used to know how to read the distances matrix.
+     * The path holds the indices of its stations in the map, which are also their indices in the distances.
      *
      * WARNING : This algorithm can take a long time to compute.
      * You can limit the time by passing a pointer to a boolean that you can set to true to stop the algorithm (in another thread for example).
      */
-    ProblemPath o3opt(const ProblemPath &path, const ProblemMap &map, std::vector<std::vector<nauticmiles_t>> *distances = nullptr,
-                      bool *stop = nullptr);
+    template<class Matrix>
+    ProblemPath o3opt(const ProblemPath &path, const Matrix &distances, bool *stop = nullptr);
+
+    /*
+     * Same as o2opt but only tries the moves that link a station to one of its candidates (see CandidateSet),
+     * each pass costs O(N*K) instead of O(N^2) for K candidates per station.
+     * The candidate set must have been built from the same map.
+     */
+    template<class Matrix>
+    [[maybe_unused]] [[nodiscard]]
+    ProblemPath o2opt(const ProblemPath &path, const ProblemMap &map, const Matrix &distances, const CandidateSet &candidates, bool *stop = nullptr);
+
+    /*
+     * Same as o3opt but only tries the moves whose first two new edges link stations to one of their candidates
+     * (see CandidateSet), each pass costs O(N*K^2) instead of O(N^3) for K candidates per station.
+     * The candidate set must have been built from the same map.
+     */
+    template<class Matrix>
+    ProblemPath o3opt(const ProblemPath &path, const ProblemMap &map, const Matrix &distances, const CandidateSet &candidates, bool *stop = nullptr);
 };
 
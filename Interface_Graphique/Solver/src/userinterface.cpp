@@ -1,21 +1,153 @@
 #include "userinterface.h"
 
-#include "breitling/breitlingSolver.h"
+#include "breitling/mandatoryregions.h"
+#include "geoserializer/zipfile.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
-void svg_export::writePathToFile(const ProblemMap &geomap, const ProblemPath &path, const std::filesystem::path &filePath)
+namespace svg_export {
+
+namespace {
+
+constexpr const char *MANDATORY_REGION_COLORS[] = { "blue", "green", "red", "purple" };
+static_assert(std::size(MANDATORY_REGION_COLORS) == breitling_constraints::MANDATORY_REGION_COUNT);
+
+// a station, or the stations of a cell when they are clustered
+struct Marker {
+  Location location;
+  size_t stationCount;
+  bool canBeUsedToFuel;
+  bool isAccessibleAtNight;
+  uint32_t mandatoryRegions; // bit r is set if a station is in region r
+};
+
+Marker makeMarker(const ProblemMap &map, size_t station)
+{
+  return { map.getLocation(station), 1, map.canBeUsedToFuel(station), map.isAccessibleAtNight(station), map.getMandatoryRegions(station) };
+}
+
+std::vector<Marker> makeMarkers(const ProblemMap &map, double cellSize)
+{
+  std::vector<Marker> markers;
+  if (cellSize <= 0) {
+    markers.reserve(map.size());
+    for (size_t i = 0; i < map.size(); i++)
+      markers.push_back(makeMarker(map, i));
+    return markers;
+  }
+
+  // stations are sorted by cell, the stations of a cell are then consecutive
+  struct BinnedStation {
+    int64_t cellX, cellY;
+    size_t station;
+    auto operator<=>(const BinnedStation &) const = default;
+  };
+  std::vector<BinnedStation> binned;
+  binned.reserve(map.size());
+  for (size_t i = 0; i < map.size(); i++) {
+    const Location &location = map.getLocation(i);
+    binned.push_back({ (int64_t)std::floor(location.lon / cellSize), (int64_t)std::floor(location.lat / cellSize), i });
+  }
+  std::sort(binned.begin(), binned.end());
+
+  for (size_t i = 0; i < binned.size(); i++) {
+    Marker station = makeMarker(map, binned[i].station);
+    bool sameCell = i > 0 && binned[i].cellX == binned[i - 1].cellX && binned[i].cellY == binned[i - 1].cellY;
+    if (!sameCell) {
+      markers.push_back(station);
+      continue;
+    }
+    // the location is the sum of the stations' locations until the cell is complete
+    Marker &cluster = markers.back();
+    cluster.location.lon += station.location.lon;
+    cluster.location.lat += station.location.lat;
+    cluster.stationCount++;
+    cluster.canBeUsedToFuel |= station.canBeUsedToFuel;
+    cluster.isAccessibleAtNight |= station.isAccessibleAtNight;
+    cluster.mandatoryRegions |= station.mandatoryRegions;
+  }
+  for (Marker &cluster : markers) {
+    cluster.location.lon /= (double)cluster.stationCount;
+    cluster.location.lat /= (double)cluster.stationCount;
+  }
+  return markers;
+}
+
+double squaredDistanceToSegment(const Location &p, const Location &a, const Location &b)
+{
+  double dx = b.lon - a.lon, dy = b.lat - a.lat;
+  double lengthSquared = dx * dx + dy * dy;
+  double t = lengthSquared == 0 ? 0 : std::clamp(((p.lon - a.lon) * dx + (p.lat - a.lat) * dy) / lengthSquared, 0., 1.);
+  double ex = a.lon + t * dx - p.lon, ey = a.lat + t * dy - p.lat;
+  return ex * ex + ey * ey;
+}
+
+// Ramer-Douglas-Peucker, with an explicit stack so that long tours do not overflow the call stack
+std::vector<Location> simplifyPath(const ProblemMap &map, const ProblemPath &path, double tolerance)
+{
+  std::vector<Location> points;
+  points.reserve(path.size());
+  for (problemidx_t station : path)
+    points.push_back(map.getLocation(station));
+  if (tolerance <= 0 || points.size() <= 2)
+    return points;
+
+  std::vector<bool> kept(points.size(), false);
+  kept.front() = kept.back() = true;
+  std::vector<std::pair<size_t, size_t>> ranges{ { 0, points.size() - 1 } };
+  const double toleranceSquared = tolerance * tolerance;
+  while (!ranges.empty()) {
+    auto [first, last] = ranges.back();
+    ranges.pop_back();
+    double farthestDistance = 0;
+    size_t farthest = first;
+    for (size_t i = first + 1; i < last; i++) {
+      double d = squaredDistanceToSegment(points[i], points[first], points[last]);
+      if (d > farthestDistance) {
+        farthestDistance = d;
+        farthest = i;
+      }
+    }
+    if (farthestDistance > toleranceSquared) {
+      kept[farthest] = true;
+      ranges.push_back({ first, farthest });
+      ranges.push_back({ farthest, last });
+    }
+  }
+
+  size_t keptCount = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (kept[i])
+      points[keptCount++] = points[i];
+  }
+  points.resize(keptCount);
+  return points;
+}
+
+}
+
+void writePathToFile(const ProblemMap &geomap, const ProblemPath &path, const std::filesystem::path &filePath, const LevelOfDetail &lod)
 {
-  std::ofstream file{ filePath };
+  std::ofstream file{ filePath, std::ios::binary | std::ios::trunc };
+  if (!file)
+    throw std::runtime_error("Error while opening the file \"" + filePath.string() + "\"");
+  kml_export::TextBuffer out{ &file };
 
   double
     minLon = std::numeric_limits<double>::max(),
     minLat = std::numeric_limits<double>::max(),
-    maxLon = std::numeric_limits<double>::min(),
-    maxLat = std::numeric_limits<double>::min();
-  for (const ProblemStation &station : geomap) {
-    double lon = station.getLocation().lon;
-    double lat = station.getLocation().lat;
+    maxLon = std::numeric_limits<double>::lowest(),
+    maxLat = std::numeric_limits<double>::lowest();
+  for (const Location &location : geomap.getLocations()) {
+    double lon = location.lon;
+    double lat = location.lat;
     minLon = std::min(minLon, lon);
     minLat = std::min(minLat, lat);
     maxLon = std::max(maxLon, lon);
@@ -23,58 +155,102 @@ void svg_export::writePathToFile(const ProblemMap &geomap, const ProblemPath &pa
   }
 
   constexpr double padding = 1;
-  file << "<svg viewBox=\"" 
+  out << "<svg viewBox=\""
     << (minLon - padding) << " "
     << (minLat - padding) << " "
     << (maxLon - minLon + 2 * padding) << " "
     << (maxLat - minLat + 2 * padding)
     << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
 
-  file << "<g transform=\"scale(.83, -1) translate(0, -92.5) \">\n";
+  out << "<g transform=\"scale(.83, -1) translate(0, -92.5) \">\n";
 
-  for (const ProblemStation &station : geomap) {
+  for (const Marker &marker : makeMarkers(geomap, lod.cellSize)) {
     // black - all good
     // pink - no fuel  no night
     // blue - no night
     // red - no fuel
-    float red = station.canBeUsedToFuel() ? 0 : 1;
-    float green = .1f;
-    float blue = station.isAccessibleAtNight() ? 0 : 1;
-    file
-      << "<circle cx=\"" << station.getLocation().lon << "\" cy=\"" << station.getLocation().lat << "\" r=\".1\" "
+    double red = marker.canBeUsedToFuel ? 0 : 1;
+    double green = .1;
+    double blue = marker.isAccessibleAtNight ? 0 : 1;
+    // clusters grow with the number of stations they hold, up to the size of their cell
+    double radius = marker.stationCount == 1 ? .1 : std::max(.1, std::min(lod.cellSize / 2, .1 * std::sqrt((double)marker.stationCount)));
+    out
+      << "<circle cx=\"" << marker.location.lon << "\" cy=\"" << marker.location.lat << "\" r=\"" << radius << "\" "
       << "fill=\"rgb(" << red*255 << "," << green*255 << "," << blue*255 << ")\"/>\n";
 
-    if (breitling_constraints::isStationInMandatoryRegion(*station.getOriginalStation(), 0))
-      file
-      << "<rect x=\"" << station.getLocation().lon - .1 << "\" y=\"" << station.getLocation().lat - .1 << "\" "
-      << "stroke-width=\".05\" stroke=\"blue\" width = \".2\" height=\".2\" fill=\"transparent\" />";
-    if (breitling_constraints::isStationInMandatoryRegion(*station.getOriginalStation(), 1))
-      file
-      << "<rect x=\"" << station.getLocation().lon - .1 << "\" y=\"" << station.getLocation().lat - .1 << "\" "
-      << "stroke-width=\".05\" stroke=\"green\" width = \".2\" height=\".2\" fill=\"transparent\" />";
-    if (breitling_constraints::isStationInMandatoryRegion(*station.getOriginalStation(), 2))
-      file
-      << "<rect x=\"" << station.getLocation().lon - .1 << "\" y=\"" << station.getLocation().lat - .1 << "\" "
-      << "stroke-width=\".05\" stroke=\"red\" width = \".2\" height=\".2\" fill=\"transparent\" />";
-    if (breitling_constraints::isStationInMandatoryRegion(*station.getOriginalStation(), 3))
-      file
-      << "<rect x=\"" << station.getLocation().lon - .1 << "\" y=\"" << station.getLocation().lat - .1 << "\" "
-      << "stroke-width=\".05\" stroke=\"purple\" width = \".2\" height=\".2\" fill=\"transparent\" />";
+    for (size_t r = 0; r < breitling_constraints::MANDATORY_REGION_COUNT; r++) {
+      if (marker.mandatoryRegions & (1u << r))
+        out
+        << "<rect x=\"" << marker.location.lon - radius << "\" y=\"" << marker.location.lat - radius << "\" "
+        << "stroke-width=\".05\" stroke=\"" << MANDATORY_REGION_COLORS[r] << "\" width = \"" << 2 * radius << "\" height=\"" << 2 * radius << "\" fill=\"transparent\" />";
+    }
   }
 
-  file << "<path d=\"M";
-  for (const ProblemStation station : path)
-    file << station.getLocation().lon << " " << station.getLocation().lat << " ";
-  file << "\" stroke-width=\".05\" stroke=\"black\" fill=\"none\" stroke-linecap=\"round\" stroke-linejoin=\"round\"/>\n";
+  out << "<path d=\"M";
+  for (const Location &point : simplifyPath(geomap, path, lod.pathTolerance))
+    out << point.lon << " " << point.lat << " ";
+  out << "\" stroke-width=\".05\" stroke=\"black\" fill=\"none\" stroke-linecap=\"round\" stroke-linejoin=\"round\"/>\n";
 
-  file << "</g>\n";
+  out << "</g>\n";
+
+  out << "</svg>\n";
+  out.flush();
+  file.close();
+  if (!file)
+    throw std::runtime_error("Error while writing the file \"" + filePath.string() + "\"");
+}
 
-  file << "</svg>" << std::endl;
 }
 
 namespace kml_export {
 
-void writeHeader(std::ostream &out)
+TextBuffer::TextBuffer(std::ostream *sink)
+  : m_sink(sink)
+{
+  m_buffer.reserve(sink != nullptr ? FLUSH_SIZE + FLUSH_SIZE / 8 : FLUSH_SIZE);
+}
+
+TextBuffer &TextBuffer::operator<<(double value)
+{
+  char digits[64];
+  std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+  char *end = result.ptr;
+  if (result.ec == std::errc{} && std::find(digits, end, '.') != end) {
+    while (end[-1] == '0')
+      end--;
+    if (end[-1] == '.')
+      end--;
+  }
+  return *this << std::string_view(digits, end - digits);
+}
+
+TextBuffer &TextBuffer::appendEscaped(std::string_view text)
+{
+  size_t start = 0;
+  for (size_t i = 0; i < text.size(); i++) {
+    const char *entity;
+    switch (text[i]) {
+    case '&': entity = "&amp;"; break;
+    case '<': entity = "&lt;"; break;
+    case '>': entity = "&gt;"; break;
+    case '"': entity = "&quot;"; break;
+    default: continue;
+    }
+    *this << text.substr(start, i - start) << entity;
+    start = i + 1;
+  }
+  return *this << text.substr(start);
+}
+
+void TextBuffer::flush()
+{
+  if (m_sink == nullptr)
+    return;
+  m_sink->write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+}
+
+void writeHeader(TextBuffer &out)
 {
   out << 
     "<?xml version = \"1.0\" encoding = \"UTF-8\" ?>"
@@ -84,14 +260,14 @@ void writeHeader(std::ostream &out)
     "\n    <description/>";
 }
 
-void writeFooter(std::ostream &out)
+void writeFooter(TextBuffer &out)
 {
   out <<
     "\n  </Document>"
     "\n</kml>";
 }
 
-void writeStyle(std::ostream &out, const char *styleId, const char *color, const char *iconHref, bool small=false)
+void writeStyle(TextBuffer &out, const char *styleId, const char *color, const char *iconHref, bool small=false)
 {
   out <<
     "\n<Style id=\"" << styleId << "-normal\">"
@@ -140,11 +316,14 @@ void writeStyle(std::ostream &out, const char *styleId, const char *color, const
     "\n</StyleMap>";
 }
 
-void writeStation(std::ostream &out, const ProblemStation &station, const char *style)
+void writeStation(TextBuffer &out, const ProblemStation &station, const char *style)
 {
   out <<
     "\n<Placemark>"
-    "\n  <name>" << station.getOriginalStation()->getName() << "</name>"
+    "\n  <name>";
+  out.appendEscaped(station.getOriginalStation()->getName());
+  out <<
+    "</name>"
     "\n  <styleUrl>#" << style << "</styleUrl>"
     "\n  <Point>"
     "\n    <coordinates>"
@@ -154,7 +333,7 @@ void writeStation(std::ostream &out, const ProblemStation &station, const char *
     "\n</Placemark>";
 }
 
-void writeAllStationsLayer(std::ostream &out, const ProblemMap &map)
+void writeAllStationsLayer(TextBuffer &out, const ProblemMap &map)
 {
   const char *styleId = "icon-1739-0288D2-nodesc"; // mymaps encodes icon info in the style id for some reason
 
@@ -169,7 +348,7 @@ void writeAllStationsLayer(std::ostream &out, const ProblemMap &map)
     "\n</Folder>";
 }
 
-void writeProblemStationsLayer(std::ostream &out, const ProblemMap &map)
+void writeProblemStationsLayer(TextBuffer &out, const ProblemMap &map)
 {
   const char *fuelAvailableStyle = "station-wfuel-icon";
   const char *nightAvailableStyle = "station-wnight-icon";
@@ -199,7 +378,7 @@ void writeProblemStationsLayer(std::ostream &out, const ProblemMap &map)
     "\n</Folder>";
 }
 
-void writePathLayer(std::ostream &out, const ProblemPath &path, const char *layerName)
+void writePathLayer(TextBuffer &out, const ProblemMap &map, const ProblemPath &path, const char *layerName)
 {
   const char *pathStyle = "path-path";
   const char *pathIconStyle = "icon-1739-0288D1-nodesc"; // mymaps encodes icon info in the style id for some reason
@@ -214,14 +393,14 @@ void writePathLayer(std::ostream &out, const ProblemPath &path, const char *laye
 
   out <<
     "\n<Placemark>"
-    "\n  <name> Longueur du chemin : " << getLength(path) << " NM</name>"
+    "\n  <name> Longueur du chemin : " << std::round(getLength(map, path) * 100) / 100 << " NM</name>"
     "\n  <styleUrl>#" << pathStyle << "</styleUrl>"
     "\n  <LineString>"
     "\n    <tessellate>1</tessellate>"
     "\n    <coordinates>";
 
-  for (const ProblemStation &station : path) {
-    out << station.getLocation().lon << "," << station.getLocation().lat << ",0\n";
+  for (problemidx_t station : path) {
+    out << map.getLocation(station).lon << "," << map.getLocation(station).lat << ",0\n";
   }
 
   out << 
@@ -229,13 +408,41 @@ void writePathLayer(std::ostream &out, const ProblemPath &path, const char *laye
     "\n  </LineString>"
     "\n</Placemark>";
 
-  for (const ProblemStation &station : path) {
+  for (problemidx_t station : path) {
     bool flagIcon = station == path.front() || station == path.back();
-    writeStation(out, station, flagIcon ? pathFlagStyle : pathIconStyle);
+    writeStation(out, map[station], flagIcon ? pathFlagStyle : pathIconStyle);
   }
 
   out <<
     "\n</Folder>";
 }
 
+KmlFile::KmlFile(const std::filesystem::path &file)
+  : m_path(file),
+  m_compressed(file.extension() == ".kmz"),
+  m_buffer(m_compressed ? nullptr : &m_file)
+{
+  if (!m_compressed) {
+    m_file.open(file, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+      throw std::runtime_error("Error while opening the file \"" + file.string() + "\"");
+  }
+  writeHeader(m_buffer);
+}
+
+void KmlFile::close()
+{
+  writeFooter(m_buffer);
+  if (m_compressed) {
+    // a KMZ archive is a zip holding the document as doc.kml
+    const ZipFileEntry document{ "doc.kml", m_buffer.getText() };
+    writeZipFile(m_path, { &document, 1 });
+  } else {
+    m_buffer.flush();
+    m_file.close();
+    if (!m_file)
+      throw std::runtime_error("Error while writing the file \"" + m_path.string() + "\"");
+  }
+}
+
 }
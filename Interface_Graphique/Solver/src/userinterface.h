@@ -1,6 +1,9 @@
 #pragma once
 
 #include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
 
 #include "geomap.h"
 #include "path.h"
@@ -8,16 +11,98 @@
 
 namespace svg_export {
 
-void writePathToFile(const ProblemMap &geomap, const ProblemPath &path, const std::filesystem::path &file);
+/*
+ * Level of detail of an SVG export, in degrees of longitude/latitude. The default
+ * draws every station and every point of the path.
+ *
+ * With a cell size, stations are binned on a grid of cells of that size and each
+ * non-empty cell is drawn as a single circle at the center of its stations, larger
+ * for dense cells. A cluster is drawn as able to refuel (resp. accessible at night)
+ * if any of its stations is, and marked for each mandatory region one of its
+ * stations is in.
+ *
+ * With a path tolerance, the path is simplified (Ramer-Douglas-Peucker): points
+ * closer than the tolerance to the simplified line are dropped. The first and
+ * last points are always kept.
+ */
+struct LevelOfDetail {
+  double cellSize = 0;
+  double pathTolerance = 0;
+};
+
+void writePathToFile(const ProblemMap &geomap, const ProblemPath &path, const std::filesystem::path &file, const LevelOfDetail &lod = {});
 
 }
 
 namespace kml_export {
 
-void writeHeader(std::ostream &out);
-void writeFooter(std::ostream &out);
-void writeAllStationsLayer(std::ostream &out, const ProblemMap &map);
-void writeProblemStationsLayer(std::ostream &out, const ProblemMap &map);
-void writePathLayer(std::ostream &out, const ProblemPath &path, const char *layerName);
+/*
+ * Text output for large documents. Text is appended to a buffer and numbers are
+ * formatted with std::to_chars, independently of the locale and without stream
+ * state. When a sink is given the buffer is written to it every FLUSH_SIZE bytes,
+ * otherwise the whole text is kept (see getText).
+ */
+class TextBuffer {
+public:
+  static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+private:
+  std::string m_buffer;
+  std::ostream *m_sink;
+
+public:
+  explicit TextBuffer(std::ostream *sink = nullptr);
+
+  TextBuffer &operator<<(std::string_view text)
+  {
+    m_buffer.append(text);
+    if (m_sink != nullptr && m_buffer.size() >= FLUSH_SIZE)
+      flush();
+    return *this;
+  }
+
+  TextBuffer &operator<<(const char *text) { return *this << std::string_view(text); }
+  TextBuffer &operator<<(const std::string &text) { return *this << std::string_view(text); }
+
+  // up to 6 decimals (~0.1m for coordinates), without trailing zeros
+  TextBuffer &operator<<(double value);
+
+  // appends text with the characters that are reserved in XML escaped
+  TextBuffer &appendEscaped(std::string_view text);
+
+  // writes the buffer to the sink, if any
+  void flush();
+
+  const std::string &getText() const { return m_buffer; }
+};
+
+void writeHeader(TextBuffer &out);
+void writeFooter(TextBuffer &out);
+void writeAllStationsLayer(TextBuffer &out, const ProblemMap &map);
+void writeProblemStationsLayer(TextBuffer &out, const ProblemMap &map);
+void writePathLayer(TextBuffer &out, const ProblemMap &map, const ProblemPath &path, const char *layerName);
+
+/*
+ * A KML document written to a file, as a compressed KMZ archive if the file name
+ * ends with .kmz. The constructor writes the header, layers are then written to
+ * getBuffer() and close() writes the footer.
+ *
+ * Plain KML is streamed to the file, a KMZ document is kept in memory until
+ * close() compresses it. Throws std::runtime_error if the file cannot be written.
+ */
+class KmlFile {
+private:
+  std::filesystem::path m_path;
+  std::ofstream m_file;
+  bool m_compressed;
+  TextBuffer m_buffer;
+
+public:
+  explicit KmlFile(const std::filesystem::path &file);
+
+  TextBuffer &getBuffer() { return m_buffer; }
+
+  void close();
+};
 
 }
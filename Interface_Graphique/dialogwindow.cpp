@@ -2,16 +2,21 @@
 #include "ui_dialogwindow.h"
 
 #include <thread>
-#include <fstream>
 
 #include <QThread>
 #include <QFileDialog>
+#include <QMessageBox>
 
 #include "Solver/src/geoserializer/csvserializer.h"
 #include "Solver/src/geoserializer/xlsserializer.h"
 #include "Solver/src/userinterface.h"
 
 #define SLEEP_TIME 500
+// the simplified SVG export groups the stations of cells of SVG_CELL_SIZE degrees and
+// drops the path points closer than SVG_PATH_TOLERANCE degrees to its shape, see svg_export::LevelOfDetail
+#define SIMPLIFIED_SVG_FILTER "SVG simplifié (*.svg)"
+#define SVG_CELL_SIZE .25
+#define SVG_PATH_TOLERANCE .02
 
 DialogWindow::DialogWindow(SolverExecutionState *solverState, QWidget *parent) :
     QDialog(parent, Qt::CustomizeWindowHint | Qt::WindowTitleHint),
@@ -82,23 +87,34 @@ void DialogWindow::saveFlightMapToFile() {
     else
         serializer = std::make_unique<CSVSerializer>();
 
-    Path path{};
-    for(ProblemStation &s : *m_solverState->finalPath)
-        path.getStations().push_back(s.getOriginalStation());
+    Path path = toPath(*m_solverState->originalMap, *m_solverState->finalPath);
     serializer->writePath(filePath.toStdString(), path);
 }
 
 void DialogWindow::saveMapToFile() {
-    QString filePath = QFileDialog::getSaveFileName(this, "Choisir une destination", QString(), "(*.kml)");
+    QString selectedFilter;
+    QString filePath = QFileDialog::getSaveFileName(this, "Choisir une destination", QString(),
+                                                    "KML (*.kml);;KML compressé (*.kmz);;SVG (*.svg);;" SIMPLIFIED_SVG_FILTER, &selectedFilter);
     if (filePath.isEmpty())
         return;
 
-    std::ofstream outFile{ filePath.toStdString() };
+    try {
+        if (filePath.endsWith(".svg")) {
+            svg_export::LevelOfDetail lod{};
+            if (selectedFilter == SIMPLIFIED_SVG_FILTER)
+                lod = { SVG_CELL_SIZE, SVG_PATH_TOLERANCE };
+            svg_export::writePathToFile(*m_solverState->originalMap, *m_solverState->finalPath, filePath.toStdWString(), lod);
+            return;
+        }
 
-    kml_export::writeHeader(outFile);
-    kml_export::writeAllStationsLayer(outFile, *m_solverState->originalMap);
-    if(!m_solverState->isTspInstance)
-        kml_export::writeProblemStationsLayer(outFile, *m_solverState->originalMap);
-    kml_export::writePathLayer(outFile, *m_solverState->finalPath, "Chemin");
-    kml_export::writeFooter(outFile);
+        kml_export::KmlFile outFile{ filePath.toStdWString() };
+        kml_export::writeAllStationsLayer(outFile.getBuffer(), *m_solverState->originalMap);
+        if(!m_solverState->isTspInstance)
+            kml_export::writeProblemStationsLayer(outFile.getBuffer(), *m_solverState->originalMap);
+        kml_export::writePathLayer(outFile.getBuffer(), *m_solverState->originalMap, *m_solverState->finalPath, "Chemin");
+        outFile.close();
+    } catch (const std::exception &e) {
+        // any exception, a failed compression or allocation must not escape the slot
+        QMessageBox::warning(this, "Impossible d'enregistrer le fichier", e.what());
+    }
 }
@@ -72,8 +72,8 @@ public:
         endResetModel();
     }
 
-    bool canBeUsedToFuel(const Station &station) {
-        return m_fuels[station.getNightVFR()];
+    bool canBeUsedToFuel(const std::string &fuel) const {
+        return m_fuels.value(fuel, false);
     }
 
     QMap<std::string, bool> &getFuels() { return m_fuels; }
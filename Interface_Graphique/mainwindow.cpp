@@ -7,7 +7,10 @@
 #include <memory>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QStandardPaths>
+#include <QTimer>
 #include "Solver/src/pathsolver.h"
+#include "Solver/src/distancepolicy.h"
 #include "Solver/src/tsp/tsp_nearest_multistart_opt.h"
 #include "Solver/src/breitling/breitlingnatural.h"
 #include "Solver/src/breitling/label_setting_breitling.h"
@@ -15,7 +18,8 @@
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    m_artifactCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdWString())
 {
     ui->setupUi(this);
 
@@ -53,6 +57,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    cancelLoading();
     delete ui;
 }
 
@@ -60,15 +65,12 @@ MainWindow::~MainWindow()
 void MainWindow::openFileDialog()
 {
     QString fileName = QFileDialog::getOpenFileName(this, "Ouvrir un fichier", QString(),
-                                                    "(*.xls *.xlsx *.csv)");
+                                                    "(*.xls *.xlsx *.csv *.fpdb)");
     if (fileName.isEmpty())
         return;
 
     this->filePath = fileName;
-    updateGeoMapFromFile();
-    updateComboBoxDepArr();
-    updateDepArrInfos();
-    updateFilterViews();
+    updateGeoMapFromFile(); // the views are updated once the file is loaded, see finishLoading
 }
 
 void MainWindow::saveFileDialog()
@@ -76,16 +78,31 @@ void MainWindow::saveFileDialog()
   if (filePath.isEmpty())
       return;
 
+  // the stations are lent to the map while it is written instead of being copied,
+  // no event is processed before they are given back to the model
   GeoMap geoMap;
-  geoMap.setStations(std::vector<Station>(m_excelModel.getStations().begin(), m_excelModel.getStations().end()));
-
-  if (filePath.endsWith(".xls") || filePath.endsWith(".xlsx")) {
-      XLSSerializer serializer;
-      serializer.writeMap(geoMap, filePath.toStdString());
-  } else if (filePath.endsWith(".csv")) {
-      CSVSerializer serializer;
-      serializer.writeMap(geoMap, filePath.toStdString());
+  geoMap.setStations(std::move(m_excelModel.getStations()));
+
+  QString error;
+  try {
+      if (filePath.endsWith(".xls") || filePath.endsWith(".xlsx")) {
+          XLSSerializer serializer;
+          serializer.writeMap(geoMap, filePath.toStdString());
+      } else if (filePath.endsWith(".csv")) {
+          CSVSerializer serializer;
+          serializer.writeMap(geoMap, filePath.toStdString());
+      } else if (filePath.endsWith(".fpdb")) {
+          BinarySerializer serializer;
+          serializer.writeMap(geoMap, filePath.toStdString());
+      }
+  } catch (const std::exception &e) {
+      // any exception, the stations must be given back to the model
+      error = e.what();
   }
+
+  m_excelModel.getStations() = std::move(geoMap.getStations());
+  if (!error.isEmpty())
+      QMessageBox::warning(this, "Impossible d'enregistrer le fichier", error);
 }
 
 void MainWindow::updateGeoMapFromFile()
@@ -93,30 +110,102 @@ void MainWindow::updateGeoMapFromFile()
     if (filePath.isEmpty())
         return;
 
-    GeoMap geoMap;
-
-    try {
-        if (filePath.endsWith(".xls") || filePath.endsWith(".xlsx")) {
-            XLSSerializer serializer;
-            geoMap = serializer.parseMap(filePath.toStdString());
-        } else if (filePath.endsWith(".csv")) {
-            CSVSerializer serializer;
-            geoMap = serializer.parseMap(filePath.toStdString());
-        } else {
-          // unreachable
-          assert(false);
+    cancelLoading();
+
+    // the file is parsed on another thread, the window stays responsive and the
+    // loading can be cancelled from the progress dialog
+    std::shared_ptr<ParseRuntime> runtime = std::make_shared<ParseRuntime>();
+    m_loadingRuntime = runtime;
+
+    m_loadingDialog = new QProgressDialog("Chargement de " + filePath + "...", "Annuler", 0, 100, this);
+    // shown immediately, the stations must not be used (by a solver for example) while they are replaced
+    m_loadingDialog->setWindowModality(Qt::WindowModal);
+    m_loadingDialog->setMinimumDuration(0);
+    m_loadingDialog->setValue(0);
+    connect(m_loadingDialog, &QProgressDialog::canceled, this, [runtime]() { runtime->userInterupted = true; });
+    QTimer *progressTimer = new QTimer(m_loadingDialog);
+    connect(progressTimer, &QTimer::timeout, m_loadingDialog, [dialog = m_loadingDialog, runtime]() {
+        dialog->setValue((int)(runtime->currentProgress * 100));
+    });
+    progressTimer->start(100);
+
+    m_loadingThread = std::thread{[this, runtime, file = filePath]() {
+        std::shared_ptr<GeoMap> geoMap = std::make_shared<GeoMap>();
+        QString error;
+        try {
+            if (file.endsWith(".xls") || file.endsWith(".xlsx")) {
+                XLSSerializer serializer;
+                *geoMap = serializer.parseMap(file.toStdString(), runtime.get());
+            } else if (file.endsWith(".csv")) {
+                CSVSerializer serializer;
+                *geoMap = serializer.parseMap(file.toStdString(), runtime.get());
+            } else if (file.endsWith(".fpdb")) {
+                BinarySerializer serializer;
+                *geoMap = serializer.parseMap(file.toStdString(), runtime.get());
+            } else {
+              // unreachable
+              assert(false);
+            }
+        } catch (const std::exception &e) {
+            // any exception, an uncaught one would terminate the application
+            error = e.what();
         }
-    } catch (const std::runtime_error &e) {
-        QMessageBox::warning(this, "Impossible de lire le fichier", e.what());
+
+        // the stations are handed to the UI thread, which owns the model
+        QMetaObject::invokeMethod(this, [this, runtime, geoMap, error]() {
+            finishLoading(runtime, *geoMap, error);
+        }, Qt::QueuedConnection);
+    }};
+}
+
+void MainWindow::cancelLoading()
+{
+    if (m_loadingRuntime == nullptr)
+        return;
+
+    // the result of the cancelled loading is ignored by finishLoading
+    m_loadingRuntime->userInterupted = true;
+    m_loadingThread.join();
+    m_loadingRuntime = nullptr;
+    delete m_loadingDialog;
+    m_loadingDialog = nullptr;
+}
+
+void MainWindow::finishLoading(const std::shared_ptr<ParseRuntime> &runtime, GeoMap &geoMap, const QString &error)
+{
+    if (runtime != m_loadingRuntime)
+        return; // cancelled already, by a newer loading
+
+    m_loadingThread.join(); // the thread stopped already
+    m_loadingRuntime = nullptr;
+    delete m_loadingDialog;
+    m_loadingDialog = nullptr;
+
+    if (runtime->userInterupted)
+        return;
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, "Impossible de lire le fichier", error);
         return;
     }
 
-    QList<Station> stations;
-    stations.reserve(geoMap.getStations().size());
-    for(const Station &s : geoMap.getStations())
-      stations.append(s);
-    m_excelModel.setStations(stations);
+    // the departure and arrival stay selected if the new map has stations with the same OACI codes
+    const Station *departure = getSelectedStation(ui->depComboBox);
+    const Station *arrival = getSelectedStation(ui->arrComboBox);
+    std::string departureOACI = departure ? departure->getOACI() : std::string{};
+    std::string arrivalOACI = arrival ? arrival->getOACI() : std::string{};
+
+    m_excelModel.setStations(std::move(geoMap.getStations()));
+    updateComboBoxDepArr();
+    auto reselect = [this](QComboBox *comboBox, const std::string &OACI) {
+        const Station *station = OACI.empty() ? nullptr : m_excelModel.findStationByOACI(OACI);
+        if (station != nullptr)
+            selectStation(comboBox, station->getId());
+    };
+    reselect(ui->depComboBox, departureOACI);
+    reselect(ui->arrComboBox, arrivalOACI);
     checkSolverCanBeRun();
+    updateDepArrInfos();
+    updateFilterViews();
 }
 
 void MainWindow::clickOnBoucle(int checkState) {
@@ -138,6 +227,10 @@ void MainWindow::updateFieldsVisibility() {
 }
 
 void MainWindow::updateComboBoxDepArr() {
+    // the selected stations stay selected if they are still listed
+    QVariant depStationId = ui->depComboBox->currentData();
+    QVariant arrStationId = ui->arrComboBox->currentData();
+
     ui->depComboBox->clear();
     ui->arrComboBox->clear();
 
@@ -146,27 +239,31 @@ void MainWindow::updateComboBoxDepArr() {
 
     for (const Station &station : m_excelModel.getStations()) {
         if (!station.isExcluded()) {
-            ui->depComboBox->addItem(QString::fromStdString(station.getName()));
-            ui->arrComboBox->addItem(QString::fromStdString(station.getName()));
+            ui->depComboBox->addItem(QString::fromStdString(station.getName()), station.getId());
+            ui->arrComboBox->addItem(QString::fromStdString(station.getName()), station.getId());
         }
     }
+
+    selectStation(ui->depComboBox, depStationId);
+    selectStation(ui->arrComboBox, arrStationId);
+}
+
+const Station *MainWindow::getSelectedStation(const QComboBox *comboBox) const {
+    QVariant stationId = comboBox->currentData();
+    return stationId.isValid() ? m_excelModel.findStation(stationId.toUInt()) : nullptr;
+}
+
+void MainWindow::selectStation(QComboBox *comboBox, QVariant stationId) {
+    int index = stationId.isValid() ? comboBox->findData(stationId) : -1;
+    comboBox->setCurrentIndex(std::max(index, 0)); // <aucun> if the station is not listed
 }
 
 void MainWindow::updateDepArrInfos() {
     checkDepArrBoucleValidity();
 
     // Get the selected stations
-    const Station *depStation = nullptr;
-    const Station *arrStation = nullptr;
-
-    for (const Station &station : m_excelModel.getStations()) {
-        if (station.getName() == ui->depComboBox->currentText().toStdString()) {
-            depStation = &station;
-        }
-        if (station.getName() == ui->arrComboBox->currentText().toStdString()) {
-            arrStation = &station;
-        }
-    }
+    const Station *depStation = getSelectedStation(ui->depComboBox);
+    const Station *arrStation = getSelectedStation(ui->arrComboBox);
 
     // Update the infos
     if (depStation != nullptr) {
@@ -203,22 +300,20 @@ void MainWindow::checkDepArrBoucleValidity() {
     }
 }
 
-template<typename AttributeGetter>
-void MainWindow::repopulateFilterMap(QMap<std::string, bool> &filterMap, AttributeGetter getter) {
-    // remove entries which are no longer used
-    filterMap.removeIf([this,&getter](const std::pair<std::string,bool> &p) {
-      return std::find_if(m_excelModel.getStations().begin(), m_excelModel.getStations().end(),
-            [&p,&getter](const Station &s) { return getter(s) == p.first; }) == m_excelModel.getStations().end();
-    });
-
-    // add entries for new values (default to true, ie. do not remove when filtering)
-    for (const Station &s : m_excelModel.getStations()) {
-        std::string clazz = getter(s);
-        if(!filterMap.contains(clazz)) {
-            bool defaultValue = clazz != "non";
-            filterMap[clazz] = defaultValue;
-        }
+void MainWindow::repopulateFilterMap(QMap<std::string, bool> &filterMap, StationAttributes::Attribute attribute) {
+    const StationAttributes &attributes = m_excelModel.getAttributes();
+    const AttributeDictionary &dictionary = attributes.getDictionary(attribute);
+
+    // keep the values used by at least one station, new values default to true
+    // (ie. do not remove when filtering) unless they are "non"
+    QMap<std::string, bool> repopulated;
+    for (attributeid_t id = 0; id < dictionary.size(); id++) {
+        if (!attributes.isUsed(attribute, id))
+            continue;
+        const std::string &clazz = dictionary.getValue(id);
+        repopulated[clazz] = filterMap.value(clazz, clazz != "non");
     }
+    filterMap = std::move(repopulated);
 }
 
 void MainWindow::updateFilterViews() {
@@ -227,9 +322,9 @@ void MainWindow::updateFilterViews() {
     QMap<std::string, bool> nightFlightMap = m_nightFlightModel.getStatuses();
 
     // delete unused entries and add new entries for new statuses
-    repopulateFilterMap(fuelMap, [](const Station &s) { return s.getFuel(); });
-    repopulateFilterMap(statusMap, [](const Station &s) { return s.getStatus(); });
-    repopulateFilterMap(nightFlightMap, [](const Station &s) { return s.getNightVFR(); });
+    repopulateFilterMap(fuelMap, StationAttributes::FUEL);
+    repopulateFilterMap(statusMap, StationAttributes::STATUS);
+    repopulateFilterMap(nightFlightMap, StationAttributes::NIGHT_VFR);
 
     // Update the models
     m_fuelModel.setFuels(fuelMap);
@@ -246,7 +341,7 @@ void MainWindow::excelTableViewChanged() {
 void MainWindow::checkSolverCanBeRun()
 {
     ui->computeButton->setEnabled(true);
-    if(m_excelModel.getStations().isEmpty()) {
+    if(m_excelModel.getStations().empty()) {
         ui->computeButton->setEnabled(false);
     } else if(ui->algoCombobox->currentIndex() == BREITLING_INDEX) {
         int departureStation = ui->depComboBox->currentIndex() - 1;
@@ -265,6 +360,12 @@ static inline daytime_t controlsToDaytime(const QSpinBox *hoursSpinbox, const QS
         (minutesSpinBox==nullptr ? 0 : minutesSpinBox->value()/60.f);
 }
 
+// the policy chosen in the distance combobox, solverDefault if the solver should use its own
+static inline DistancePolicy selectedDistancePolicy(const QComboBox *distanceComboBox, DistancePolicy solverDefault) {
+    int index = distanceComboBox->currentIndex();
+    return index <= 0 ? solverDefault : (DistancePolicy)(index - 1); // listed in the order of DistancePolicy
+}
+
 void MainWindow::runSolver() {
   SolverRuntime *runtime = new SolverRuntime{};
   ProblemPath *finalPath = new ProblemPath{};
@@ -274,28 +375,46 @@ void MainWindow::runSolver() {
   state.originalMap = problemMap;
   state.solverRuntime = runtime;
 
-  std::thread runnerThread{[this,&state,runtime,finalPath,problemMap]() {
+  // the filters are evaluated once per distinct value, stations are then filtered by their attribute ids
+  const StationAttributes &attributes = m_excelModel.getAttributes();
+  AttributeMask allowedStatuses = attributes.makeMask(StationAttributes::STATUS, [this](const std::string &status) { return !m_statusModel.isExcluded(status); });
+  AttributeMask nightAccessibility = attributes.makeMask(StationAttributes::NIGHT_VFR, [this](const std::string &nightVFR) { return m_nightFlightModel.isAccessibleAtNight(nightVFR); });
+  AttributeMask fuelAvailability = attributes.makeMask(StationAttributes::FUEL, [this](const std::string &fuel) { return m_fuelModel.canBeUsedToFuel(fuel); });
+
+  // the selected stations are found in the problem map by their ids
+  const Station *departure = getSelectedStation(ui->depComboBox);
+  const Station *arrival = getSelectedStation(ui->arrComboBox);
+  stationid_t departureId = departure ? departure->getId() : Station::NO_ID;
+  stationid_t targetId = arrival ? arrival->getId() : Station::NO_ID;
+
+  std::thread runnerThread{[this,&state,runtime,finalPath,problemMap,&attributes,&allowedStatuses,&nightAccessibility,&fuelAvailability,departureId,targetId]() {
       std::unique_ptr<PathSolver> solver;
 
-      for(const Station &station : m_excelModel.getStations()) {
-          if(station.isExcluded() || m_statusModel.isExcluded(station))
+      int departureStation = -1; // index in the problem map, will be -1 if no departure station is selected
+      int targetStation = -1; // will be -1 if no target station is selected
+
+      const std::vector<Station> &stations = m_excelModel.getStations();
+      for(size_t i = 0; i < stations.size(); i++) {
+          if(stations[i].isExcluded() || !allowedStatuses.test(attributes.getId(i, StationAttributes::STATUS)))
               continue;
-          bool isAccessibleAtNight = m_nightFlightModel.isAccessibleAtNight(station);
-          bool canBeUsedToFuel = m_fuelModel.canBeUsedToFuel(station);
-          problemMap->emplace_back(&station, isAccessibleAtNight, canBeUsedToFuel);
+          if(stations[i].getId() == departureId)
+              departureStation = (int)problemMap->size();
+          if(stations[i].getId() == targetId)
+              targetStation = (int)problemMap->size();
+          bool isAccessibleAtNight = nightAccessibility.test(attributes.getId(i, StationAttributes::NIGHT_VFR));
+          bool canBeUsedToFuel = fuelAvailability.test(attributes.getId(i, StationAttributes::FUEL));
+          problemMap->emplace_back(&stations[i], isAccessibleAtNight, canBeUsedToFuel);
       }
 
-      int departureStation = ui->depComboBox->currentIndex()-1; // will be -1 if no departure station is selected
-      int targetStation = ui->arrComboBox->currentIndex()-1; // will be -1 if no target station is selected
-
       // generate the solver instance
       if(ui->algoCombobox->currentIndex() == TSP_INDEX) {
           unsigned int nbThread = ui->threadSpinBox->value();
           unsigned int optAlgo = ui->optComboBox->currentIndex() == 0 ? 0 : ui->optComboBox->currentIndex() + 1; // 0, 2, 3
           bool loop = ui->boucle->checkState() == Qt::Checked;
-          const ProblemStation *startStation = departureStation == -1 ? nullptr : &(*problemMap)[departureStation];
-          const ProblemStation *endStation = targetStation == -1 ? nullptr : &(*problemMap)[targetStation];
-          solver = std::make_unique<TspNearestMultistartOptSolver>(nbThread, optAlgo, loop, startStation, endStation);
+          size_t startStation = departureStation == -1 ? TspNearestMultistartOptSolver::NO_STATION : departureStation;
+          size_t endStation = targetStation == -1 ? TspNearestMultistartOptSolver::NO_STATION : targetStation;
+          DistancePolicy distancePolicy = selectedDistancePolicy(ui->distanceComboBox, DistancePolicy::MATRIX);
+          solver = std::make_unique<TspNearestMultistartOptSolver>(nbThread, optAlgo, loop, startStation, endStation, distancePolicy);
           state.isTspInstance = true;
       } else {
           BreitlingData dataset;
@@ -308,14 +427,16 @@ void MainWindow::runSolver() {
           dataset.timeToRefuel = controlsToDaytime(nullptr, ui->tmpRav);
           dataset.departureStation = departureStation;
           dataset.targetStation = targetStation;
+          DistancePolicy distancePolicy = selectedDistancePolicy(ui->distanceComboBox, DistancePolicy::SPHERICAL);
           switch(ui->breitlingSolverCombo->currentIndex()) {
           default:
-          case 0: solver = std::make_unique<NaturalBreitlingSolver>(dataset); break;
-          case 1: solver = std::make_unique<LabelSettingBreitlingSolver>(dataset); break;
-          case 2: solver = std::make_unique<OptimisationSolver>(dataset); break;
+          case 0: solver = std::make_unique<NaturalBreitlingSolver>(dataset, distancePolicy); break;
+          case 1: solver = std::make_unique<LabelSettingBreitlingSolver>(dataset, distancePolicy); break;
+          case 2: solver = std::make_unique<OptimisationSolver>(dataset, distancePolicy); break;
           }
       }
 
+      solver->setArtifactCache(&m_artifactCache);
       *finalPath = solver->solveForPath(*problemMap, runtime);
       state.finishedExecution = true; // tells the UI that the solver finished solving
   }};
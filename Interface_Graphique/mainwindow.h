@@ -1,11 +1,18 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QComboBox>
 #include <QMainWindow>
+#include <QProgressDialog>
+
+#include <memory>
+#include <thread>
 
 #include "Solver/src/geomap.h"
 #include "Solver/src/geoserializer/xlsserializer.h"
 #include "Solver/src/geoserializer/csvserializer.h"
+#include "Solver/src/geoserializer/binaryserializer.h"
+#include "Solver/src/artifactcache.h"
 #include "fuelmodel.h"
 #include "stationmodel.h"
 #include "nightflightmodel.h"
@@ -34,9 +41,21 @@ private:
     FuelModel m_fuelModel;
     StationStatusModel m_statusModel;
     NightFlightModel m_nightFlightModel;
+    ArtifactCache m_artifactCache; // solvers' preprocessing, kept between runs and sessions
+
+    // files are parsed on m_loadingThread, the runtime is null when no file is being loaded
+    std::thread m_loadingThread;
+    std::shared_ptr<ParseRuntime> m_loadingRuntime;
+    QProgressDialog *m_loadingDialog = nullptr;
+
+    void repopulateFilterMap(QMap<std::string, bool> &filterMap, StationAttributes::Attribute attribute);
+
+    // the items of the departure and arrival combo boxes hold the ids of their stations, <aucun> has none
+    const Station *getSelectedStation(const QComboBox *comboBox) const;
+    void selectStation(QComboBox *comboBox, QVariant stationId);
 
-    template<typename AttributeGetter>
-    void repopulateFilterMap(QMap<std::string, bool> &filterMap, AttributeGetter getter);
+    void cancelLoading();
+    void finishLoading(const std::shared_ptr<ParseRuntime> &runtime, GeoMap &geoMap, const QString &error);
 
 public slots:
     void openFileDialog();
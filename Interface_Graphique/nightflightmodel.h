@@ -69,8 +69,8 @@ public:
         endResetModel();
     }
 
-    bool isAccessibleAtNight(const Station &station) {
-        return m_statuses[station.getNightVFR()];
+    bool isAccessibleAtNight(const std::string &nightVFR) const {
+        return m_statuses.value(nightVFR, false);
     }
 
     QMap<std::string, bool> &getStatuses() { return m_statuses; }
@@ -1,16 +1,22 @@
 #ifndef STATIONMODEL_H
 #define STATIONMODEL_H
 
+#include <vector>
+
 #include "QtCore/qabstractitemmodel.h"
 #include "Solver/src/station.h"
+#include "Solver/src/stationattributes.h"
+#include "Solver/src/stationindex.h"
 
 class StationModel : public QAbstractTableModel
 {
-    QList<Station> m_stations;
+    std::vector<Station> m_stations;
+    StationAttributes m_attributes; // kept in sync with the stations, see setData
+    StationIndex m_index;
 public:
     StationModel(QObject * parent = {}) : QAbstractTableModel{parent} {}
 
-    int rowCount(const QModelIndex &parent = QModelIndex()) const override { return m_stations.count(); }
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override { return (int)m_stations.size(); }
 
     int columnCount(const QModelIndex &parent = QModelIndex()) const override { return 8; }
 
@@ -74,7 +80,12 @@ public:
             return true;
         } else if (role == Qt::EditRole && index.isValid()) {
             switch (index.column()) {
-            case 1: m_stations[index.row()].setOACI(value.toString().toStdString()); break;
+            case 1: {
+                std::string previousOACI = m_stations[index.row()].getOACI();
+                m_stations[index.row()].setOACI(value.toString().toStdString());
+                m_index.updateOACI(m_stations, index.row(), previousOACI);
+                break;
+            }
             case 2: m_stations[index.row()].setName(value.toString().toStdString()); break;
             case 3: return false;
             case 4: return false;
@@ -83,6 +94,7 @@ public:
             case 7: m_stations[index.row()].setFuel(value.toString().toStdString()); break;
             default: return false;
             }
+            m_attributes.update(index.row(), m_stations[index.row()]);
             emit dataChanged(index, index, {role});
             return true;
         }
@@ -91,18 +103,34 @@ public:
     }
 
     void append(const Station &station) {
-        beginInsertRows({}, m_stations.count(), m_stations.count());
-        m_stations.append(station);
+        beginInsertRows({}, (int)m_stations.size(), (int)m_stations.size());
+        m_stations.push_back(station);
+        if (station.getId() == Station::NO_ID)
+            m_stations.back().setId(Station::reserveIds(1));
+        m_attributes.append(station);
+        m_index.append(m_stations, m_stations.size() - 1);
         endInsertRows();
     }
 
-    void setStations(const QList<Station> &stations) {
+    // the stations are moved into the model, parsed maps are not copied
+    void setStations(std::vector<Station> &&stations) {
         beginResetModel();
-        m_stations = stations;
+        m_stations = std::move(stations);
+        m_attributes.assign(m_stations);
+        m_index.assign(m_stations);
         endResetModel();
     }
 
-    QList<Station> &getStations() { return m_stations; }
+    // the stations can be modified through this reference, but not their attributes nor their count
+    std::vector<Station> &getStations() { return m_stations; }
+    const StationAttributes &getAttributes() const { return m_attributes; }
+
+    // null if no station has the id or the code
+    const Station *findStation(stationid_t id) const {
+        size_t position = m_index.findPosition(id);
+        return position == (size_t)-1 ? nullptr : &m_stations[position];
+    }
+    const Station *findStationByOACI(const std::string &OACI) const { return findStation(m_index.findByOACI(OACI)); }
 };
 
 #endif // STATIONMODEL_H
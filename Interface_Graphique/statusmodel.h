@@ -69,8 +69,8 @@ public:
         endResetModel();
     }
 
-    bool isExcluded(const Station &station) {
-        return !m_statuses[station.getStatus()];
+    bool isExcluded(const std::string &status) const {
+        return !m_statuses.value(status, false);
     }
 
     QMap<std::string, bool> &getStatuses() { return m_statuses; }
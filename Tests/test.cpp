@@ -2,10 +2,26 @@
 
 #include <random>
 #include <array>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <fstream>
 
 #include "../Solver/src/geomap.h"
 #include "../Solver/src/geometry.h"
+#include "../Solver/src/spatialindex.h"
+#include "../Solver/src/distancepolicy.h"
+#include "../Solver/src/artifactcache.h"
+#include "../Solver/src/candidateset.h"
+#include "../Solver/src/dynamicbitset.h"
+#include "../Solver/src/geoserializer/binaryserializer.h"
+#include "../Solver/src/geoserializer/csvserializer.h"
+#include "../Solver/src/geoserializer/xlsserializer.h"
 #include "../Solver/src/tsp/genetictsp.h"
+#include "../Solver/src/tsp/tsp_nearest_multistart_opt.h"
 #include "../Solver/src/breitling/breitlingSolver.h"
 
 TEST(TestLocationCase, TestConstructors)
@@ -260,4 +276,595 @@ TEST(TestBreitling, TestLarge)
         EXPECT_TRUE(breitling_constraints::satisfiesStationCountConstraints(path));
         EXPECT_TRUE(breitling_constraints::satisfiesTimeConstraints(dataset, path));
     }
-}
\ No newline at end of file
+}
+
+// distance() is not exact for points a few meters apart, and depends on whether it was compiled with FMA
+static constexpr nauticmiles_t DISTANCE_TOLERANCE = 1e-3;
+
+// random points over France, some of them duplicated to exercise the tie breaks
+static std::vector<geometry::UnitVector> genRandomPoints(size_t count, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> lon(-5, 9), lat(41, 51);
+    std::vector<geometry::UnitVector> points;
+    for (size_t i = 0; i < count; i++)
+        points.push_back(geometry::toUnitVector(Location{ lon(generator), lat(generator) }));
+    for (size_t i = 0; i < count / 10; i++)
+        points[count - 1 - i] = points[i * 3];
+    return points;
+}
+
+// the points sorted by increasing distance to point then by index, as the index reports them. Sorted
+// by chord length like the index does, see DISTANCE_TOLERANCE
+static std::vector<SpatialIndex::Neighbour> bruteForceNearest(const std::vector<geometry::UnitVector> &points, const geometry::UnitVector &point)
+{
+    std::vector<std::pair<double, size_t>> chords;
+    for (size_t i = 0; i < points.size(); i++) {
+        double dx = point.x - points[i].x, dy = point.y - points[i].y, dz = point.z - points[i].z;
+        chords.push_back({ dx * dx + dy * dy + dz * dz, i });
+    }
+    std::sort(chords.begin(), chords.end());
+    std::vector<SpatialIndex::Neighbour> neighbours;
+    for (const auto &[chord, i] : chords)
+        neighbours.push_back({ i, geometry::distance(point, points[i]) });
+    return neighbours;
+}
+
+TEST(TestSpatialIndex, TestNearest)
+{
+    std::vector<geometry::UnitVector> points = genRandomPoints(500, 1);
+    std::vector<geometry::UnitVector> queries = genRandomPoints(50, 2);
+    queries.insert(queries.end(), points.begin(), points.begin() + 50);
+    SpatialIndex index{ points };
+    ASSERT_EQ(index.size(), points.size());
+
+    for (const geometry::UnitVector &query : queries) {
+        std::vector<SpatialIndex::Neighbour> expected = bruteForceNearest(points, query);
+        for (size_t k : { 1, 7, 40 }) {
+            std::vector<SpatialIndex::Neighbour> found = index.nearest(query, k);
+            ASSERT_EQ(found.size(), k);
+            for (size_t i = 0; i < k; i++) {
+                EXPECT_EQ(found[i].index, expected[i].index);
+                EXPECT_NEAR(found[i].distance, expected[i].distance, DISTANCE_TOLERANCE);
+            }
+        }
+    }
+
+    EXPECT_EQ(index.nearest(queries[0], points.size() + 10).size(), points.size());
+    EXPECT_TRUE(SpatialIndex{}.nearest(queries[0], 3).empty());
+}
+
+TEST(TestSpatialIndex, TestWithinRadius)
+{
+    std::vector<geometry::UnitVector> points = genRandomPoints(500, 3);
+    std::vector<geometry::UnitVector> queries = genRandomPoints(50, 4);
+    SpatialIndex index{ points };
+    std::vector<SpatialIndex::Neighbour> found;
+
+    for (const geometry::UnitVector &query : queries) {
+        for (nauticmiles_t radius : { 0., 10., 60., 200., 10000. }) {
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < points.size(); i++) {
+                if (geometry::distance(query, points[i]) < radius)
+                    expected.push_back(i);
+            }
+
+            index.withinRadius(query, radius, found);
+            std::vector<size_t> foundIndices;
+            for (const SpatialIndex::Neighbour &neighbour : found) {
+                foundIndices.push_back(neighbour.index);
+                EXPECT_NEAR(neighbour.distance, geometry::distance(query, points[neighbour.index]), DISTANCE_TOLERANCE);
+            }
+            std::sort(foundIndices.begin(), foundIndices.end());
+            EXPECT_EQ(foundIndices, expected);
+
+            // filtered while searching, the odd points only
+            index.withinRadius(query, radius, [](size_t i, nauticmiles_t) { return i % 2 == 1; }, found);
+            foundIndices.clear();
+            for (const SpatialIndex::Neighbour &neighbour : found)
+                foundIndices.push_back(neighbour.index);
+            std::sort(foundIndices.begin(), foundIndices.end());
+            std::erase_if(expected, [](size_t i) { return i % 2 == 0; });
+            EXPECT_EQ(foundIndices, expected);
+        }
+    }
+}
+
+TEST(TestSpatialIndex, TestNearestSatisfying)
+{
+    std::vector<geometry::UnitVector> points = genRandomPoints(500, 5);
+    std::vector<geometry::UnitVector> queries = genRandomPoints(50, 6);
+    queries.insert(queries.end(), points.begin(), points.begin() + 50);
+    SpatialIndex index{ points };
+    auto predicate = [](size_t i, nauticmiles_t) { return i % 7 == 3; };
+
+    for (const geometry::UnitVector &query : queries) {
+        std::vector<SpatialIndex::Neighbour> sorted = bruteForceNearest(points, query);
+        for (nauticmiles_t maxDistance : { 20., 100., std::numeric_limits<nauticmiles_t>::max() }) {
+            size_t expected = SpatialIndex::NO_POINT;
+            for (const SpatialIndex::Neighbour &neighbour : sorted) {
+                if (neighbour.distance < maxDistance && predicate(neighbour.index, neighbour.distance)) {
+                    expected = neighbour.index;
+                    break;
+                }
+            }
+
+            nauticmiles_t distance = -1;
+            size_t found = index.nearestSatisfying(query, predicate, maxDistance, &distance);
+            ASSERT_EQ(found, expected);
+            if (found != SpatialIndex::NO_POINT)
+                EXPECT_NEAR(distance, geometry::distance(query, points[found]), DISTANCE_TOLERANCE);
+            else
+                EXPECT_EQ(distance, -1); // untouched
+        }
+    }
+
+    EXPECT_EQ(index.nearestSatisfying(queries[0], [](size_t, nauticmiles_t) { return false; }), SpatialIndex::NO_POINT);
+}
+
+
+// stations over France, every fourth one with a twin a few meters away so that many distances are
+// closer to each other than a step of the quantized matrix
+static GeoMap genNearTwinsMap(size_t count, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> lon(-5, 9), lat(41, 51);
+    GeoMap map;
+    for (size_t i = 0; i < count; i++) {
+        Location location{ lon(generator), lat(generator) };
+        map.getStations().push_back(Station{ false, location, "", "", "", "", "" });
+        if (i % 4 == 0)
+            map.getStations().push_back(Station{ false, Location{ location.lon, location.lat + 1e-4 }, "", "", "", "", "" });
+    }
+    return map;
+}
+
+TEST(TestQuantizedDistanceMatrix, TestTieBreaks)
+{
+    // seen from the first point, the two next ones are 10.001nm and 10nm away, the nearest one last
+    const std::vector<geometry::UnitVector> points{
+        geometry::toUnitVector(Location{ 2, 46 }),
+        geometry::toUnitVector(Location{ 2, 46 - 10.001 / 60 }),
+        geometry::toUnitVector(Location{ 2, 46 + 10. / 60 }),
+        geometry::toUnitVector(Location{ 8, 50 }),
+    };
+    const QuantizedStationDistanceMatrix matrix = QuantizedStationDistanceMatrix::compute(points);
+
+    ASSERT_EQ(matrix(0, 1), matrix(0, 2)); // the tie
+    EXPECT_LT(matrix.exact(0, 2), matrix.exact(0, 1));
+    for (size_t i = 0; i < points.size(); i++) {
+        for (size_t j = 0; j < points.size(); j++) {
+            EXPECT_NEAR(matrix.exact(i, j), geometry::distance(points[i], points[j]), DISTANCE_TOLERANCE);
+            EXPECT_NEAR(nauticMilesBetween(matrix, i, j), matrix.exact(i, j), matrix.getStep() / 2 + DISTANCE_TOLERANCE);
+        }
+    }
+}
+
+TEST(TestQuantizedDistanceMatrix, TestSameNearestNeighbourPaths)
+{
+    // the nearest neighbours are the same once the ties are broken on the exact distances
+    GeoMap geoMap = genNearTwinsMap(150, 3);
+    ProblemMap map;
+    for (const Station &station : geoMap.getStations())
+        map.emplace_back(&station, true, true);
+
+    for (bool loop : { true, false }) {
+        SolverRuntime exactRuntime{}, quantizedRuntime{};
+        TspNearestMultistartOptSolver exactSolver{ 1, 0, loop, TspNearestMultistartOptSolver::NO_STATION, TspNearestMultistartOptSolver::NO_STATION, DistancePolicy::MATRIX };
+        TspNearestMultistartOptSolver quantizedSolver{ 1, 0, loop, TspNearestMultistartOptSolver::NO_STATION, TspNearestMultistartOptSolver::NO_STATION, DistancePolicy::QUANTIZED_MATRIX };
+        EXPECT_EQ(exactSolver.solveForPath(map, &exactRuntime), quantizedSolver.solveForPath(map, &quantizedRuntime));
+    }
+}
+
+TEST(TestCandidateSet, TestCandidates)
+{
+    const size_t nearestCount = 8;
+    const size_t quadrantCount = 2;
+    std::vector<geometry::UnitVector> points = genRandomPoints(300, 7);
+    CandidateSet candidateSet{ points, nearestCount, quadrantCount };
+    ASSERT_EQ(candidateSet.size(), points.size());
+
+    for (size_t i = 0; i < points.size(); i++) {
+        std::span<const uint32_t> candidates = candidateSet.candidates(i);
+        std::span<const nauticmiles_t> distances = candidateSet.distances(i);
+        ASSERT_EQ(candidates.size(), distances.size());
+        EXPECT_GE(candidates.size(), nearestCount);
+        EXPECT_LE(candidates.size(), nearestCount + 4 * quadrantCount);
+
+        for (size_t c = 0; c < candidates.size(); c++) {
+            EXPECT_NE(candidates[c], i); // never its own candidate
+            EXPECT_NEAR(distances[c], geometry::distance(points[i], points[candidates[c]]), DISTANCE_TOLERANCE);
+            if (c > 0) {
+                // sorted by distance then index, hence no duplicates either
+                EXPECT_TRUE(distances[c - 1] < distances[c] || (distances[c - 1] == distances[c] && candidates[c - 1] < candidates[c]));
+            }
+        }
+
+        // the nearest points are candidates
+        std::vector<SpatialIndex::Neighbour> sorted = bruteForceNearest(points, points[i]);
+        std::erase_if(sorted, [i](const SpatialIndex::Neighbour &neighbour) { return neighbour.index == i; });
+        for (size_t n = 0; n < nearestCount; n++)
+            EXPECT_NE(std::find(candidates.begin(), candidates.end(), sorted[n].index), candidates.end());
+    }
+}
+
+TEST(TestCandidateSet, TestIsolatedPoint)
+{
+    // a point far west of a cluster still gets the cluster as candidates, and the cluster gets it
+    std::vector<geometry::UnitVector> points = genRandomPoints(100, 8);
+    points.push_back(geometry::toUnitVector(Location{ -30, 46 }));
+    size_t isolated = points.size() - 1;
+    CandidateSet candidateSet{ points, 4, 1 };
+
+    EXPECT_GE(candidateSet.candidates(isolated).size(), 4);
+    bool isCandidate = false;
+    for (size_t i = 0; i < isolated; i++) {
+        std::span<const uint32_t> candidates = candidateSet.candidates(i);
+        isCandidate |= std::find(candidates.begin(), candidates.end(), isolated) != candidates.end();
+    }
+    EXPECT_TRUE(isCandidate); // as the nearest point to the west of the westmost points
+}
+
+// gives access to the coordinate conversions of the serializers
+struct CoordinateConversions : GeoSerializer {
+    using GeoSerializer::string2coordinate;
+    using GeoSerializer::coordinate2string;
+};
+
+TEST(TestCoordinates, TestValidStrings)
+{
+    EXPECT_DOUBLE_EQ(CoordinateConversions::string2coordinate("52:30.12N"), 52 + 30.12 / 60);
+    EXPECT_DOUBLE_EQ(CoordinateConversions::string2coordinate("002:15.5E"), 2 + 15.5 / 60);
+    EXPECT_DOUBLE_EQ(CoordinateConversions::string2coordinate("45:00.0S"), -45);
+    EXPECT_DOUBLE_EQ(CoordinateConversions::string2coordinate("123:4.5W"), -(123 + 4.5 / 60));
+    EXPECT_DOUBLE_EQ(CoordinateConversions::string2coordinate("001:30.000O"), -1.5); // ouest, as written in french files
+    EXPECT_DOUBLE_EQ(CoordinateConversions::string2coordinate("2:15.E"), 2.25);      // the decimals of the minutes are optional
+}
+
+TEST(TestCoordinates, TestInvalidStrings)
+{
+    for (const char *invalid : { "", "N", "52:30N", "52.30N", "1234:30.1N", "52:123.1N", ":30.1N", "52:.1N", "52:30.1", "52:30.1X",
+                                 "52:30.1n", "52:30.1NN", "-52:30.1N", "+52:30.1N", "52:30.1N ", " 52:30.1N", "52 :30.1N", "52:30.1.2N" }) {
+        EXPECT_THROW(CoordinateConversions::string2coordinate(invalid), std::invalid_argument) << invalid;
+    }
+
+    try {
+        CoordinateConversions::string2coordinate("52:30N");
+        FAIL();
+    } catch (const std::invalid_argument &e) {
+        EXPECT_STREQ(e.what(), "Invalid coordinate string (52:30N)");
+    }
+}
+
+TEST(TestCoordinates, TestWrittenStringsAreReadBack)
+{
+    for (double coordinate : { 0., 1.5, -1.5, 45.99999, -5.123456, 51.0000001, 179.9999, -179.9999 }) {
+        for (bool isLatitude : { true, false }) {
+            if (isLatitude && std::abs(coordinate) > 90)
+                continue;
+            // written to the thousandth of minute
+            EXPECT_NEAR(CoordinateConversions::string2coordinate(CoordinateConversions::coordinate2string(coordinate, isLatitude)), coordinate, .0005 / 60);
+        }
+    }
+}
+
+// stations with all the attributes the serializers must preserve
+static GeoMap genSerializableMap()
+{
+    GeoMap map;
+    std::mt19937 generator(9);
+    std::uniform_real_distribution<double> lon(-5, 9), lat(41, 51);
+    const char *statuses[] = { "Public", "Restreint", "Privé" };
+    const char *nightVFRs[] = { "oui", "non", "limité" };
+    const char *fuels[] = { "oui", "non", "100LL" };
+    for (int i = 0; i < 200; i++) {
+        map.getStations().push_back(Station{ i % 17 == 0, Location{ lon(generator), lat(generator) }, "Aérodrome " + std::to_string(i), "LF" + std::to_string(1000 + i),
+            statuses[i % 3], nightVFRs[i / 3 % 3], fuels[i / 9 % 3] });
+    }
+    return map;
+}
+
+static void expectSameStations(const GeoMap &expected, const GeoMap &actual, double tolerance)
+{
+    ASSERT_EQ(actual.getStations().size(), expected.getStations().size());
+    for (size_t i = 0; i < expected.getStations().size(); i++) {
+        const Station &s1 = expected.getStations()[i];
+        const Station &s2 = actual.getStations()[i];
+        EXPECT_EQ(s2.isExcluded(), s1.isExcluded());
+        EXPECT_EQ(s2.getName(), s1.getName());
+        EXPECT_EQ(s2.getOACI(), s1.getOACI());
+        EXPECT_EQ(s2.getStatus(), s1.getStatus());
+        EXPECT_EQ(s2.getNightVFR(), s1.getNightVFR());
+        EXPECT_EQ(s2.getFuel(), s1.getFuel());
+        EXPECT_NEAR(s2.getLocation().lat, s1.getLocation().lat, tolerance);
+        EXPECT_NEAR(s2.getLocation().lon, s1.getLocation().lon, tolerance);
+    }
+}
+
+// in degrees, the text formats write coordinates to the thousandth of minute, see GeoSerializer::coordinate2string
+static constexpr double TEXT_COORDINATE_TOLERANCE = .0005 / 60;
+
+static void expectRoundTrip(const GeoSerializer &serializer, const std::string &extension, double tolerance)
+{
+    std::filesystem::path file = std::filesystem::temp_directory_path() / ("flightpath_roundtrip" + extension);
+    GeoMap map = genSerializableMap();
+    serializer.writeMap(map, file);
+    expectSameStations(map, serializer.parseMap(file), tolerance);
+    // written over an existing file
+    serializer.writeMap(map, file);
+    expectSameStations(map, serializer.parseMap(file), tolerance);
+    std::filesystem::remove(file);
+}
+
+TEST(TestSerializers, TestBinaryRoundTrip)
+{
+    expectRoundTrip(BinarySerializer{}, ".fpdb", 0);
+}
+
+TEST(TestSerializers, TestCSVRoundTrip)
+{
+    expectRoundTrip(CSVSerializer{}, ".csv", TEXT_COORDINATE_TOLERANCE);
+}
+
+TEST(TestSerializers, TestXLSXRoundTrip)
+{
+    expectRoundTrip(XLSSerializer{}, ".xlsx", TEXT_COORDINATE_TOLERANCE);
+}
+
+TEST(TestSerializers, TestEmptyMap)
+{
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "flightpath_empty.fpdb";
+    BinarySerializer{}.writeMap(GeoMap{}, file);
+    EXPECT_TRUE(BinarySerializer{}.parseMap(file).getStations().empty());
+    std::filesystem::remove(file);
+}
+
+// the rows of a CSV map of about 4MB, large enough to be parsed in 3 chunks of at least 1MB.
+// rows[0] is the header (row 1 of the file), some rows are empty and some end with \r
+static std::vector<std::string> genLargeCSVRows()
+{
+    std::vector<std::string> rows{ "Exclure;code OACI;Nom;Lattitude;Longitude;Statut;VFR nuit;Essence" };
+    for (size_t i = 1; i < 80'000; i++) {
+        if (i % 1000 == 0)
+            rows.push_back("");
+        else
+            rows.push_back(";LF" + std::to_string(i) + ";Aérodrome " + std::to_string(i) + ";45:00.000N;002:30.000E;Public;oui;oui" + (i % 3 == 0 ? "\r" : ""));
+    }
+    return rows;
+}
+
+static std::filesystem::path writeCSVRows(const std::vector<std::string> &rows)
+{
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "flightpath_rows.csv";
+    std::ofstream stream{ file, std::ios::binary };
+    for (const std::string &row : rows)
+        stream << row << '\n';
+    return file;
+}
+
+// the message of the error thrown when parsing file with serializer, empty if none is thrown
+static std::string parseError(const CSVSerializer &serializer, const std::filesystem::path &file)
+{
+    try {
+        serializer.parseMap(file);
+    } catch (const std::runtime_error &e) {
+        return e.what();
+    }
+    return "";
+}
+
+TEST(TestCSVSerializer, TestChunksKeepTheFileOrder)
+{
+    std::filesystem::path file = writeCSVRows(genLargeCSVRows());
+    ASSERT_GT(std::filesystem::file_size(file), 3u << 20);
+
+    GeoMap singleChunk = CSVSerializer{ 1 }.parseMap(file);
+    GeoMap threeChunks = CSVSerializer{ 3 }.parseMap(file);
+    std::filesystem::remove(file);
+
+    ASSERT_EQ(singleChunk.getStations().size(), 80'000 - 1 - 79); // without the header and the empty rows
+    expectSameStations(singleChunk, threeChunks, 0);
+}
+
+TEST(TestCSVSerializer, TestErrorRowsAcrossChunks)
+{
+    // in the first, second and last chunks, then two errors of which the first one is reported
+    for (std::vector<size_t> invalidRows : std::vector<std::vector<size_t>>{ { 10 }, { 40'000 }, { 79'990 }, { 30'001, 70'001 } }) {
+        std::vector<std::string> rows = genLargeCSVRows();
+        for (size_t row : invalidRows)
+            rows[row - 1] = ";LF0;Invalide;45:00.000X;002:30.000E;Public;oui;oui";
+        std::filesystem::path file = writeCSVRows(rows);
+
+        for (unsigned int threadCount : { 1, 3 }) {
+            std::string error = parseError(CSVSerializer{ threadCount }, file);
+            EXPECT_NE(error.find("at row " + std::to_string(invalidRows[0]) + ": "), std::string::npos) << threadCount << " threads: " << error;
+        }
+        std::filesystem::remove(file);
+    }
+}
+
+// an artifact holding count values, counting how many times it is computed
+struct CountedArtifact {
+    std::vector<uint32_t> values;
+
+    static CountedArtifact compute(size_t count, int &computeCount)
+    {
+        computeCount++;
+        CountedArtifact artifact;
+        artifact.values.resize(count);
+        std::iota(artifact.values.begin(), artifact.values.end(), 0);
+        return artifact;
+    }
+
+    void writeArtifact(ArtifactWriter &writer) const { writer.write(values); }
+    static CountedArtifact readArtifact(ArtifactReader &reader) { return { reader.readVector<uint32_t>() }; }
+};
+
+// an empty directory for a cache, removed at the end of the test
+class TestArtifactCache : public ::testing::Test {
+protected:
+    std::filesystem::path m_directory = std::filesystem::temp_directory_path() / "flightpath_artifacts";
+    int m_computeCount = 0;
+
+    void SetUp() override { std::filesystem::remove_all(m_directory); }
+    void TearDown() override { std::filesystem::remove_all(m_directory); }
+
+    CountedArtifact get(const ArtifactCache *cache, std::string_view kind, uint64_t key, size_t count = 100)
+    {
+        return ArtifactCache::getOrCompute<CountedArtifact>(cache, kind, key, [&] { return CountedArtifact::compute(count, m_computeCount); });
+    }
+
+    // the file of an artifact of the given kind, empty if there is none
+    std::filesystem::path artifactFile(std::string_view kind) const
+    {
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(m_directory))
+            if (entry.path().filename().string().starts_with(std::string(kind) + "-"))
+                return entry.path();
+        return {};
+    }
+
+    // stores an artifact, modifies its file with corrupt, and checks that it is then computed again and replaced
+    template<class Corrupt>
+    void expectComputedAgainAfter(Corrupt &&corrupt)
+    {
+        ArtifactCache cache{ m_directory };
+        get(&cache, "values", 1);
+        std::filesystem::path file = artifactFile("values");
+        ASSERT_FALSE(file.empty());
+        corrupt(file);
+
+        m_computeCount = 0;
+        EXPECT_EQ(get(&cache, "values", 1).values.size(), 100);
+        EXPECT_EQ(m_computeCount, 1);
+        get(&cache, "values", 1);
+        EXPECT_EQ(m_computeCount, 1);
+        std::filesystem::remove(file);
+    }
+};
+
+TEST_F(TestArtifactCache, TestHitAndMiss)
+{
+    ArtifactCache cache{ m_directory };
+
+    EXPECT_EQ(get(&cache, "values", 1).values.size(), 100);
+    EXPECT_EQ(m_computeCount, 1);
+    CountedArtifact loaded = get(&cache, "values", 1);
+    EXPECT_EQ(m_computeCount, 1); // read back
+    EXPECT_EQ(loaded.values, CountedArtifact::compute(100, m_computeCount).values);
+
+    m_computeCount = 0;
+    get(&cache, "values", 2);  // other key
+    get(&cache, "other", 1);   // other kind
+    get(nullptr, "values", 1); // no cache
+    EXPECT_EQ(m_computeCount, 3);
+
+    // kept between runs
+    ArtifactCache reopened{ m_directory };
+    get(&reopened, "values", 2);
+    EXPECT_EQ(m_computeCount, 3);
+}
+
+TEST_F(TestArtifactCache, TestCorruption)
+{
+    auto overwrite = [](const std::filesystem::path &file, std::streamoff offset, const void *bytes, size_t size) {
+        std::fstream stream{ file, std::ios::in | std::ios::out | std::ios::binary };
+        stream.seekp(offset);
+        stream.write(static_cast<const char *>(bytes), size);
+    };
+
+    // the size of the payload's array exceeds the payload
+    expectComputedAgainAfter([&](const std::filesystem::path &file) { uint64_t count = 1'000'000; overwrite(file, ArtifactWriter::ALIGNMENT, &count, sizeof(count)); });
+    // not an artifact
+    expectComputedAgainAfter([&](const std::filesystem::path &file) { overwrite(file, 0, "XXXX", 4); });
+    // truncated, empty
+    expectComputedAgainAfter([](const std::filesystem::path &file) { std::filesystem::resize_file(file, std::filesystem::file_size(file) - ArtifactWriter::ALIGNMENT); });
+    expectComputedAgainAfter([](const std::filesystem::path &file) { std::filesystem::resize_file(file, 0); });
+}
+
+TEST_F(TestArtifactCache, TestEviction)
+{
+    // 100 values take 448 bytes, the header, the array size and the values each padded to 64 bytes
+    constexpr uintmax_t ARTIFACT_SIZE = 64 + 64 + 448;
+    ArtifactCache cache{ m_directory, ARTIFACT_SIZE * 5 / 2 };
+
+    get(&cache, "a", 1);
+    get(&cache, "b", 1);
+    ASSERT_EQ(std::filesystem::file_size(artifactFile("a")), ARTIFACT_SIZE);
+    // a was used before b, but a is loaded again and b becomes the least recently used
+    std::filesystem::last_write_time(artifactFile("a"), std::filesystem::file_time_type::clock::now() - std::chrono::seconds(20));
+    std::filesystem::last_write_time(artifactFile("b"), std::filesystem::file_time_type::clock::now() - std::chrono::seconds(10));
+    get(&cache, "a", 1);
+    ASSERT_EQ(m_computeCount, 2);
+
+    get(&cache, "c", 1);
+    EXPECT_FALSE(artifactFile("a").empty());
+    EXPECT_TRUE(artifactFile("b").empty());
+    EXPECT_FALSE(artifactFile("c").empty());
+
+    // an artifact larger than the cache is kept alone
+    get(&cache, "d", 1, 1000);
+    EXPECT_TRUE(artifactFile("a").empty());
+    EXPECT_TRUE(artifactFile("c").empty());
+    m_computeCount = 0;
+    get(&cache, "d", 1, 1000);
+    EXPECT_EQ(m_computeCount, 0);
+}
+
+TEST(TestDynamicBitSet, TestOperations)
+{
+    // sizes around the word and AVX2 vector boundaries
+    for (size_t size : { 0, 1, 63, 64, 65, 255, 256, 257, 1000 }) {
+        DynamicBitSet set1(size), set2(size), pushed;
+        std::vector<bool> expected1(size), expected2(size);
+        std::mt19937 generator((unsigned int)size);
+        for (size_t i = 0; i < size; i++) {
+            expected1[i] = generator() % 3 == 0;
+            expected2[i] = generator() % 2 == 0;
+            if (expected1[i]) set1.setSet(i);
+            if (expected2[i]) set2.setSet(i);
+            pushed.pushBack(expected1[i]);
+        }
+
+        ASSERT_EQ(set1.size(), size);
+        ASSERT_EQ(pushed.size(), size);
+        size_t count1 = 0;
+        bool contains = true;
+        for (size_t i = 0; i < size; i++) {
+            EXPECT_EQ(set1.isSet(i), expected1[i]);
+            EXPECT_EQ(pushed.isSet(i), expected1[i]);
+            count1 += expected1[i];
+            contains &= expected1[i] || !expected2[i];
+        }
+        EXPECT_EQ(set1.count(), count1);
+        EXPECT_EQ(set1.none(), count1 == 0);
+        EXPECT_EQ(set1.contains(set2), contains);
+        EXPECT_TRUE(set1.contains(pushed));
+
+        std::vector<size_t> visited;
+        set1.forEach([&visited](size_t i) { visited.push_back(i); });
+        ASSERT_EQ(visited.size(), count1);
+        EXPECT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+        for (size_t i : visited)
+            EXPECT_TRUE(expected1[i]);
+
+        DynamicBitSet united = set1, intersection = set1, difference = set1;
+        united |= set2;
+        intersection &= set2;
+        difference.andNot(set2);
+        for (size_t i = 0; i < size; i++) {
+            EXPECT_EQ(united.isSet(i), expected1[i] || expected2[i]);
+            EXPECT_EQ(intersection.isSet(i), expected1[i] && expected2[i]);
+            EXPECT_EQ(difference.isSet(i), expected1[i] && !expected2[i]);
+        }
+
+        set1.clear();
+        EXPECT_TRUE(set1.none());
+        EXPECT_EQ(set1.size(), size);
+        if (size > 0) {
+            set1.setSet(size - 1);
+            EXPECT_TRUE(set1.isSet(size - 1));
+            set1.resetSet(size - 1);
+            EXPECT_FALSE(set1.isSet(size - 1));
+        }
+    }
+}